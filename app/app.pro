@@ -17,21 +17,35 @@ SOURCES += \
     parallel.cc
 
 HEADERS += \
+    archive.h \
+    async_io.h \
     bit_reader.h \
     bit_writer.h \
     buffers.h \
     canonical_huffman_tree.h \
+    checksum.h \
+    chunker.h \
+    container.h \
     decoder_progress_dialog.h \
     decoder_wrapper.h \
+    dedup.h \
     encoder_progress_dialog.h \
     encoder_wrapper.h \
+    entropy.h \
+    executor.h \
+    frames.h \
+    hash.h \
     huffman_decoder.h \
     huffman_decoder_stack.h \
     huffman_encoder.h \
     huffman_encoder_stack.h \
+    huffman_header.h \
+    huffman_streams_decoder_stack.h \
+    huffman_streams_encoder_stack.h \
     huffman_tree_base.h \
     huffman_tree.h \
     huffman_tree_node.h \
+    incremental_decoder.h \
     lz77_boyer_moore_dictionary.h \
     lz77_data.h \
     lz77_decoder.h \
@@ -39,9 +53,19 @@ HEADERS += \
     lz77_naive_dictionary.h \
     lzss_decoder.h \
     lzss_encoder.h \
+    lzss_grouped_decoder.h \
+    lzss_grouped_encoder.h \
+    lzss_stream_decoder.h \
+    lzss_stream_encoder.h \
     mainwindow.h \
     parallel.h \
+    preset_dictionary.h \
+    sinks.h \
+    sources.h \
+    span.h \
     splitter.h \
+    streams.h \
+    topology.h \
     tree_node.h \
     utils.h \
     worker.h
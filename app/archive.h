@@ -0,0 +1,1162 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "async_io.h"
+#include "dedup.h"
+#include "executor.h"
+#include "frames.h"
+
+// The first and last bytes of the directory of an archive
+static constexpr char ARCHIVE_MAGIC[8] = {
+    'S', 'D', 'E', 'M', 'D', 'I', 'R', '1'};
+
+/**
+ * A file or directory of an archive.
+ */
+struct ArchiveMember {
+  // The path of the member: the path it was read from while it is archived,
+  // then its path relative to the directory it is extracted to
+  std::string path;
+  // The offset of its content in the sequence of the contents of every member
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // Its type and permissions, as in st_mode
+  uint32_t mode = 0;
+  // The time it was last modified, in seconds since the epoch
+  int64_t modified = 0;
+
+  bool directory() const { return S_ISDIR(mode); }
+  bool regular() const { return S_ISREG(mode); }
+};
+
+/**
+ * The central directory written at the end of an archive: its members in the
+ * order of their contents, and where the frame of each chunk begins, so that
+ * members are listed and extracted without decoding the whole archive.
+ *
+ * The contents of the members follow each other in the chunks of the
+ * container, every chunk but the last one chunk_size symbols long: small
+ * members share chunks and large ones span many.
+ *
+ * The directory begins with ARCHIVE_MAGIC, and the archive ends with the
+ * offset of the directory followed by ARCHIVE_MAGIC.
+ */
+struct ArchiveDirectory {
+  static constexpr size_t trailer_size =
+      sizeof(uint64_t) + sizeof(ARCHIVE_MAGIC);
+
+  uint64_t chunk_size = 0;
+  // The CRC-32C of the contents of every member, one after the other
+  uint32_t checksum = 0;
+  // The offset of the frame of each chunk in the archive, followed by the end
+  // of the last frame, i.e. the offset of the directory
+  std::vector<uint64_t> frames;
+  std::vector<ArchiveMember> members;
+
+  /**
+   * @return the number of chunks of the archive
+   */
+  size_t chunks() const { return frames.empty() ? 0 : frames.size() - 1; }
+
+  /**
+   * @return the size of the contents of every member, one after the other
+   */
+  uint64_t content_size() const {
+    return members.empty() ? 0 : members.back().offset + members.back().size;
+  }
+
+  /**
+   * Select members by path; a directory selects its entries too.
+   *
+   * @param names        the paths of the members to select
+   * @param[out] missing the names that select no member, if not null
+   * @return the members selected, in the order of their contents
+   */
+  std::vector<ArchiveMember> select(
+      const std::vector<std::string>& names,
+      std::vector<std::string>* missing = nullptr) const;
+
+  /**
+   * Write the directory and the trailer, at the end of the frames.
+   *
+   * @param output_stream the stream to write to
+   */
+  void write(std::ostream& output_stream) const;
+
+  /**
+   * Read the directory of an archive from its trailer.
+   *
+   * @param input_stream a stream over the whole archive, seekable
+   * @return whether or not the directory could be read
+   */
+  bool read(std::istream& input_stream);
+
+ private:
+  static void put(std::ostream& output_stream, uint64_t value) {
+    output_stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  static bool get(std::istream& input_stream, uint64_t& value) {
+    return bool(
+        input_stream.read(reinterpret_cast<char*>(&value), sizeof(value)));
+  }
+
+  static bool get_magic(std::istream& input_stream) {
+    char magic[sizeof(ARCHIVE_MAGIC)];
+    return input_stream.read(magic, sizeof(magic)) &&
+           std::equal(magic, magic + sizeof(magic), ARCHIVE_MAGIC);
+  }
+};
+
+inline void ArchiveDirectory::write(std::ostream& output_stream) const {
+  output_stream.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+  put(output_stream, chunk_size);
+  put(output_stream, checksum);
+  put(output_stream, frames.size());
+  for (uint64_t frame : frames) {
+    put(output_stream, frame);
+  }
+
+  put(output_stream, members.size());
+  for (const ArchiveMember& member : members) {
+    put(output_stream, member.path.size());
+    output_stream.write(member.path.data(), member.path.size());
+    put(output_stream, member.offset);
+    put(output_stream, member.size);
+    put(output_stream, member.mode);
+    put(output_stream, static_cast<uint64_t>(member.modified));
+  }
+
+  put(output_stream, frames.empty() ? 0 : frames.back());
+  output_stream.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+}
+
+inline bool ArchiveDirectory::read(std::istream& input_stream) {
+  uint64_t offset;
+
+  input_stream.seekg(0, std::ios_base::end);
+  uint64_t size = input_stream.tellg();
+
+  if (!input_stream || size < trailer_size ||
+      !input_stream.seekg(size - trailer_size) || !get(input_stream, offset) ||
+      !get_magic(input_stream) || offset > size - trailer_size ||
+      !input_stream.seekg(offset) || !get_magic(input_stream)) {
+    return false;
+  }
+
+  // Counts are checked against the size of the directory, so that corrupted
+  // ones are rejected before anything is allocated
+  uint64_t available = size - trailer_size - offset;
+  uint64_t count;
+  uint64_t directory_checksum;
+
+  if (!get(input_stream, chunk_size) ||
+      !get(input_stream, directory_checksum) ||
+      directory_checksum > UINT32_MAX || !get(input_stream, count) ||
+      count > available / sizeof(uint64_t)) {
+    return false;
+  }
+
+  checksum = static_cast<uint32_t>(directory_checksum);
+
+  frames.resize(count);
+  for (uint64_t& frame : frames) {
+    if (!get(input_stream, frame)) {
+      return false;
+    }
+  }
+
+  if (!get(input_stream, count) ||
+      count > available / (5 * sizeof(uint64_t))) {
+    return false;
+  }
+
+  members.resize(count);
+  for (ArchiveMember& member : members) {
+    uint64_t path_size;
+    uint64_t mode;
+    uint64_t modified;
+
+    if (!get(input_stream, path_size) || path_size > available) {
+      return false;
+    }
+
+    member.path.resize(path_size);
+    if (!input_stream.read(&member.path[0], path_size) ||
+        !get(input_stream, member.offset) || !get(input_stream, member.size) ||
+        !get(input_stream, mode) || !get(input_stream, modified)) {
+      return false;
+    }
+
+    member.mode = mode;
+    member.modified = static_cast<int64_t>(modified);
+  }
+
+  return !frames.empty() && frames.back() == offset;
+}
+
+/**
+ * The path a member is archived as: relative, without "." components, and
+ * with ".." components resolved, or dropped at the beginning.
+ *
+ * @param path the path the member is read from
+ * @return the path of the member in the archive, empty for the root
+ */
+inline std::string archive_path(const std::string& path) {
+  std::vector<std::string> components;
+  size_t begin = 0;
+
+  while (begin <= path.size()) {
+    size_t end = std::min(path.find('/', begin), path.size());
+    std::string component = path.substr(begin, end - begin);
+
+    if (component == "..") {
+      if (!components.empty()) {
+        components.pop_back();
+      }
+    } else if (!component.empty() && component != ".") {
+      components.push_back(component);
+    }
+
+    begin = end + 1;
+  }
+
+  std::string result;
+  for (const std::string& component : components) {
+    result += result.empty() ? component : "/" + component;
+  }
+
+  return result;
+}
+
+/**
+ * @param path the path of a member in an archive
+ * @return whether or not the member is extracted within the destination
+ *         directory, i.e. its path is relative and has no ".." component
+ */
+inline bool safe_archive_path(const std::string& path) {
+  return !path.empty() && path[0] != '/' && archive_path(path) == path;
+}
+
+inline std::vector<ArchiveMember> ArchiveDirectory::select(
+    const std::vector<std::string>& names,
+    std::vector<std::string>* missing) const {
+  std::set<std::string> wanted;
+  for (const std::string& name : names) {
+    wanted.insert(archive_path(name));
+  }
+
+  std::set<std::string> found;
+  std::vector<ArchiveMember> selected;
+
+  for (const ArchiveMember& member : members) {
+    // The member itself, or one of the directories it is in, up to the root
+    const std::string& path = member.path;
+    size_t end = path.size();
+
+    while (true) {
+      auto name = wanted.find(path.substr(0, end));
+      if (name != wanted.end()) {
+        found.insert(*name);
+        selected.push_back(member);
+        break;
+      }
+
+      if (end == 0) {
+        break;
+      }
+
+      size_t slash = path.rfind('/', end - 1);
+      end = slash == std::string::npos ? 0 : slash;
+    }
+  }
+
+  if (missing) {
+    missing->clear();
+    for (const std::string& name : names) {
+      if (!found.count(archive_path(name))) {
+        missing->push_back(name);
+      }
+    }
+  }
+
+  return selected;
+}
+
+/**
+ * Walks files and directory trees with a pool of threads: each directory is
+ * listed, and each of its entries examined, by a task of its own, so that
+ * trees of many small files are walked as fast as the file system answers
+ * rather than one call at a time.
+ *
+ * Regular files and directories are found; other entries (e.g. symbolic links
+ * or devices) are skipped.
+ */
+class DirectoryWalker {
+ public:
+  /**
+   * Construct a DirectoryWalker.
+   *
+   * @param threads the number of threads, 0 for default_threads()
+   */
+  explicit DirectoryWalker(size_t threads)
+      : _executor(threads ? threads : default_threads()) {}
+
+  /**
+   * Walk files and directory trees.
+   *
+   * @param paths the paths of the files and directories
+   * @return the members found, with the paths they are read from, sorted by
+   *         path: every directory comes before its entries
+   */
+  std::vector<ArchiveMember> walk(const std::vector<std::string>& paths);
+
+  /**
+   * @return the number of paths that could not be examined or listed
+   */
+  size_t unreadable() const { return _unreadable; }
+
+ private:
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  size_t _pending = 0;
+  size_t _unreadable = 0;
+  std::vector<ArchiveMember> _members;
+  // Destroyed first, once its tasks are done
+  WorkStealingExecutor _executor;
+
+  void submit(const std::string& path) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_pending;
+    }
+
+    _executor.submit([this, path] { visit(path); });
+  }
+
+  void visit(const std::string& path);
+};
+
+inline std::vector<ArchiveMember> DirectoryWalker::walk(
+    const std::vector<std::string>& paths) {
+  _members.clear();
+  _unreadable = 0;
+
+  for (const std::string& path : paths) {
+    submit(path);
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this] { return _pending == 0; });
+
+  std::sort(_members.begin(),
+            _members.end(),
+            [](const ArchiveMember& lhs, const ArchiveMember& rhs) {
+              return lhs.path < rhs.path;
+            });
+
+  // The same entry walked from overlapping paths is archived once
+  _members.erase(std::unique(_members.begin(),
+                             _members.end(),
+                             [](const ArchiveMember& lhs,
+                                const ArchiveMember& rhs) {
+                               return lhs.path == rhs.path;
+                             }),
+                 _members.end());
+
+  return std::move(_members);
+}
+
+inline void DirectoryWalker::visit(const std::string& path) {
+  struct stat status;
+  bool found = lstat(path.c_str(), &status) == 0;
+  bool listed = true;
+
+  if (found && (S_ISREG(status.st_mode) || S_ISDIR(status.st_mode))) {
+    ArchiveMember member;
+    member.path = path;
+    member.size = S_ISREG(status.st_mode) ? status.st_size : 0;
+    member.mode = status.st_mode;
+    member.modified = status.st_mtime;
+
+    if (S_ISDIR(status.st_mode)) {
+      DIR* directory = opendir(path.c_str());
+      listed = directory != nullptr;
+
+      while (directory) {
+        dirent* entry = readdir(directory);
+        if (!entry) {
+          closedir(directory);
+          break;
+        }
+
+        if (std::strcmp(entry->d_name, ".") != 0 &&
+            std::strcmp(entry->d_name, "..") != 0) {
+          submit(path.back() == '/' ? path + entry->d_name
+                                    : path + "/" + entry->d_name);
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _members.push_back(member);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!found || !listed) {
+    ++_unreadable;
+  }
+
+  if (--_pending == 0) {
+    _condition.notify_all();
+  }
+}
+
+/**
+ * A stream buffer over the contents of the members of an archive, one after
+ * the other, that records the offset and the size of each member as it reads
+ * it.
+ *
+ * Small files are read ahead in parallel by a pool of threads, so that the
+ * cost of opening and reading millions of them is spread over the cores;
+ * large files are read asynchronously (see AsyncReadBuffer). Members are read
+ * to their end, whatever their size when they were walked: members that
+ * cannot be read are given no content and a mode of 0.
+ */
+class MemberReadBuffer : public std::streambuf {
+ public:
+  // The largest files read ahead, and the number of members read ahead
+  static constexpr uint64_t read_ahead_size = 256 * 1024;
+  static constexpr size_t read_ahead_members = 256;
+
+  /**
+   * Construct a MemberReadBuffer.
+   *
+   * @param[in,out] members the members to read, whose offsets and sizes are
+   *                        updated as they are read
+   * @param threads         the number of threads reading ahead, 0 for
+   *                        default_threads()
+   */
+  MemberReadBuffer(std::vector<ArchiveMember>* members, size_t threads)
+      : _members(members),
+        _read_ahead(members->size()),
+        _block(ASYNC_BLOCK_SIZE),
+        _executor(threads ? threads : default_threads()) {}
+
+  /**
+   * @return the number of members that could not be read
+   */
+  size_t unreadable() const { return _unreadable; }
+
+ protected:
+  int_type underflow() override;
+  std::streamsize xsgetn(char_type* output, std::streamsize count) override;
+
+ private:
+  struct ReadAhead {
+    bool done = false;
+    bool failed = false;
+    std::vector<char> data;
+  };
+
+  std::vector<ArchiveMember>* _members;
+  std::vector<std::unique_ptr<ReadAhead>> _read_ahead;
+  // The member being read, valid once started
+  size_t _current = 0;
+  bool _started = false;
+  size_t _scheduled = 0;
+  uint64_t _offset = 0;
+  uint64_t _member_size = 0;
+  size_t _unreadable = 0;
+  AsyncReadBuffer _file;
+  bool _reading_file = false;
+  std::vector<char> _block;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  // Destroyed first, once its tasks are done
+  WorkStealingExecutor _executor;
+
+  // Finish the current member and start the next one: false at the end
+  bool next();
+
+  // Read ahead the small files among the next members
+  void schedule();
+
+  void fail(ArchiveMember& member) {
+    member.mode = 0;
+    ++_unreadable;
+  }
+};
+
+inline MemberReadBuffer::int_type MemberReadBuffer::underflow() {
+  while (gptr() == egptr()) {
+    if (_reading_file) {
+      std::streamsize size = _file.sgetn(_block.data(), _block.size());
+
+      if (size > 0) {
+        _member_size += size;
+        setg(_block.data(), _block.data(), _block.data() + size);
+        break;
+      }
+    }
+
+    if (!next()) {
+      return traits_type::eof();
+    }
+  }
+
+  return traits_type::to_int_type(*gptr());
+}
+
+inline std::streamsize MemberReadBuffer::xsgetn(char_type* output,
+                                               std::streamsize count) {
+  std::streamsize read = 0;
+
+  while (read < count) {
+    if (gptr() < egptr()) {
+      std::streamsize size = std::min<std::streamsize>(egptr() - gptr(),
+                                                       count - read);
+      std::memcpy(output + read, gptr(), size);
+      setg(eback(), gptr() + size, egptr());
+      read += size;
+      continue;
+    }
+
+    // Large files are read without copying them to the block
+    if (_reading_file) {
+      std::streamsize size = _file.sgetn(output + read, count - read);
+
+      if (size > 0) {
+        _member_size += size;
+        read += size;
+        continue;
+      }
+    }
+
+    if (!next()) {
+      break;
+    }
+  }
+
+  return read;
+}
+
+inline bool MemberReadBuffer::next() {
+  std::vector<ArchiveMember>& members = *_members;
+
+  if (_current >= members.size()) {
+    return false;
+  }
+
+  if (_started) {
+    members[_current].size = _member_size;
+    _offset += _member_size;
+    _read_ahead[_current].reset();
+
+    if (_reading_file) {
+      _file.close();
+      _reading_file = false;
+    }
+
+    ++_current;
+  }
+
+  _started = true;
+  if (_current >= members.size()) {
+    return false;
+  }
+
+  schedule();
+
+  ArchiveMember& member = members[_current];
+  member.offset = _offset;
+  _member_size = 0;
+  setg(nullptr, nullptr, nullptr);
+
+  if (!member.regular()) {
+    return true;
+  }
+
+  ReadAhead* read_ahead = _read_ahead[_current].get();
+
+  if (read_ahead) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [read_ahead] { return read_ahead->done; });
+
+    if (read_ahead->failed) {
+      fail(member);
+    } else if (!read_ahead->data.empty()) {
+      char* data = read_ahead->data.data();
+      _member_size = read_ahead->data.size();
+      setg(data, data, data + _member_size);
+    }
+
+    return true;
+  }
+
+  if (_file.open(member.path.c_str())) {
+    _reading_file = true;
+  } else {
+    fail(member);
+  }
+
+  return true;
+}
+
+inline void MemberReadBuffer::schedule() {
+  std::vector<ArchiveMember>& members = *_members;
+  size_t end = std::min(members.size(), _current + read_ahead_members);
+
+  for (_scheduled = std::max(_scheduled, _current); _scheduled < end;
+       ++_scheduled) {
+    const ArchiveMember& member = members[_scheduled];
+
+    if (!member.regular() || member.size > read_ahead_size) {
+      continue;
+    }
+
+    ReadAhead* read_ahead = new ReadAhead();
+    _read_ahead[_scheduled].reset(read_ahead);
+    std::string path = member.path;
+
+    _executor.submit([this, read_ahead, path] {
+      int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      bool failed = fd < 0;
+      std::vector<char> data;
+
+      // Read to the end, in case the file grew
+      while (!failed) {
+        size_t size = data.size();
+        data.resize(size + read_ahead_size);
+
+        ssize_t count = ::read(fd, data.data() + size, read_ahead_size);
+        failed = count < 0;
+        data.resize(size + std::max<ssize_t>(count, 0));
+
+        if (count <= 0) {
+          break;
+        }
+      }
+
+      if (fd >= 0) {
+        close(fd);
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      read_ahead->data.swap(data);
+      read_ahead->failed = failed;
+      read_ahead->done = true;
+      _condition.notify_all();
+    });
+  }
+}
+
+/**
+ * A sink that records where each frame written by EncoderFrames begins, and
+ * the checksum that ends it if the chunks are checksummed, for the directory
+ * of an archive, and passes the frames on to another sink.
+ *
+ * @tparam Sink the type of the other sink
+ */
+template <typename Sink>
+class FrameIndexSink {
+ public:
+  /**
+   * Construct a FrameIndexSink.
+   *
+   * @param sink   the sink the frames are written to
+   * @param offset the offset of the first frame
+   */
+  FrameIndexSink(Sink& sink, uint64_t offset) : _sink(sink), _offset(offset) {}
+
+  void write(const char* data, size_t size) {
+    _sink.write(data, size);
+
+    while (size) {
+      if (_header_size == 0) {
+        _frames.push_back(_offset);
+      }
+
+      size_t count;
+      if (_header_size < Frame<>::max_header_size) {
+        count = std::min(size, Frame<>::max_header_size - _header_size);
+        std::memcpy(_header + _header_size, data, count);
+        _header_size += count;
+
+        if (_header_size == Frame<>::max_header_size) {
+          std::memcpy(&_remaining, _header + 1, sizeof(_remaining));
+        }
+      } else {
+        count = std::min<uint64_t>(size, _remaining);
+
+        // The bytes among the last ones of the frame, kept for checksum()
+        size_t skipped = _remaining > sizeof(_trailer)
+                             ? std::min<size_t>(count,
+                                                _remaining - sizeof(_trailer))
+                             : 0;
+        if (skipped < count) {
+          std::memcpy(_trailer + sizeof(_trailer) - (_remaining - skipped),
+                      data + skipped,
+                      count - skipped);
+        }
+        _remaining -= count;
+      }
+
+      if (_header_size == Frame<>::max_header_size && !_remaining) {
+        uint32_t checksum;
+        std::memcpy(&checksum, _trailer, sizeof(checksum));
+        _checksums.push_back(checksum);
+        _header_size = 0;
+      }
+
+      data += count;
+      size -= count;
+      _offset += count;
+    }
+  }
+
+  /**
+   * @return the offsets of the frames, followed by the end of the last one
+   */
+  std::vector<uint64_t> frames() const {
+    std::vector<uint64_t> frames = _frames;
+    frames.push_back(_offset);
+    return frames;
+  }
+
+  /**
+   * @return the last 4 bytes of each frame: the checksums of the chunks, if
+   *         they are checksummed
+   */
+  const std::vector<uint32_t>& checksums() const { return _checksums; }
+
+ private:
+  Sink& _sink;
+  uint64_t _offset;
+  std::vector<uint64_t> _frames;
+  std::vector<uint32_t> _checksums;
+  char _header[Frame<>::max_header_size];
+  char _trailer[sizeof(uint32_t)] = {};
+  size_t _header_size = 0;
+  size_t _remaining = 0;
+};
+
+/**
+ * Give a member extracted to a path the time it was last modified.
+ */
+inline void set_member_modified(const std::string& path,
+                                const ArchiveMember& member) {
+  utimbuf times;
+  times.actime = member.modified;
+  times.modtime = member.modified;
+  utime(path.c_str(), &times);
+}
+
+/**
+ * Create the directories a member extracted under a destination is in.
+ *
+ * @param destination the directory the member is extracted to
+ * @param path        the path the member is extracted to
+ */
+inline void make_member_parents(const std::string& destination,
+                                const std::string& path) {
+  for (size_t i = destination.size() + 1; i < path.size(); ++i) {
+    if (path[i] == '/') {
+      mkdir(path.substr(0, i).c_str(), 0755);
+    }
+  }
+}
+
+/**
+ * Create a member under a destination directory, and the directories it is
+ * in. Directories are created writable until their entries are extracted.
+ *
+ * @param destination the directory the member is extracted to
+ * @param member      the member, whose path is safe (see safe_archive_path())
+ * @param[out] fd     the file descriptor of a regular file, opened for
+ *                    writing, or -1
+ * @return whether or not the member was created
+ */
+inline bool create_member(const std::string& destination,
+                          const ArchiveMember& member,
+                          int* fd) {
+  std::string path = destination + "/" + member.path;
+  make_member_parents(destination, path);
+  *fd = -1;
+
+  if (member.directory()) {
+    return mkdir(path.c_str(), 0700) == 0 || errno == EEXIST;
+  }
+
+  *fd = open(path.c_str(),
+             O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+             member.mode & 07777);
+  return *fd >= 0;
+}
+
+/**
+ * A sink that writes the contents of the members of an archive, one after the
+ * other, to their files under a destination directory, creating the
+ * directories they are in.
+ *
+ * Members whose path is not safe (see safe_archive_path()) are skipped and
+ * make close() fail.
+ */
+class MemberSink {
+ public:
+  /**
+   * Construct a MemberSink.
+   *
+   * @param members     the members whose contents are written, in order,
+   *                    with no gap between them
+   * @param destination the directory the members are extracted to
+   */
+  MemberSink(const std::vector<ArchiveMember>& members,
+             const std::string& destination)
+      : _members(members), _destination(destination) {
+    start();
+  }
+
+  ~MemberSink() { close(); }
+
+  MemberSink(const MemberSink&) = delete;
+  MemberSink& operator=(const MemberSink&) = delete;
+
+  void write(const char* data, size_t size) {
+    while (size && _current < _members.size()) {
+      size_t count = std::min<uint64_t>(size, _remaining);
+
+      if (_fd >= 0 && ::write(_fd, data, count) != ssize_t(count)) {
+        _failed = true;
+      }
+
+      data += count;
+      size -= count;
+      _remaining -= count;
+
+      if (!_remaining) {
+        finish();
+        ++_current;
+        start();
+      }
+    }
+  }
+
+  /**
+   * Finish the members, giving the directories their modes once their
+   * entries are written.
+   *
+   * @return whether or not every member was extracted
+   */
+  bool close() {
+    if (_current < _members.size()) {
+      _failed = true;
+      finish();
+      _current = _members.size();
+    }
+
+    for (auto i = _directories.rbegin(); i != _directories.rend(); ++i) {
+      const ArchiveMember& member = _members[*i];
+      std::string path = _destination + "/" + member.path;
+      chmod(path.c_str(), member.mode & 07777);
+      set_member_modified(path, member);
+    }
+
+    _directories.clear();
+    return !_failed;
+  }
+
+ private:
+  const std::vector<ArchiveMember>& _members;
+  std::string _destination;
+  size_t _current = 0;
+  uint64_t _remaining = 0;
+  int _fd = -1;
+  bool _failed = false;
+  std::vector<size_t> _directories;
+
+  // Start the members from the current one, up to one with content
+  void start() {
+    for (; _current < _members.size(); ++_current) {
+      const ArchiveMember& member = _members[_current];
+      bool safe = safe_archive_path(member.path);
+
+      _remaining = member.size;
+      _fd = -1;
+
+      if (!safe || !create_member(_destination, member, &_fd)) {
+        _failed = true;
+      }
+
+      if (safe && member.directory()) {
+        _directories.push_back(_current);
+      }
+
+      if (_remaining) {
+        return;
+      }
+
+      finish();
+    }
+  }
+
+  void finish() {
+    if (_fd < 0) {
+      return;
+    }
+
+    const ArchiveMember& member = _members[_current];
+    std::string path = _destination + "/" + member.path;
+
+    fchmod(_fd, member.mode & 07777);
+    if (::close(_fd) != 0) {
+      _failed = true;
+    }
+
+    _fd = -1;
+    set_member_modified(path, member);
+  }
+};
+
+/**
+ * A positioned sink that writes the contents of some members of an archive to
+ * their files under a destination directory, at any offset and from any
+ * thread, so that the chunks holding them are decoded in any order (see
+ * MemberSink for the members of a whole archive, in order).
+ *
+ * The members are created, and their files truncated, on construction.
+ * Members whose path is not safe (see safe_archive_path()) are skipped and
+ * make close() fail.
+ */
+class PositionedMemberSink {
+ public:
+  /**
+   * Construct a PositionedMemberSink.
+   *
+   * @param members     the members whose contents are written, in the order
+   *                    of their contents (see ArchiveDirectory::select())
+   * @param destination the directory the members are extracted to
+   */
+  PositionedMemberSink(const std::vector<ArchiveMember>& members,
+                       const std::string& destination)
+      : _members(members),
+        _destination(destination),
+        _fds(members.size(), -1),
+        _failed(false) {
+    for (size_t i = 0; i < _members.size(); ++i) {
+      if (!safe_archive_path(_members[i].path) ||
+          !create_member(_destination, _members[i], &_fds[i])) {
+        _failed = true;
+      }
+    }
+  }
+
+  ~PositionedMemberSink() { close(); }
+
+  PositionedMemberSink(const PositionedMemberSink&) = delete;
+  PositionedMemberSink& operator=(const PositionedMemberSink&) = delete;
+
+  /**
+   * Write a part of the contents of the members, to the members it overlaps.
+   *
+   * @param offset the offset of the part in the contents of every member of
+   *               the archive (see ArchiveMember::offset)
+   * @param data   a pointer to the part
+   * @param size   the size of the part
+   */
+  void write_at(uint64_t offset, const char* data, size_t size) {
+    // The first member ending past the offset
+    auto member = std::upper_bound(
+        _members.begin(),
+        _members.end(),
+        offset,
+        [](uint64_t offset, const ArchiveMember& member) {
+          return offset < member.offset + member.size;
+        });
+
+    for (; member != _members.end() && member->offset < offset + size;
+         ++member) {
+      int fd = _fds[member - _members.begin()];
+      uint64_t begin = std::max(offset, member->offset);
+      uint64_t end = std::min(offset + size, member->offset + member->size);
+
+      while (fd >= 0 && begin < end) {
+        ssize_t written = pwrite(
+            fd, data + (begin - offset), end - begin, begin - member->offset);
+        if (written <= 0) {
+          _failed = true;
+          break;
+        }
+
+        begin += written;
+      }
+    }
+  }
+
+  /**
+   * Finish the members, giving the directories their modes once their
+   * entries are written.
+   *
+   * @return whether or not every member was extracted
+   */
+  bool close() {
+    for (size_t i = _members.size(); i-- > 0;) {
+      const ArchiveMember& member = _members[i];
+      std::string path = _destination + "/" + member.path;
+
+      if (_fds[i] >= 0) {
+        fchmod(_fds[i], member.mode & 07777);
+        if (::close(_fds[i]) != 0) {
+          _failed = true;
+        }
+
+        _fds[i] = -1;
+        set_member_modified(path, member);
+      } else if (member.directory() && safe_archive_path(member.path)) {
+        chmod(path.c_str(), member.mode & 07777);
+        set_member_modified(path, member);
+      }
+    }
+
+    _members.clear();
+    return !_failed;
+  }
+
+ private:
+  std::vector<ArchiveMember> _members;
+  std::string _destination;
+  std::vector<int> _fds;
+  std::atomic<bool> _failed;
+};
+
+/**
+ * Reads the frames of the chunks of an archive from any thread, and finds
+ * the chunks that deduplicated chunks refer to (see ChunkIndex), so that the
+ * chunks holding some members are decoded without the chunks before them.
+ */
+class ArchiveFrameReader {
+ public:
+  /**
+   * Construct an ArchiveFrameReader.
+   *
+   * @param archive   the path of the archive
+   * @param directory the directory of the archive
+   */
+  ArchiveFrameReader(const char* archive, const ArchiveDirectory& directory)
+      : _fd(open(archive, O_RDONLY | O_CLOEXEC)), _frames(directory.frames) {}
+
+  ~ArchiveFrameReader() {
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+  }
+
+  ArchiveFrameReader(const ArchiveFrameReader&) = delete;
+  ArchiveFrameReader& operator=(const ArchiveFrameReader&) = delete;
+
+  /**
+   * @return whether or not the archive could be opened
+   */
+  bool is_open() const { return _fd >= 0; }
+
+  /**
+   * Find the chunk whose frame holds the content of a chunk, following the
+   * references of deduplicated chunks.
+   *
+   * @param chunk the index of the chunk
+   * @return the index of the chunk holding its content, or the number of
+   *         chunks if the references are broken
+   */
+  size_t source(size_t chunk) const {
+    size_t chunks = _frames.size() - 1;
+    char header[Frame<>::max_header_size + sizeof(uint32_t)];
+
+    while (chunk < chunks) {
+      uint64_t size = _frames[chunk + 1] - _frames[chunk];
+      if (_frames[chunk + 1] < _frames[chunk] ||
+          !read_at(_frames[chunk],
+                   header,
+                   std::min<uint64_t>(size, sizeof(header)))) {
+        return chunks;
+      }
+
+      if (header[0] != FRAME_REFERENCE) {
+        return chunk;
+      }
+
+      // The distance, followed by the checksum of the chunk
+      uint32_t distance = 0;
+      if (size >= sizeof(header)) {
+        std::memcpy(
+            &distance, header + Frame<>::max_header_size, sizeof(distance));
+      }
+
+      if (!distance || distance > DEDUP_WINDOW || distance > chunk) {
+        return chunks;
+      }
+
+      chunk -= distance;
+    }
+
+    return chunks;
+  }
+
+  /**
+   * Read the frames of consecutive chunks.
+   *
+   * @param first      the index of the first chunk
+   * @param last       the index past the last chunk
+   * @param[out] frames the frames
+   * @return whether or not the frames could be read
+   */
+  bool read(size_t first, size_t last, std::vector<char>& frames) const {
+    if (first > last || last >= _frames.size() ||
+        _frames[last] < _frames[first]) {
+      return false;
+    }
+
+    frames.resize(_frames[last] - _frames[first]);
+    return read_at(_frames[first], frames.data(), frames.size());
+  }
+
+ private:
+  int _fd;
+  const std::vector<uint64_t>& _frames;
+
+  bool read_at(uint64_t offset, char* data, size_t size) const {
+    while (size) {
+      ssize_t count = pread(_fd, data, size, offset);
+      if (count <= 0) {
+        return false;
+      }
+
+      data += count;
+      size -= count;
+      offset += count;
+    }
+
+    return true;
+  }
+};
+
+#endif /* ARCHIVE_H */
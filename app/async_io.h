@@ -0,0 +1,874 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+// The size of the blocks files are read and written by
+static constexpr size_t ASYNC_BLOCK_SIZE = 1 << 20;
+
+// The number of blocks of a file buffer, i.e. of reads kept in flight
+static constexpr size_t ASYNC_BLOCKS = 8;
+
+// The number of vectored writes a file buffer keeps in flight
+static constexpr size_t ASYNC_WRITES = 2;
+
+/**
+ * An asynchronous I/O backend: vectored reads and writes at given offsets of
+ * files are submitted, then waited for in the order they complete.
+ */
+class AsyncIO {
+ public:
+  /**
+   * A completed request.
+   */
+  struct Completion {
+    // The tag the request was submitted with
+    uint64_t tag;
+    // The number of bytes transferred, or -errno
+    ssize_t result;
+  };
+
+  virtual ~AsyncIO() {}
+
+  /**
+   * Submit a vectored read or write.
+   *
+   * @param write  whether to write or to read
+   * @param fd     the file descriptor
+   * @param iov    the blocks, which must stay valid until the completion
+   * @param count  the number of blocks
+   * @param offset the offset of the first block in the file
+   * @param tag    the tag of the completion
+   * @return false if the request could not be submitted
+   */
+  virtual bool submit(bool write,
+                      int fd,
+                      const iovec* iov,
+                      int count,
+                      uint64_t offset,
+                      uint64_t tag) = 0;
+
+  /**
+   * Wait for a submitted request to complete.
+   *
+   * @param[out] completion the completed request
+   * @return false if waiting failed
+   */
+  virtual bool wait(Completion& completion) = 0;
+
+  /**
+   * @return the name of the backend
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * Create the best backend available: io_uring if the kernel allows it, or
+   * else ThreadedIO.
+   *
+   * @param entries the maximum number of requests in flight
+   */
+  static std::unique_ptr<AsyncIO> create(unsigned entries = ASYNC_BLOCKS);
+};
+
+/**
+ * An AsyncIO backend whose requests are run by threads with preadv() and
+ * pwritev().
+ */
+class ThreadedIO : public AsyncIO {
+ public:
+  /**
+   * Construct a ThreadedIO.
+   *
+   * @param threads the number of threads running requests
+   */
+  explicit ThreadedIO(size_t threads = 2) {
+    for (size_t i = 0; i < threads; ++i) {
+      _threads.emplace_back(&ThreadedIO::run, this);
+    }
+  }
+
+  ~ThreadedIO() override {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+
+    _requested.notify_all();
+
+    for (auto& thread : _threads) {
+      thread.join();
+    }
+  }
+
+  bool submit(bool write,
+              int fd,
+              const iovec* iov,
+              int count,
+              uint64_t offset,
+              uint64_t tag) override {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _requests.push_back(Request{write, fd, iov, count, offset, tag});
+    }
+
+    _requested.notify_one();
+    return true;
+  }
+
+  bool wait(Completion& completion) override {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _completed.wait(lock, [&] { return !_completions.empty(); });
+
+    completion = _completions.front();
+    _completions.pop_front();
+    return true;
+  }
+
+  const char* name() const override { return "threads"; }
+
+ private:
+  struct Request {
+    bool write;
+    int fd;
+    const iovec* iov;
+    int count;
+    uint64_t offset;
+    uint64_t tag;
+  };
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _requested;
+  std::condition_variable _completed;
+  std::deque<Request> _requests;
+  std::deque<Completion> _completions;
+  bool _stopping = false;
+
+  void run() {
+    while (true) {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _requested.wait(lock,
+                        [&] { return !_requests.empty() || _stopping; });
+
+        if (_requests.empty()) {
+          return;
+        }
+
+        request = _requests.front();
+        _requests.pop_front();
+      }
+
+      ssize_t result =
+          request.write ? pwritev(request.fd,
+                                  request.iov,
+                                  request.count,
+                                  request.offset)
+                        : preadv(request.fd,
+                                 request.iov,
+                                 request.count,
+                                 request.offset);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _completions.push_back(
+            Completion{request.tag, result < 0 ? -errno : result});
+      }
+
+      _completed.notify_one();
+    }
+  }
+};
+
+#ifdef HAVE_IO_URING
+/**
+ * An AsyncIO backend on a Linux io_uring, set up with raw system calls: the
+ * submission and completion rings are shared with the kernel, so that a
+ * request costs a single system call and waiting for completions none while
+ * some are ready.
+ */
+class IoUringIO : public AsyncIO {
+ public:
+  /**
+   * Construct an IoUringIO; see ok() for whether the kernel allowed it.
+   *
+   * @param entries the maximum number of requests in flight
+   */
+  explicit IoUringIO(unsigned entries);
+
+  ~IoUringIO() override { release(); }
+
+  IoUringIO(const IoUringIO&) = delete;
+  IoUringIO& operator=(const IoUringIO&) = delete;
+
+  /**
+   * @return whether or not the ring was set up
+   */
+  bool ok() const { return _fd >= 0; }
+
+  bool submit(bool write,
+              int fd,
+              const iovec* iov,
+              int count,
+              uint64_t offset,
+              uint64_t tag) override;
+
+  bool wait(Completion& completion) override;
+
+  const char* name() const override { return "io_uring"; }
+
+ private:
+  int _fd = -1;
+
+  void* _sq_ring = MAP_FAILED;
+  size_t _sq_ring_size = 0;
+  void* _cq_ring = MAP_FAILED;
+  size_t _cq_ring_size = 0;
+  io_uring_sqe* _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t _sqes_size = 0;
+
+  unsigned* _sq_head = nullptr;
+  unsigned* _sq_tail = nullptr;
+  unsigned* _sq_mask = nullptr;
+  unsigned* _sq_array = nullptr;
+  unsigned* _cq_head = nullptr;
+  unsigned* _cq_tail = nullptr;
+  unsigned* _cq_mask = nullptr;
+  io_uring_cqe* _cqes = nullptr;
+
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(
+        __NR_io_uring_enter, _fd, to_submit, min_complete, flags, nullptr, 0);
+  }
+
+  void release();
+};
+
+inline IoUringIO::IoUringIO(unsigned entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+
+  _fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (_fd < 0) {
+    return;
+  }
+
+  _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  _cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // Both rings may share a single mapping
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+  }
+
+  _sq_ring = mmap(nullptr,
+                  _sq_ring_size,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE,
+                  _fd,
+                  IORING_OFF_SQ_RING);
+  _cq_ring = single_mmap ? _sq_ring
+                         : mmap(nullptr,
+                                _cq_ring_size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE,
+                                _fd,
+                                IORING_OFF_CQ_RING);
+
+  _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  _sqes = static_cast<io_uring_sqe*>(mmap(nullptr,
+                                          _sqes_size,
+                                          PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE,
+                                          _fd,
+                                          IORING_OFF_SQES));
+
+  if (_sq_ring == MAP_FAILED || _cq_ring == MAP_FAILED || _sqes == MAP_FAILED) {
+    release();
+    return;
+  }
+
+  char* sq = static_cast<char*>(_sq_ring);
+  _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  _sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+  char* cq = static_cast<char*>(_cq_ring);
+  _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+inline void IoUringIO::release() {
+  if (_sqes != MAP_FAILED) {
+    munmap(_sqes, _sqes_size);
+  }
+  if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring) {
+    munmap(_cq_ring, _cq_ring_size);
+  }
+  if (_sq_ring != MAP_FAILED) {
+    munmap(_sq_ring, _sq_ring_size);
+  }
+  if (_fd >= 0) {
+    close(_fd);
+  }
+
+  _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  _sq_ring = _cq_ring = MAP_FAILED;
+  _fd = -1;
+}
+
+inline bool IoUringIO::submit(bool write,
+                              int fd,
+                              const iovec* iov,
+                              int count,
+                              uint64_t offset,
+                              uint64_t tag) {
+  // Only this thread moves the tail, the kernel moves the head
+  unsigned tail = *_sq_tail;
+  unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+
+  if (tail - head > *_sq_mask) {
+    return false;
+  }
+
+  unsigned index = tail & *_sq_mask;
+  io_uring_sqe& sqe = _sqes[index];
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+  sqe.fd = fd;
+  sqe.addr = reinterpret_cast<uintptr_t>(iov);
+  sqe.len = count;
+  sqe.off = offset;
+  sqe.user_data = tag;
+
+  _sq_array[index] = index;
+  __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return enter(1, 0, 0) >= 0;
+}
+
+inline bool IoUringIO::wait(Completion& completion) {
+  while (true) {
+    unsigned head = *_cq_head;
+    unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+
+    if (head != tail) {
+      const io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+      completion.tag = cqe.user_data;
+      completion.result = cqe.res;
+      __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+      return true;
+    }
+
+    if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      return false;
+    }
+  }
+}
+#endif /* HAVE_IO_URING */
+
+inline std::unique_ptr<AsyncIO> AsyncIO::create(unsigned entries) {
+#ifdef HAVE_IO_URING
+  std::unique_ptr<IoUringIO> ring(new IoUringIO(entries));
+  if (ring->ok()) {
+    return std::unique_ptr<AsyncIO>(ring.release());
+  }
+#endif
+
+  return std::unique_ptr<AsyncIO>(new ThreadedIO());
+}
+
+/**
+ * A stream buffer that reads a file ahead of its consumer: every block of the
+ * buffer is a read in flight, and a block is submitted again as soon as it is
+ * consumed.
+ */
+class AsyncReadBuffer : public std::streambuf {
+ public:
+  /**
+   * Construct an AsyncReadBuffer.
+   *
+   * @param io         the backend, at least @c blocks entries deep
+   * @param block_size the size of each read
+   * @param blocks     the number of reads in flight
+   */
+  explicit AsyncReadBuffer(
+      std::unique_ptr<AsyncIO> io = AsyncIO::create(ASYNC_BLOCKS),
+      size_t block_size = ASYNC_BLOCK_SIZE,
+      size_t blocks = ASYNC_BLOCKS)
+      : _io(std::move(io)), _blocks(blocks) {
+    for (auto& block : _blocks) {
+      block.data.resize(block_size);
+      block.iov.iov_base = block.data.data();
+      block.iov.iov_len = block_size;
+    }
+  }
+
+  ~AsyncReadBuffer() override { close(); }
+
+  /**
+   * Open a file and start reading it.
+   *
+   * @param path the path of the file
+   * @return whether or not the file was opened
+   */
+  bool open(const char* path) {
+    close();
+
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (_fd < 0 || fstat(_fd, &status) != 0) {
+      close();
+      return false;
+    }
+
+    _file_size = status.st_size;
+    start(0);
+    return true;
+  }
+
+  /**
+   * Wait for the reads in flight, then close the file.
+   */
+  void close() {
+    drain();
+
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+
+    setg(nullptr, nullptr, nullptr);
+  }
+
+  /**
+   * @return the size of the file opened
+   */
+  uint64_t size() const { return _file_size; }
+
+ protected:
+  int_type underflow() override;
+  pos_type seekoff(off_type offset,
+                   std::ios_base::seekdir direction,
+                   std::ios_base::openmode) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode) override;
+
+ private:
+  struct Block {
+    std::vector<char> data;
+    iovec iov;
+    uint64_t offset = 0;
+    ssize_t size = 0;
+    bool pending = false;
+  };
+
+  std::unique_ptr<AsyncIO> _io;
+  std::vector<Block> _blocks;
+  int _fd = -1;
+  uint64_t _file_size = 0;
+  // The offset of the next block to submit
+  uint64_t _next_offset = 0;
+  // The block in the get area, or the next one to consume
+  size_t _current = 0;
+  bool _consuming = false;
+
+  void start(uint64_t offset);
+  void submit(Block& block);
+  bool complete();
+  void drain();
+};
+
+inline void AsyncReadBuffer::start(uint64_t offset) {
+  _next_offset = offset;
+  _current = 0;
+  _consuming = false;
+
+  for (auto& block : _blocks) {
+    submit(block);
+  }
+}
+
+inline void AsyncReadBuffer::submit(Block& block) {
+  block.offset = _next_offset;
+  block.size = 0;
+
+  if (_next_offset >= _file_size) {
+    return;
+  }
+
+  _next_offset += block.data.size();
+  block.pending = _io->submit(
+      false, _fd, &block.iov, 1, block.offset, &block - _blocks.data());
+
+  // Read synchronously if the backend is full
+  if (!block.pending) {
+    block.size = pread(_fd, block.data.data(), block.data.size(), block.offset);
+  }
+}
+
+inline bool AsyncReadBuffer::complete() {
+  AsyncIO::Completion completion;
+  if (!_io->wait(completion)) {
+    return false;
+  }
+
+  Block& block = _blocks[completion.tag];
+  block.pending = false;
+  block.size = completion.result;
+
+  // A short read before the end of the file is completed synchronously
+  while (block.size > 0 &&
+         static_cast<size_t>(block.size) < block.data.size() &&
+         block.offset + block.size < _file_size) {
+    ssize_t size = pread(_fd,
+                         block.data.data() + block.size,
+                         block.data.size() - block.size,
+                         block.offset + block.size);
+    if (size <= 0) {
+      break;
+    }
+
+    block.size += size;
+  }
+
+  return true;
+}
+
+inline void AsyncReadBuffer::drain() {
+  for (auto& block : _blocks) {
+    while (block.pending && complete()) {
+    }
+  }
+}
+
+inline AsyncReadBuffer::int_type AsyncReadBuffer::underflow() {
+  if (_fd < 0) {
+    return traits_type::eof();
+  }
+
+  // The consumed block reads further ahead
+  if (_consuming) {
+    submit(_blocks[_current]);
+    _current = (_current + 1) % _blocks.size();
+    _consuming = false;
+  }
+
+  Block& block = _blocks[_current];
+  while (block.pending && complete()) {
+  }
+
+  if (block.pending || block.size <= 0) {
+    setg(nullptr, nullptr, nullptr);
+    return traits_type::eof();
+  }
+
+  _consuming = true;
+  setg(block.data.data(), block.data.data(), block.data.data() + block.size);
+  return traits_type::to_int_type(*gptr());
+}
+
+inline AsyncReadBuffer::pos_type AsyncReadBuffer::seekoff(
+    off_type offset,
+    std::ios_base::seekdir direction,
+    std::ios_base::openmode) {
+  if (_fd < 0) {
+    return pos_type(off_type(-1));
+  }
+
+  Block& block = _blocks[_current];
+  off_type position = _consuming ? block.offset + (gptr() - eback())
+                                 : block.offset;
+
+  if (direction == std::ios_base::cur) {
+    if (offset == 0) {
+      return pos_type(position);
+    }
+
+    offset += position;
+  } else if (direction == std::ios_base::end) {
+    offset += _file_size;
+  }
+
+  return seekpos(pos_type(offset), std::ios_base::in);
+}
+
+inline AsyncReadBuffer::pos_type AsyncReadBuffer::seekpos(
+    pos_type position, std::ios_base::openmode) {
+  if (_fd < 0 || off_type(position) < 0) {
+    return pos_type(off_type(-1));
+  }
+
+  drain();
+  setg(nullptr, nullptr, nullptr);
+  start(off_type(position));
+  return position;
+}
+
+/**
+ * A stream buffer that writes a file behind its producer: full blocks are
+ * written asynchronously, and the blocks that fill up while the writes in
+ * flight complete are written together with a single vectored write.
+ */
+class AsyncWriteBuffer : public std::streambuf {
+ public:
+  /**
+   * Construct an AsyncWriteBuffer.
+   *
+   * @param io         the backend
+   * @param block_size the size of each block
+   * @param blocks     the number of blocks
+   */
+  explicit AsyncWriteBuffer(
+      std::unique_ptr<AsyncIO> io = AsyncIO::create(ASYNC_BLOCKS),
+      size_t block_size = ASYNC_BLOCK_SIZE,
+      size_t blocks = ASYNC_BLOCKS)
+      : _io(std::move(io)), _blocks(blocks), _iovecs(blocks), _writes(blocks) {
+    for (auto& block : _blocks) {
+      block.data.resize(block_size);
+    }
+  }
+
+  ~AsyncWriteBuffer() override { close(); }
+
+  /**
+   * Create or truncate a file to write to.
+   *
+   * @param path the path of the file
+   * @return whether or not the file was opened
+   */
+  bool open(const char* path) {
+    close();
+
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (_fd < 0) {
+      return false;
+    }
+
+    _failed = false;
+    _offset = 0;
+    _current = _first_pending = _pending = 0;
+    setp(_blocks[0].data.data(),
+         _blocks[0].data.data() + _blocks[0].data.size());
+    return true;
+  }
+
+  /**
+   * Write what is buffered, then close the file.
+   *
+   * @return whether or not everything was written
+   */
+  bool close() {
+    if (_fd < 0) {
+      return !_failed;
+    }
+
+    sync();
+    ::close(_fd);
+    _fd = -1;
+    setp(nullptr, nullptr);
+    return !_failed;
+  }
+
+  /**
+   * @return the number of bytes submitted for writing, the size of the file
+   *         once closed
+   */
+  uint64_t size() const { return _offset; }
+
+ protected:
+  int_type overflow(int_type symbol) override;
+  int sync() override;
+
+ private:
+  struct Block {
+    std::vector<char> data;
+    size_t size = 0;
+    bool free = true;
+  };
+
+  // A vectored write in flight, tagged with its first block
+  struct Write {
+    size_t blocks = 0;
+    size_t size = 0;
+    uint64_t offset = 0;
+  };
+
+  std::unique_ptr<AsyncIO> _io;
+  std::vector<Block> _blocks;
+  std::vector<iovec> _iovecs;
+  std::vector<Write> _writes;
+  int _fd = -1;
+  bool _failed = false;
+  // The offset of the next write
+  uint64_t _offset = 0;
+  // The block in the put area
+  size_t _current = 0;
+  // The full blocks not written yet, following the ones in flight
+  size_t _first_pending = 0;
+  size_t _pending = 0;
+  size_t _in_flight = 0;
+
+  void fill_current();
+  void submit_pending();
+  bool complete();
+};
+
+inline void AsyncWriteBuffer::fill_current() {
+  Block& block = _blocks[_current];
+  block.size = pptr() - pbase();
+  block.free = false;
+  ++_pending;
+}
+
+inline void AsyncWriteBuffer::submit_pending() {
+  while (_pending > 0) {
+    // A vectored write never wraps around the blocks
+    size_t count = std::min(_pending, _blocks.size() - _first_pending);
+    size_t size = 0;
+
+    for (size_t i = _first_pending; i < _first_pending + count; ++i) {
+      _iovecs[i].iov_base = _blocks[i].data.data();
+      _iovecs[i].iov_len = _blocks[i].size;
+      size += _blocks[i].size;
+    }
+
+    Write& write = _writes[_first_pending];
+    write.blocks = count;
+    write.size = size;
+    write.offset = _offset;
+
+    const iovec* iov = &_iovecs[_first_pending];
+    if (_io->submit(true, _fd, iov, count, _offset, _first_pending)) {
+      ++_in_flight;
+    } else {
+      // Write synchronously if the backend is full
+      ssize_t written = pwritev(_fd, iov, count, _offset);
+      _failed |= written != static_cast<ssize_t>(size);
+
+      for (size_t i = _first_pending; i < _first_pending + count; ++i) {
+        _blocks[i].free = true;
+      }
+    }
+
+    _offset += size;
+    _first_pending = (_first_pending + count) % _blocks.size();
+    _pending -= count;
+  }
+}
+
+inline bool AsyncWriteBuffer::complete() {
+  AsyncIO::Completion completion;
+  if (!_io->wait(completion)) {
+    _failed = true;
+    return false;
+  }
+
+  const Write& write = _writes[completion.tag];
+  size_t written = completion.result < 0 ? 0 : completion.result;
+  _failed |= completion.result < 0;
+
+  // A short write is completed synchronously
+  size_t position = 0;
+  for (size_t i = completion.tag; i < completion.tag + write.blocks; ++i) {
+    Block& block = _blocks[i];
+
+    if (!_failed && position + block.size > written) {
+      size_t skipped = written > position ? written - position : 0;
+      size_t size = block.size - skipped;
+      _failed |= pwrite(_fd,
+                        block.data.data() + skipped,
+                        size,
+                        write.offset + position + skipped) !=
+                 static_cast<ssize_t>(size);
+    }
+
+    position += block.size;
+    block.free = true;
+  }
+
+  --_in_flight;
+  return true;
+}
+
+inline AsyncWriteBuffer::int_type AsyncWriteBuffer::overflow(int_type symbol) {
+  if (_fd < 0 || _failed) {
+    return traits_type::eof();
+  }
+
+  fill_current();
+
+  // Full blocks wait while enough writes are in flight, then go together
+  if (_in_flight < ASYNC_WRITES) {
+    submit_pending();
+  }
+
+  _current = (_current + 1) % _blocks.size();
+  while (!_blocks[_current].free) {
+    if (_in_flight == 0) {
+      submit_pending();
+    } else if (complete() && _in_flight < ASYNC_WRITES) {
+      submit_pending();
+    }
+  }
+
+  Block& block = _blocks[_current];
+  setp(block.data.data(), block.data.data() + block.data.size());
+
+  if (!traits_type::eq_int_type(symbol, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(symbol);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(symbol);
+}
+
+inline int AsyncWriteBuffer::sync() {
+  if (_fd < 0) {
+    return -1;
+  }
+
+  if (pptr() > pbase()) {
+    fill_current();
+    _current = (_current + 1) % _blocks.size();
+  }
+
+  submit_pending();
+  while (_in_flight > 0 && complete()) {
+  }
+
+  Block& block = _blocks[_current];
+  setp(block.data.data(), block.data.data() + block.data.size());
+  return _failed ? -1 : 0;
+}
+
+#endif /* ASYNC_IO_H */
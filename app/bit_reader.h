@@ -1,12 +1,17 @@
 #ifndef BIT_READER_H
 #define BIT_READER_H
 
+#include <algorithm>
 #include <iterator>
 #include "utils.h"
 
 /**
  * A class responsible for bitwise input.
  *
+ * Reading past the end of the input yields zero bits rather than reading out
+ * of bounds, and is recorded (see overrun()): decoders check it once per token
+ * instead of before every bit.
+ *
  * @tparam InputIterator an input iterator type for reading a single
  *                       character
  */
@@ -23,7 +28,7 @@ class BitReader {
    */
   explicit BitReader(const InputIterator& begin,
                      const InputIterator& end = InputIterator())
-      : _begin(begin), _end(end), _buffer(0), _count(0) {}
+      : _begin(begin), _end(end), _buffer(0), _count(0), _overrun(false) {}
 
   /**
    * Construct a BitReader.
@@ -53,6 +58,14 @@ class BitReader {
   template <typename T>
   void read(T& value, bits_t bits);
 
+  /**
+   * Read a value written by BitWriter::write_varint().
+   *
+   * @param[out] value where the value is stored
+   * @return false if the value does not fit in 64 bits
+   */
+  bool read_varint(uint64_t& value);
+
   /**
    * Read a single bit and return it.
    *
@@ -70,6 +83,11 @@ class BitReader {
    */
   bool empty() const { return _count == 0; }
 
+  /**
+   * @return whether or not bits were read past the end of the input
+   */
+  bool overrun() const { return _overrun; }
+
   /**
    * @return the internal input iterator at its current position
    */
@@ -81,6 +99,19 @@ class BitReader {
 
   unsigned char _buffer;
   unsigned char _count;
+  bool _overrun;
+
+  // The next byte of the input, 0 past its end
+  unsigned char next_byte() {
+    if (_begin != _end) {
+      unsigned char byte = *_begin;
+      ++_begin;
+      return byte;
+    }
+
+    _overrun = true;
+    return 0;
+  }
 };
 
 template <typename InputIterator>
@@ -89,8 +120,7 @@ inline void BitReader<InputIterator>::read(T& value) {
   if (empty()) {
     value = 0;
     for (decltype(sizeof(T)) i = 0; i < sizeof(T); ++i) {
-      (reinterpret_cast<char*>(&value))[i] = *_begin;
-      ++_begin;
+      (reinterpret_cast<unsigned char*>(&value))[i] = next_byte();
     }
   } else {
     read(value, 8 * sizeof(T));
@@ -100,22 +130,46 @@ inline void BitReader<InputIterator>::read(T& value) {
 template <typename InputIterator>
 template <typename T>
 inline void BitReader<InputIterator>::read(T& value, bits_t bits) {
+  uint64_t bits_value = 0;
+
+  // Whole runs of buffered bits at a time, rather than bit by bit
+  while (bits) {
+    if (empty()) {
+      _buffer = next_byte();
+      _count = 8;
+    }
+
+    bits_t run = std::min<bits_t>(bits, _count);
+    bits_value = (bits_value << run) | (_buffer >> (8 - run));
+    _buffer = static_cast<unsigned char>(_buffer << run);
+    _count -= run;
+    bits -= run;
+  }
+
+  value = static_cast<T>(bits_value);
+}
+
+template <typename InputIterator>
+inline bool BitReader<InputIterator>::read_varint(uint64_t& value) {
   value = 0;
 
-  while (bits--) {
-    value <<= 1;
+  for (bits_t shift = 0; shift < 64 && *this; shift += 7) {
+    unsigned char byte;
+    read(byte, 8);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
 
-    if (read()) {
-      ++value;
+    if (!(byte & 0x80)) {
+      return true;
     }
   }
+
+  return false;
 }
 
 template <typename InputIterator>
 inline bool BitReader<InputIterator>::read() {
   if (empty()) {
-    _buffer = *_begin;
-    ++_begin;
+    _buffer = next_byte();
     _count = 7;
   } else {
     --_count;
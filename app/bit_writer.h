@@ -48,6 +48,14 @@ class BitWriter {
   template <typename T>
   void write(T value, bits_t bits);
 
+  /**
+   * Write @c value using as few bytes as possible: 7 bits per byte, the most
+   * significant bit telling whether more bytes follow.
+   *
+   * @param value the value to write
+   */
+  void write_varint(uint64_t value);
+
   /**
    * Write a sequence of bits.
    *
@@ -108,15 +116,40 @@ inline void BitWriter<OutputIterator>::write(T value) {
 template <typename OutputIterator>
 template <typename T>
 inline void BitWriter<OutputIterator>::write(T value, bits_t bits) {
-  static constexpr T mask = T(1) << (8 * sizeof(T) - 1);
-
-  value <<= 8 * sizeof(T) - bits;
+  // Shifted as unsigned, since shifting negative values is undefined
+  typedef typename std::conditional<std::is_signed<T>::value,
+                                    std::make_unsigned<T>,
+                                    std::common_type<T>>::type::type
+      unsigned_type;
+  // Promoted to at least unsigned int, so that shifting by 8 is defined
+  typedef typename std::common_type<unsigned_type, unsigned>::type wide_type;
+
+  wide_type bits_value = static_cast<unsigned_type>(value);
+
+  // Whole runs of bits at a time: those left in the buffer, then bytes
+  while (bits >= _count) {
+    bits -= _count;
+    _buffer = static_cast<unsigned char>(
+        (_buffer << _count) |
+        ((bits_value >> bits) & max_size(_count)));
+    write_buffer();
+  }
 
-  while (bits--) {
-    process(value & mask);
+  if (bits) {
+    _buffer = static_cast<unsigned char>((_buffer << bits) |
+                                         (bits_value & max_size(bits)));
+    _count -= bits;
+  }
+}
 
-    value <<= 1;
+template <typename OutputIterator>
+inline void BitWriter<OutputIterator>::write_varint(uint64_t value) {
+  while (value >= 0x80) {
+    write(static_cast<unsigned char>(value | 0x80), 8);
+    value >>= 7;
   }
+
+  write(static_cast<unsigned char>(value), 8);
 }
 
 template <typename OutputIterator>
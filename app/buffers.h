@@ -1,6 +1,8 @@
 #ifndef BUFFERS_H
 #define BUFFERS_H
 
+#include <cstddef>
+#include <iterator>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -9,7 +11,10 @@
 /**
  * A wrapper for a C-style array that implements a @c push_back() operation.
  *
- * This class is meant to be used with an @c std::back_inserter.
+ * This class is meant to be used with an @c std::back_inserter. No bounds
+ * checking is performed: the array must be large enough for the worst case
+ * (see the @c bound() member function of Workers), otherwise use a
+ * BoundedPushBackBuffer.
  *
  * @tparam T the type of the values contained in the array
  */
@@ -58,6 +63,114 @@ class PushBackBuffer {
   size_t _size;
 };
 
+/**
+ * A wrapper for a C-style array that implements a bounds-checked
+ * @c push_back() operation.
+ *
+ * Values that do not fit are discarded and the buffer is marked as overflowed.
+ *
+ * @tparam T the type of the values contained in the array
+ */
+template <typename T>
+class BoundedPushBackBuffer {
+ public:
+  typedef T value_type;
+
+  /**
+   * Construct a BoundedPushBackBuffer.
+   *
+   * @param[in,out] data     the raw buffer
+   * @param         capacity the number of elements the buffer can contain
+   */
+  BoundedPushBackBuffer(T* data, size_t capacity)
+      : _data(data), _size(0), _capacity(capacity), _overflow(false) {}
+
+  /**
+   * Append @c value to the end of the buffer, if there is room for it.
+   *
+   * @param[in] value the value of the element to append
+   */
+  void push_back(const T& value) {
+    if (_size < _capacity) {
+      _data[_size] = value;
+      ++_size;
+    } else {
+      _overflow = true;
+    }
+  }
+
+  /**
+   * @return the number of elements in the buffer
+   */
+  size_t size() const { return _size; }
+
+  /**
+   * @return whether or not some values did not fit in the buffer
+   */
+  bool overflow() const { return _overflow; }
+
+ private:
+  T* _data;
+  size_t _size;
+  size_t _capacity;
+  bool _overflow;
+};
+
+/**
+ * An input iterator adaptor that copies every symbol it moves past into a
+ * BoundedPushBackBuffer, so that a parser reading from a stream also loads
+ * what it reads into memory.
+ *
+ * @tparam InputIterator the type of the adapted iterator
+ * @tparam T             the type of the values contained in the buffer
+ */
+template <typename InputIterator, typename T>
+class CopyingIterator {
+ public:
+  typedef std::input_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const T* pointer;
+  typedef const T& reference;
+
+  /**
+   * Construct a CopyingIterator.
+   *
+   * @param iterator the iterator to adapt
+   * @param buffer   the buffer to copy symbols into, @c nullptr for the
+   *                 past-the-end iterator
+   */
+  explicit CopyingIterator(const InputIterator& iterator,
+                           BoundedPushBackBuffer<T>* buffer = nullptr)
+      : _iterator(iterator), _buffer(buffer) {}
+
+  T operator*() const { return *_iterator; }
+
+  CopyingIterator& operator++() {
+    if (_buffer) {
+      _buffer->push_back(*_iterator);
+    }
+
+    ++_iterator;
+    return *this;
+  }
+
+  bool operator==(const CopyingIterator& rhs) const {
+    return _iterator == rhs._iterator;
+  }
+
+  bool operator!=(const CopyingIterator& rhs) const { return !(*this == rhs); }
+
+  /**
+   * @return the adapted iterator at its current position
+   */
+  const InputIterator& base() const { return _iterator; }
+
+ private:
+  InputIterator _iterator;
+  BoundedPushBackBuffer<T>* _buffer;
+};
+
 /**
  * A thread-safe pool of C-style arrays.
  *
@@ -104,6 +217,17 @@ class BufferPool {
    */
   size_t buffer_size() const { return _size; }
 
+  /**
+   * @return the number of buffers in the pool
+   */
+  size_t count() const { return _count; }
+
+  /**
+   * @param buffer a buffer of the pool
+   * @return the index of @c buffer in the pool, from 0 to count() - 1
+   */
+  size_t index(const T* buffer) const { return (buffer - _data) / _size; }
+
  private:
   size_t _count;
   size_t _size;
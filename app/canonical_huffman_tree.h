@@ -28,6 +28,16 @@ class CanonicalHuffmanTree : public HuffmanTreeBase<T, W> {
   template <typename InputIterator>
   CanonicalHuffmanTree(InputIterator begin, InputIterator end);
 
+  /**
+   * Construct a CanonicalHuffmanTree from the code lengths of its symbols.
+   *
+   * @param code_lengths the code length of each symbol, indexed by the symbol
+   *                     converted to an unsigned value; 0 for symbols not in
+   *                     the tree
+   * @param size         the number of code lengths
+   */
+  CanonicalHuffmanTree(const unsigned char* code_lengths, size_t size);
+
   /**
    * Construct a CanonicalHuffmanTree.
    *
@@ -60,7 +70,8 @@ CanonicalHuffmanTree<T, W>::CanonicalHuffmanTree(InputIterator begin,
   size_t pairs;
   bit_reader.read(pairs);
 
-  while (pairs--) {
+  // The count of pairs is not trusted: reading stops at the end of the input
+  while (pairs-- && bit_reader) {
     symbol_type symbol;
     bit_reader.read(symbol);
 
@@ -94,6 +105,20 @@ CanonicalHuffmanTree<char>::CanonicalHuffmanTree(InputIterator begin,
   initialize(input_codebook.begin(), input_codebook.end());
 }
 
+template <typename T, typename W>
+CanonicalHuffmanTree<T, W>::CanonicalHuffmanTree(
+    const unsigned char* code_lengths, size_t size) {
+  input_codebook_type input_codebook;
+
+  for (size_t i = 0; i < size; ++i) {
+    if (code_lengths[i] > 0) {
+      input_codebook[static_cast<T>(i)] = code_lengths[i];
+    }
+  }
+
+  initialize(input_codebook.begin(), input_codebook.end());
+}
+
 template <typename T, typename W>
 template <typename HuffmanCodebook>
 CanonicalHuffmanTree<T, W>::CanonicalHuffmanTree(
@@ -115,10 +140,13 @@ template <typename T, typename W>
 template <typename InputIterator>
 void CanonicalHuffmanTree<T, W>::initialize(InputIterator begin,
                                             InputIterator end) {
-  // Sort the (non-canonical) codebook
+  // Sort the (non-canonical) codebook; codes longer than the bitset below
+  // only come from corrupted headers, and are left out of the tree
   std::vector<data_type> symbol_length_pairs;
   for (; begin != end; ++begin) {
-    symbol_length_pairs.emplace_back(begin->first, begin->second);
+    if (begin->second <= 32) {
+      symbol_length_pairs.emplace_back(begin->first, begin->second);
+    }
   }
 
   std::sort(symbol_length_pairs.begin(), symbol_length_pairs.end());
@@ -0,0 +1,173 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CHECKSUM_SSE42
+#endif
+
+/**
+ * CRC-32C (Castagnoli), as used by iSCSI, ext4 or Btrfs: computed by the
+ * crc32 instruction of SSE 4.2 where the processor has it, 8 bytes at a time,
+ * and with tables otherwise, giving the same checksum on every machine.
+ */
+class CRC32C {
+ public:
+  /**
+   * Extend the checksum of a block of memory with the block after it.
+   *
+   * @param crc  the checksum of the blocks before, 0 for none
+   * @param data a pointer to the block
+   * @param size the size of the block, in bytes
+   * @return the checksum of the blocks so far
+   */
+  static uint32_t extend(uint32_t crc, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+#ifdef CHECKSUM_SSE42
+    if (hardware()) {
+      return ~extend_hardware(~crc, bytes, size);
+    }
+#endif
+
+    return ~extend_software(~crc, bytes, size);
+  }
+
+  /**
+   * Combine the checksums of two blocks into the checksum of the second block
+   * appended to the first, without reading them (as zlib's crc32_combine()).
+   *
+   * @param first  the checksum of the first block
+   * @param second the checksum of the second block
+   * @param size   the size of the second block, in bytes
+   * @return the checksum of both blocks
+   */
+  static uint32_t combine(uint32_t first, uint32_t second, uint64_t size) {
+    // Shifting by 2^k zero bits is multiplying by x^(2^k) modulo the
+    // polynomial: the first checksum is shifted by 8 * size bits
+    uint32_t shifted = first;
+    uint32_t power = 0x00800000;  // x^8, reflected
+
+    for (; size; size >>= 1) {
+      if (size & 1) {
+        shifted = multiply(shifted, power);
+      }
+      power = multiply(power, power);
+    }
+
+    return shifted ^ second;
+  }
+
+  /**
+   * @return whether or not the checksums are computed with SSE 4.2
+   */
+  static bool hardware() {
+#ifdef CHECKSUM_SSE42
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return false;
+#endif
+  }
+
+ private:
+  // The polynomial, reflected
+  static constexpr uint32_t polynomial = 0x82f63b78;
+
+  // The product of two polynomials modulo the polynomial, reflected
+  static uint32_t multiply(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t bit = uint32_t(1) << 31; bit; bit >>= 1) {
+      if (a & bit) {
+        product ^= b;
+      }
+      b = (b >> 1) ^ (b & 1 ? polynomial : 0);
+    }
+    return product;
+  }
+
+  // The tables of slicing-by-8: table[k][b] is the CRC of byte b followed by
+  // k zero bytes
+  static const uint32_t (*tables())[256] {
+    struct Tables {
+      uint32_t values[8][256];
+
+      Tables() {
+        for (uint32_t b = 0; b < 256; ++b) {
+          uint32_t crc = b;
+          for (int i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ (crc & 1 ? polynomial : 0);
+          }
+          values[0][b] = crc;
+        }
+
+        for (uint32_t b = 0; b < 256; ++b) {
+          for (int k = 1; k < 8; ++k) {
+            uint32_t previous = values[k - 1][b];
+            values[k][b] = (previous >> 8) ^ values[0][previous & 0xff];
+          }
+        }
+      }
+    };
+
+    static const Tables tables;
+    return tables.values;
+  }
+
+  static uint32_t extend_software(uint32_t crc,
+                                  const unsigned char* bytes,
+                                  size_t size) {
+    const uint32_t(*table)[256] = tables();
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+      // Little-endian, whatever the machine
+      uint32_t low = crc ^ (uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 |
+                            uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24);
+      crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^
+            table[5][(low >> 16) & 0xff] ^ table[4][low >> 24] ^
+            table[3][bytes[4]] ^ table[2][bytes[5]] ^ table[1][bytes[6]] ^
+            table[0][bytes[7]];
+    }
+
+    for (; size; ++bytes, --size) {
+      crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xff];
+    }
+
+    return crc;
+  }
+
+#ifdef CHECKSUM_SSE42
+  __attribute__((target("sse4.2"))) static uint32_t extend_hardware(
+      uint32_t crc, const unsigned char* bytes, size_t size) {
+    uint64_t crc64 = crc;
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+      uint64_t word;
+      std::memcpy(&word, bytes, sizeof(word));
+      crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    crc = static_cast<uint32_t>(crc64);
+    for (; size; ++bytes, --size) {
+      crc = _mm_crc32_u8(crc, *bytes);
+    }
+
+    return crc;
+  }
+#endif
+};
+
+/**
+ * @param data a pointer to a block of memory
+ * @param size the size of the block, in bytes
+ * @return the CRC-32C of the block (see CRC32C)
+ */
+inline uint32_t crc32c(const void* data, size_t size) {
+  return CRC32C::extend(0, data, size);
+}
+
+#endif /* CHECKSUM_H */
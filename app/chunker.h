@@ -0,0 +1,128 @@
+#ifndef CHUNKER_H
+#define CHUNKER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Cuts a sequence into content-defined chunks with a Gear rolling hash, as in
+ * FastCDC: a chunk ends where the hash of its last 64 symbols has its top bits
+ * clear, so that inserting or removing symbols only moves the boundaries next
+ * to the change, and the chunks after it are the same as before.
+ *
+ * Chunks are at least min_size() symbols long, and at most max_size(). Past
+ * the minimum, boundaries are less likely before average_size() and more
+ * likely after it (normalized chunking), which keeps the sizes close to the
+ * average.
+ */
+class GearChunker {
+ public:
+  /**
+   * Construct a GearChunker.
+   *
+   * @param min_size     the minimum size of a chunk, except the last one
+   * @param average_size the size chunks are cut around
+   * @param max_size     the maximum size of a chunk
+   */
+  GearChunker(size_t min_size, size_t average_size, size_t max_size)
+      : _min_size(std::min(min_size, max_size)),
+        _average_size(std::min(std::max(average_size, _min_size), max_size)),
+        _max_size(max_size) {
+    // A boundary about every 2^bits symbols past the minimum
+    unsigned bits = 1;
+    while (bits < 48 && size_t(2) << bits <= _average_size - _min_size) {
+      ++bits;
+    }
+
+    _small_mask = top_bits(bits + 1);
+    _large_mask = top_bits(bits - 1);
+  }
+
+  /**
+   * The chunker of Splitter for a given chunk size: chunks of a quarter to
+   * the whole of that size, half of it on average.
+   *
+   * @param chunk_size the maximum size of a chunk
+   * @return the GearChunker
+   */
+  static GearChunker for_chunk_size(size_t chunk_size) {
+    return GearChunker(chunk_size / 4, chunk_size / 2, chunk_size);
+  }
+
+  size_t min_size() const { return _min_size; }
+  size_t average_size() const { return _average_size; }
+  size_t max_size() const { return _max_size; }
+
+  /**
+   * Find the end of the chunk at the beginning of a sequence.
+   *
+   * @param data a pointer to the symbols of the sequence
+   * @param size the number of symbols, that is the end of the last chunk
+   * @return the size of the first chunk, at most @c size
+   */
+  template <typename T>
+  size_t cut(const T* data, size_t size) const {
+    static_assert(sizeof(T) == 1, "Gear hashes bytes");
+
+    if (size <= _min_size) {
+      return size;
+    }
+
+    size_t end = std::min(size, _max_size);
+    size_t average = std::min(end, _average_size);
+    const uint64_t* gear = table();
+    uint64_t hash = 0;
+    size_t i = _min_size;
+
+    for (; i < average; ++i) {
+      hash = (hash << 1) + gear[static_cast<unsigned char>(data[i])];
+      if (!(hash & _small_mask)) {
+        return i + 1;
+      }
+    }
+
+    for (; i < end; ++i) {
+      hash = (hash << 1) + gear[static_cast<unsigned char>(data[i])];
+      if (!(hash & _large_mask)) {
+        return i + 1;
+      }
+    }
+
+    return end;
+  }
+
+ private:
+  size_t _min_size;
+  size_t _average_size;
+  size_t _max_size;
+  uint64_t _small_mask;
+  uint64_t _large_mask;
+
+  // The top bits depend on the last 64 symbols, the low ones on fewer
+  static uint64_t top_bits(unsigned bits) {
+    return bits ? ~uint64_t(0) << (64 - bits) : 0;
+  }
+
+  // A random value for each byte, the same on every machine (SplitMix64)
+  static const uint64_t* table() {
+    struct Table {
+      uint64_t values[256];
+
+      Table() {
+        uint64_t state = 0x6a09e667f3bcc908;
+        for (uint64_t& value : values) {
+          uint64_t z = (state += 0x9e3779b97f4a7c15);
+          z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+          z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+          value = z ^ (z >> 31);
+        }
+      }
+    };
+
+    static const Table gear;
+    return gear.values;
+  }
+};
+
+#endif /* CHUNKER_H */
@@ -0,0 +1,250 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+static constexpr unsigned char CONTAINER_VERSION = 4;
+
+// The version given to files written before the header was introduced
+static constexpr unsigned char CONTAINER_LEGACY_VERSION = 0;
+
+// The first version whose chunks are framed (see EncoderFrames)
+static constexpr unsigned char CONTAINER_FRAMES_VERSION = 2;
+
+// The first version whose Huffman tables are compact (see
+// CompactHuffmanHeader)
+static constexpr unsigned char CONTAINER_COMPACT_HUFFMAN_VERSION = 3;
+
+// The first version whose frames are all sized (see EncoderFrames)
+static constexpr unsigned char CONTAINER_SIZED_FRAMES_VERSION = 4;
+
+// The largest chunk size a container may declare, which bounds the memory its
+// decoding allocates
+static constexpr uint32_t CONTAINER_MAX_CHUNK_SIZE = 1 << 26;
+
+/**
+ * The flags describing how the chunks of a container were encoded.
+ */
+enum ContainerFlag {
+  // Chunks hold LZSS token streams (see LZSSStreamEncoder)
+  CONTAINER_TOKEN_STREAMS = 1 << 0,
+  // Chunks are primed with the end of the previous chunk (see Splitter)
+  CONTAINER_PRIMED = 1 << 1,
+  // Chunks are primed with a preset dictionary, whose id follows the flags
+  // (see PresetDictionary)
+  CONTAINER_DICTIONARY = 1 << 2,
+  // Chunks are not of the default size, which follows the flags and the
+  // dictionary id
+  CONTAINER_CHUNK_SIZE = 1 << 3,
+  // Chunks that repeat a recent chunk are written as references to it (see
+  // ChunkIndex)
+  CONTAINER_DEDUP = 1 << 4,
+  // The chunks hold the members of an archive, and are followed by its
+  // directory (see ArchiveDirectory)
+  CONTAINER_ARCHIVE = 1 << 5,
+  // Each frame ends with the CRC-32C of its chunk (see CRC32C)
+  CONTAINER_CHECKSUMS = 1 << 6,
+  // Chunks hold LZSS tokens whose flags are grouped in control bytes (see
+  // LZSSGroupedEncoder)
+  CONTAINER_GROUPED_FLAGS = 1 << 7
+};
+
+// The flags this version knows how to decode
+static constexpr unsigned char CONTAINER_KNOWN_FLAGS =
+    CONTAINER_TOKEN_STREAMS | CONTAINER_PRIMED | CONTAINER_DICTIONARY |
+    CONTAINER_CHUNK_SIZE | CONTAINER_DEDUP | CONTAINER_ARCHIVE |
+    CONTAINER_CHECKSUMS | CONTAINER_GROUPED_FLAGS;
+
+/**
+ * The header written at the beginning of the files produced by
+ * encode_in_parallel().
+ *
+ * Files written before the header was introduced start directly with a
+ * Huffman codebook, whose first code lengths can never spell the magic
+ * number: they are still decoded as plain LZSS chunks.
+ *
+ * Version 1 chunks are written as they come out of the pipeline; from version
+ * 2 on every chunk is a frame that never grows the input; from version 3 on
+ * Huffman tables are compact; from version 4 on complete frames are sized
+ * too.
+ */
+struct ContainerHeader {
+  // The maximum number of bytes written by write()
+  static constexpr size_t max_size = 4 + 2 + 2 * sizeof(uint32_t);
+
+  unsigned char version = CONTAINER_VERSION;
+  unsigned char flags = 0;
+  uint32_t dictionary_id = 0;
+  uint32_t chunk_size = 0;
+
+  /**
+   * @param flag a ContainerFlag
+   * @return whether or not @c flag is set
+   */
+  bool has(ContainerFlag flag) const { return flags & flag; }
+
+  /**
+   * @param flag a ContainerFlag to set
+   */
+  void set(ContainerFlag flag) { flags |= flag; }
+
+  /**
+   * @return whether or not this version of the container can be decoded
+   */
+  bool supported() const {
+    return version <= CONTAINER_VERSION &&
+           !(flags & ~CONTAINER_KNOWN_FLAGS) &&
+           (!has(CONTAINER_CHUNK_SIZE) ||
+            (chunk_size > 0 && chunk_size <= CONTAINER_MAX_CHUNK_SIZE)) &&
+           // Token streams already keep flags apart from the tokens
+           (!has(CONTAINER_GROUPED_FLAGS) ||
+            (sized_frames() && !has(CONTAINER_TOKEN_STREAMS)));
+  }
+
+  /**
+   * @return whether or not the chunks are framed (see EncoderFrames)
+   */
+  bool framed() const { return version >= CONTAINER_FRAMES_VERSION; }
+
+  /**
+   * @return whether or not Huffman tables are compact (see
+   *         CompactHuffmanHeader)
+   */
+  bool compact_huffman() const {
+    return version >= CONTAINER_COMPACT_HUFFMAN_VERSION;
+  }
+
+  /**
+   * @return whether or not every frame starts with its size (see
+   *         DecoderFrames)
+   */
+  bool sized_frames() const {
+    return version >= CONTAINER_SIZED_FRAMES_VERSION;
+  }
+
+  /**
+   * Write the header to memory.
+   *
+   * @param[out] output a pointer to at least @c max_size bytes
+   * @return a pointer to past-the-end of the written header
+   */
+  char* write(char* output) const {
+    output = std::copy(magic(), magic() + magic_size, output);
+    *output++ = version;
+    *output++ = flags;
+
+    if (has(CONTAINER_DICTIONARY)) {
+      std::memcpy(output, &dictionary_id, sizeof(dictionary_id));
+      output += sizeof(dictionary_id);
+    }
+
+    if (has(CONTAINER_CHUNK_SIZE)) {
+      std::memcpy(output, &chunk_size, sizeof(chunk_size));
+      output += sizeof(chunk_size);
+    }
+
+    return output;
+  }
+
+  /**
+   * Write the header to a stream.
+   *
+   * @param[out] output_stream the stream to write to
+   */
+  void write(std::ostream& output_stream) const {
+    char buffer[max_size];
+    output_stream.write(buffer, write(buffer) - buffer);
+  }
+
+  /**
+   * Read the header from memory; if the memory does not start with a header
+   * @c begin is left as it is and the header describes a legacy file.
+   *
+   * @param[out] begin a pointer to the beginning of the memory, moved
+   *                   past-the-end of the header
+   * @param      end   a pointer to past-the-end of the memory
+   * @return whether or not a header was found
+   */
+  bool read(const char*& begin, const char* end) {
+    size_t available = end - begin;
+
+    if (available >= magic_size + 2 &&
+        std::equal(begin, begin + magic_size, magic())) {
+      version = begin[magic_size];
+      flags = begin[magic_size + 1];
+      dictionary_id = 0;
+      chunk_size = 0;
+
+      size_t size = magic_size + 2;
+      if (has(CONTAINER_DICTIONARY) &&
+          available >= size + sizeof(dictionary_id)) {
+        std::memcpy(&dictionary_id, begin + size, sizeof(dictionary_id));
+        size += sizeof(dictionary_id);
+      }
+
+      if (has(CONTAINER_CHUNK_SIZE) &&
+          available >= size + sizeof(chunk_size)) {
+        std::memcpy(&chunk_size, begin + size, sizeof(chunk_size));
+        size += sizeof(chunk_size);
+      }
+
+      begin += size;
+      return true;
+    }
+
+    version = CONTAINER_LEGACY_VERSION;
+    flags = 0;
+    dictionary_id = 0;
+    chunk_size = 0;
+    return false;
+  }
+
+  /**
+   * Read the header from a stream; if the stream does not start with a header
+   * it is rewound and the header describes a legacy file.
+   *
+   * @param[out] input_stream the stream to read from
+   * @return whether or not a header was found
+   */
+  bool read(std::istream& input_stream) {
+    char buffer[magic_size];
+
+    if (input_stream.read(buffer, magic_size) &&
+        std::equal(buffer, buffer + magic_size, magic())) {
+      version = input_stream.get();
+      flags = input_stream.get();
+      dictionary_id = 0;
+      chunk_size = 0;
+
+      if (has(CONTAINER_DICTIONARY)) {
+        input_stream.read(reinterpret_cast<char*>(&dictionary_id),
+                          sizeof(dictionary_id));
+      }
+
+      if (has(CONTAINER_CHUNK_SIZE)) {
+        input_stream.read(reinterpret_cast<char*>(&chunk_size),
+                          sizeof(chunk_size));
+      }
+
+      return true;
+    }
+
+    input_stream.clear();
+    input_stream.seekg(0);
+    version = CONTAINER_LEGACY_VERSION;
+    flags = 0;
+    dictionary_id = 0;
+    chunk_size = 0;
+    return false;
+  }
+
+ private:
+  static constexpr size_t magic_size = 4;
+  static const char* magic() { return "SDEM"; }
+};
+
+#endif /* CONTAINER_H */
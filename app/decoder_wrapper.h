@@ -3,6 +3,8 @@
 
 #include <iterator>
 #include "bit_reader.h"
+#include "span.h"
+#include "worker.h"
 
 /**
  * A wrapper for a decoder Worker that handles EOF/EOS management.
@@ -10,7 +12,7 @@
  * @tparam Decoder a Worker that works as a decoder
  */
 template <typename Decoder>
-struct DecoderWrapper {
+struct DecoderWrapper : SpanWorker<DecoderWrapper<Decoder>> {
   /**
    * Decode a sequence of symbols.
    *
@@ -24,14 +26,50 @@ struct DecoderWrapper {
   void operator()(BidirectionalIterator begin,
                   BidirectionalIterator end,
                   OutputIterator output_iterator) {
+    typedef typename Decoder::symbol_type symbol_type;
+    (*this)(Span<const symbol_type>(), begin, end, output_iterator);
+  }
+
+  /**
+   * Decode a sequence of symbols, with a dictionary primed with the decoded
+   * symbols that precede it (see LZ77Decoder::prime()).
+   *
+   * @param dictionary the decoded symbols that precede the sequence
+   * @param begin a bidirectional iterator referring to the beginning of the
+   *              encoded sequence of symbols
+   * @param end   a bidirectional iterator referring to past-the-end of the
+   *              encoded sequence of symbols
+   * @param output_iterator an output iterator for writing the decoded sequence
+   */
+  template <typename T, typename BidirectionalIterator, typename OutputIterator>
+  void operator()(Span<const T> dictionary,
+                  BidirectionalIterator begin,
+                  BidirectionalIterator end,
+                  OutputIterator output_iterator) {
     size_t count;
-    std::advance(end, -sizeof(count));
-    BitReader<BidirectionalIterator> bit_reader(end);
+
+    // The count of tokens follows them
+    BidirectionalIterator tokens_end = end;
+    for (size_t i = 0; i < sizeof(count); ++i) {
+      if (tokens_end == begin) {
+        _error = DECODE_TRUNCATED;
+        return;
+      }
+      --tokens_end;
+    }
+
+    BitReader<BidirectionalIterator> bit_reader(tokens_end);
     bit_reader.read(count);
-    std::advance(end, sizeof(count));
 
-    Decoder decoder;
-    decoder(begin, end, output_iterator, count);
+    _decoder.prime(dictionary.begin(), dictionary.end());
+    BidirectionalIterator next =
+        _decoder(begin, tokens_end, output_iterator, count);
+
+    // Only the padding of the last token may lie between it and the count
+    _error = _decoder.error();
+    if (_error == DECODE_OK && next != tokens_end) {
+      _error = DECODE_TRAILING_DATA;
+    }
   }
 
   /**
@@ -44,17 +82,32 @@ struct DecoderWrapper {
   void operator()(InputStream& input_stream, OutputStream& output_stream) {
     size_t count;
     input_stream.seekg(-sizeof(count), std::ios_base::end);
+    if (!input_stream) {
+      _error = DECODE_TRUNCATED;
+      return;
+    }
+
     BitReader<> bit_reader(input_stream);
     bit_reader.read(count);
 
     input_stream.seekg(0);
 
-    Decoder decoder;
-    decoder(std::istreambuf_iterator<char>(input_stream),
-            std::istreambuf_iterator<char>(),
-            std::ostreambuf_iterator<char>(output_stream),
-            count);
+    _decoder.clear();
+    _decoder(std::istreambuf_iterator<char>(input_stream),
+             std::istreambuf_iterator<char>(),
+             std::ostreambuf_iterator<char>(output_stream),
+             count);
+    _error = _decoder.error();
   }
+
+  /**
+   * @return why the last sequence could not be decoded, DECODE_OK if it was
+   */
+  DecodeError error() const { return _error; }
+
+ private:
+  Decoder _decoder;
+  DecodeError _error = DECODE_OK;
 };
 
 #endif /* DECODER_WRAPPER_H */
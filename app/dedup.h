@@ -0,0 +1,126 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "hash.h"
+
+/**
+ * The number of chunks before a chunk that it may repeat, i.e. the number of
+ * decoded chunks a decoder keeps to resolve the references to them.
+ */
+static constexpr size_t DEDUP_WINDOW = 32;
+
+/**
+ * The chunks of a sequence seen by an encoder, by hash, so that a chunk that
+ * repeats one of the DEDUP_WINDOW chunks before it is written as a reference
+ * to it instead of being encoded again.
+ *
+ * Chunks may be looked up in any order; a chunk only refers to an earlier
+ * one.
+ */
+class ChunkIndex {
+ public:
+  /**
+   * Forget the chunks of the previous sequence.
+   */
+  void clear() { _latest.clear(); }
+
+  /**
+   * Look a chunk up and add it to the index.
+   *
+   * @param hash     the hash of the chunk (see murmur3_128())
+   * @param sequence the sequence number of the chunk
+   * @return the distance to the last chunk before it with the same hash, 0 if
+   *         there is none within DEDUP_WINDOW chunks
+   */
+  size_t find(const Hash128& hash, size_t sequence) {
+    auto inserted = _latest.insert(std::make_pair(hash, sequence));
+    if (inserted.second) {
+      prune(sequence);
+      return 0;
+    }
+
+    size_t& latest = inserted.first->second;
+    if (latest > sequence) {
+      return 0;
+    }
+
+    size_t distance = sequence - latest;
+    latest = sequence;
+    return distance <= DEDUP_WINDOW ? distance : 0;
+  }
+
+ private:
+  std::unordered_map<Hash128, size_t> _latest;
+
+  // Drop the chunks too far behind to be referred to, once in a while
+  void prune(size_t sequence) {
+    if (_latest.size() < 8 * DEDUP_WINDOW) {
+      return;
+    }
+
+    for (auto i = _latest.begin(); i != _latest.end();) {
+      if (i->second + DEDUP_WINDOW < sequence) {
+        i = _latest.erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+};
+
+/**
+ * The last chunks decoded from a sequence, so that a decoder resolves the
+ * references of the chunks after them (see ChunkIndex).
+ *
+ * Chunks are remembered in order. The chunks in flight are kept on top of the
+ * DEDUP_WINDOW chunks that may be referred to, since they may be remembered
+ * while a reference to an older chunk is still being written.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T>
+class ChunkHistory {
+ public:
+  /**
+   * Forget the chunks of the previous sequence.
+   *
+   * @param in_flight the number of chunks in flight
+   */
+  void reset(size_t in_flight) {
+    _chunks.resize(DEDUP_WINDOW + in_flight);
+    _remembered = 0;
+  }
+
+  /**
+   * Keep a chunk, the one after the last chunk remembered.
+   *
+   * @param data a pointer to the symbols of the chunk
+   * @param size the number of symbols
+   */
+  void remember(const T* data, size_t size) {
+    _chunks[_remembered++ % _chunks.size()].assign(data, data + size);
+  }
+
+  /**
+   * @param sequence the sequence number of a chunk
+   * @param distance the distance to the chunk it refers to
+   * @return the chunk referred to, or @c nullptr if it is not remembered
+   */
+  const std::vector<T>* find(size_t sequence, size_t distance) const {
+    if (!distance || distance > DEDUP_WINDOW || distance > sequence ||
+        sequence - distance >= _remembered) {
+      return nullptr;
+    }
+
+    return &_chunks[(sequence - distance) % _chunks.size()];
+  }
+
+ private:
+  std::vector<std::vector<T>> _chunks;
+  size_t _remembered = 0;
+};
+
+#endif /* DEDUP_H */
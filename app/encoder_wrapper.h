@@ -3,6 +3,7 @@
 
 #include <iterator>
 #include "bit_writer.h"
+#include "span.h"
 
 /**
  * A wrapper for an encoder Worker that handles EOF/EOS management.
@@ -24,11 +25,40 @@ struct EncoderWrapper {
   void operator()(ForwardIterator begin,
                   ForwardIterator end,
                   OutputIterator output_iterator) {
-    Encoder encoder;
-    size_t count = encoder(begin, end, output_iterator);
+    size_t count = _encoder(begin, end, output_iterator);
     BitWriter<OutputIterator> bit_writer(output_iterator);
     bit_writer.write(count);
   }
+
+  /**
+   * Encode a sequence of symbols, with a dictionary primed with the symbols
+   * that precede it.
+   *
+   * @param dictionary the symbols that precede the sequence
+   * @param begin a pointer to the beginning of the sequence to encode
+   * @param end   a pointer to past-the-end of the sequence to encode
+   * @param output_iterator an output iterator for writing the encoded sequence
+   */
+  template <typename T, typename OutputIterator>
+  void operator()(Span<const T> dictionary,
+                  const T* begin,
+                  const T* end,
+                  OutputIterator output_iterator) {
+    size_t count = _encoder(dictionary, begin, end, output_iterator);
+    BitWriter<OutputIterator> bit_writer(output_iterator);
+    bit_writer.write(count);
+  }
+
+  /**
+   * @param input_size the number of symbols to encode
+   * @return the maximum number of bytes written by operator()
+   */
+  static size_t bound(size_t input_size) {
+    return Encoder::bound(input_size) + sizeof(size_t);
+  }
+
+ private:
+  Encoder _encoder;
 };
 
 #endif /* ENCODER_WRAPPER_H */
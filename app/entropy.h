@@ -0,0 +1,59 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+/**
+ * The order-0 entropy, in bits per symbol, above which a sequence of bytes is
+ * considered incompressible: LZSS flags alone cost 1 bit every 8 literals, and
+ * Huffman coding cannot save more than the gap to 8 bits.
+ */
+static constexpr double INCOMPRESSIBLE_ENTROPY = 7.9;
+
+/**
+ * Compute the order-0 entropy of a sequence of bytes from its histogram.
+ *
+ * @param data a pointer to the beginning of the sequence
+ * @param size the size of the sequence
+ * @return the entropy of the sequence, in bits per symbol
+ */
+template <typename T>
+double entropy(const T* data, size_t size) {
+  static_assert(sizeof(T) == 1, "the histogram has 256 entries");
+
+  if (size == 0) {
+    return 0;
+  }
+
+  size_t histogram[std::numeric_limits<unsigned char>::max() + 1] = {};
+  for (const T* end = data + size; data != end; ++data) {
+    ++histogram[static_cast<unsigned char>(*data)];
+  }
+
+  double result = 0;
+  for (size_t count : histogram) {
+    if (count) {
+      double probability = static_cast<double>(count) / size;
+      result -= probability * std::log2(probability);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @param data      a pointer to the beginning of a sequence of bytes
+ * @param size      the size of the sequence
+ * @param threshold the entropy above which the sequence is incompressible
+ * @return whether or not compressing the sequence is not worth the effort
+ */
+template <typename T>
+bool incompressible(const T* data,
+                    size_t size,
+                    double threshold = INCOMPRESSIBLE_ENTROPY) {
+  return entropy(data, size) >= threshold;
+}
+
+#endif /* ENTROPY_H */
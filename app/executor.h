@@ -0,0 +1,250 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "topology.h"
+
+/**
+ * @return the default number of threads: one per hardware thread
+ */
+inline size_t default_threads() {
+  size_t threads = std::thread::hardware_concurrency();
+  return threads ? threads : 1;
+}
+
+/**
+ * A pool of threads that run tasks, each thread taking them from its own
+ * queue.
+ *
+ * A thread runs the task most recently pushed to its queue first, since a task
+ * submitted by a task usually works on the data its parent just wrote; once
+ * its queue is empty, it steals the oldest task of another queue. Tasks of
+ * very different costs are thus spread over the threads as they become idle.
+ *
+ * The threads may be pinned to the NUMA nodes of the machine (see Topology):
+ * they then steal from the threads of their own node first.
+ *
+ * Tasks must not block waiting for other tasks of the same executor.
+ */
+class WorkStealingExecutor {
+ public:
+  typedef std::function<void()> task_type;
+
+  /**
+   * Construct a WorkStealingExecutor and start its threads.
+   *
+   * @param threads          the number of threads
+   * @param threads_per_node the number of threads pinned to each NUMA node in
+   *                         turn; 0 leaves the threads to the system
+   */
+  explicit WorkStealingExecutor(size_t threads = default_threads(),
+                                size_t threads_per_node = 0);
+
+  /**
+   * Run the remaining tasks, then stop the threads.
+   */
+  ~WorkStealingExecutor();
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  /**
+   * Submit a task: a task submitted by a task of this executor goes to the
+   * queue of the same thread, others are spread over all the queues.
+   *
+   * @param task the task to run
+   */
+  void submit(task_type task);
+
+  /**
+   * Submit a task to the queue of a given thread, e.g. the one whose node
+   * holds the memory of the task.
+   *
+   * @param task  the task to run
+   * @param index the index of the thread, modulo the number of threads
+   */
+  void submit(task_type task, size_t index);
+
+  /**
+   * @return the number of threads
+   */
+  size_t size() const { return _threads.size(); }
+
+  /**
+   * @return the number of threads pinned to each node, 0 if not pinned
+   */
+  size_t threads_per_node() const { return _threads_per_node; }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _threads;
+  std::atomic<size_t> _next_queue;
+  size_t _threads_per_node;
+
+  // The queues to steal from by each thread, those of its node first
+  std::vector<std::vector<size_t>> _victims;
+
+  // The number of tasks in the queues, negative while a task popped before
+  // its submission is counted
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::ptrdiff_t _queued = 0;
+  bool _stopping = false;
+
+  void run(size_t index);
+  bool pop(size_t index, task_type& task);
+
+  // The executor the current thread belongs to, if any, and its index there
+  static WorkStealingExecutor*& current_executor() {
+    static thread_local WorkStealingExecutor* executor = nullptr;
+    return executor;
+  }
+
+  static size_t& current_index() {
+    static thread_local size_t index = 0;
+    return index;
+  }
+};
+
+inline WorkStealingExecutor::WorkStealingExecutor(size_t threads,
+                                                  size_t threads_per_node)
+    : _next_queue(0), _threads_per_node(threads_per_node) {
+  threads = threads ? threads : 1;
+
+  for (size_t i = 0; i < threads; ++i) {
+    _queues.emplace_back(new Queue());
+  }
+
+  const Topology& topology = Topology::get();
+  for (size_t i = 0; i < threads; ++i) {
+    std::vector<size_t> victims;
+
+    for (bool same_node : {true, false}) {
+      for (size_t j = 1; j < threads; ++j) {
+        size_t victim = (i + j) % threads;
+        bool same = !threads_per_node ||
+                    topology.node(i, threads_per_node) ==
+                        topology.node(victim, threads_per_node);
+
+        if (same == same_node) {
+          victims.push_back(victim);
+        }
+      }
+    }
+
+    _victims.push_back(victims);
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    _threads.emplace_back(&WorkStealingExecutor::run, this, i);
+  }
+}
+
+inline WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+
+  _condition.notify_all();
+
+  for (auto& thread : _threads) {
+    thread.join();
+  }
+}
+
+inline void WorkStealingExecutor::submit(task_type task) {
+  submit(std::move(task),
+         current_executor() == this ? current_index() : _next_queue++);
+}
+
+inline void WorkStealingExecutor::submit(task_type task, size_t index) {
+  index %= _queues.size();
+
+  {
+    std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+    _queues[index]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_queued;
+  }
+
+  _condition.notify_one();
+}
+
+inline void WorkStealingExecutor::run(size_t index) {
+  current_executor() = this;
+  current_index() = index;
+
+  // Before any task, so that the memory tasks touch first is on this node
+  if (_threads_per_node) {
+    const Topology& topology = Topology::get();
+    topology.pin(topology.node(index, _threads_per_node));
+  }
+
+  task_type task;
+
+  while (true) {
+    if (pop(index, task)) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_queued;
+      }
+
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [&] { return _queued > 0 || _stopping; });
+
+    if (_queued <= 0 && _stopping) {
+      return;
+    }
+  }
+}
+
+inline bool WorkStealingExecutor::pop(size_t index, task_type& task) {
+  // The newest task of the own queue
+  {
+    Queue& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // The oldest task of another queue
+  for (size_t victim : _victims[index]) {
+    Queue& queue = *_queues[victim];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+#endif /* EXECUTOR_H */
@@ -0,0 +1,525 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <algorithm>
+#include <cstring>
+#include "utils.h"
+#include "span.h"
+#include "entropy.h"
+#include "sources.h"
+
+/**
+ * The types of the frames written by EncoderFrames.
+ */
+enum FrameType : char {
+  // The chunk is copied as it is
+  FRAME_STORED = 0,
+  // The chunk went through the first Worker of the pipeline only
+  FRAME_FIRST_STAGE = 1,
+  // The chunk went through the whole pipeline
+  FRAME_COMPLETE = 2,
+  // The chunk repeats an earlier chunk, whose distance in chunks is the data
+  // of the frame (see ChunkIndex)
+  FRAME_REFERENCE = 3
+};
+
+/**
+ * What a frames policy does with the chunks that repeat an earlier chunk, when
+ * Splitter deduplicates them.
+ */
+enum FrameReferences {
+  // Repeated chunks are processed like the others
+  REFERENCES_NONE,
+  // Repeated chunks are written as FRAME_REFERENCE frames
+  REFERENCES_WRITTEN,
+  // FRAME_REFERENCE frames are read, and replaced by the chunk they refer to
+  REFERENCES_READ
+};
+
+/**
+ * What a frames policy does with the checksums of the chunks, when Splitter
+ * checksums them.
+ */
+enum FrameChecksums {
+  // Chunks are not checksummed
+  CHECKSUMS_NONE,
+  // The checksum of each chunk is appended to its frame
+  CHECKSUMS_WRITTEN,
+  // The checksum at the end of each frame is checked against the chunk
+  CHECKSUMS_READ
+};
+
+/**
+ * The result of running a chunk through a pipeline: an optional header
+ * followed by the data, and by a trailer if the chunk is checksummed.
+ *
+ * Between the two stages of the pipeline, the data is the output of the first
+ * Worker and the frame is pending.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+struct Frame {
+  static constexpr size_t max_header_size = 1 + sizeof(size_t);
+
+  T header[max_header_size];
+  size_t header_size = 0;
+  const T* data = nullptr;
+  size_t size = 0;
+  T trailer[sizeof(uint32_t)];
+  size_t trailer_size = 0;
+  bool valid = true;
+  // Why the frame is not valid, DECODE_OK if it is
+  DecodeError error = DECODE_OK;
+  bool pending = false;
+  // The distance to the earlier chunk this one repeats, 0 if none
+  size_t reference = 0;
+
+  /**
+   * Set the header of a frame.
+   *
+   * @param type      the type of the frame
+   * @param data_size the size of the data
+   * @param sized     whether or not @c data_size is written to the header
+   */
+  void set_header(FrameType type, size_t data_size, bool sized) {
+    header[0] = type;
+    header_size = 1;
+
+    if (sized) {
+      std::memcpy(header + 1, &data_size, sizeof(data_size));
+      header_size += sizeof(data_size);
+    }
+  }
+
+  /**
+   * @return the number of symbols of the frame, header and trailer included
+   */
+  size_t total_size() const { return header_size + size + trailer_size; }
+
+  /**
+   * Validate the frame after a Worker wrote its data.
+   *
+   * @param worker the Worker
+   */
+  template <typename W>
+  void check(const W& worker) {
+    error = size == OUTPUT_OVERFLOW ? DECODE_OUTPUT_OVERFLOW : worker.error();
+    valid = error == DECODE_OK;
+  }
+
+  /**
+   * Invalidate the frame.
+   *
+   * @param reason why the frame is not valid
+   */
+  void reject(DecodeError reason) {
+    error = reason;
+    valid = false;
+  }
+};
+
+/**
+ * A frames policy for Splitter that runs every chunk through both Workers and
+ * writes the result as it is, as done before frames were introduced.
+ *
+ * Buffers are twice the size of a chunk: a Worker whose output does not fit
+ * makes the frame invalid. Chunks are never primed.
+ */
+struct PlainFrames {
+  static constexpr bool primed_from_input = false;
+  static constexpr FrameReferences references = REFERENCES_NONE;
+  static constexpr FrameChecksums checksums = CHECKSUMS_NONE;
+
+  template <typename W1, typename W2>
+  static size_t buffer_size(size_t chunk_size) {
+    return 2 * chunk_size;
+  }
+
+  template <typename W1, typename InputIterator, typename T>
+  static size_t prepare_input_buffer(InputIterator& begin,
+                                     InputIterator end,
+                                     T* input_buffer,
+                                     size_t chunk_size,
+                                     size_t) {
+    return W1::prepare_input_buffer(begin, end, input_buffer, chunk_size);
+  }
+
+  template <typename W1, typename T>
+  static Frame<T> first_stage(W1& first,
+                              T* input_buffer,
+                              size_t,
+                              size_t input_size,
+                              T* intermediate_buffer,
+                              size_t buffer_size) {
+    Frame<T> frame;
+    frame.size = first.process(Span<const T>(input_buffer, input_size),
+                               Span<T>(intermediate_buffer, buffer_size));
+    frame.data = intermediate_buffer;
+    frame.check(first);
+    frame.pending = frame.valid;
+
+    return frame;
+  }
+
+  template <typename W2, typename T, typename Link>
+  static void second_stage(W2& second,
+                           Frame<T>& frame,
+                           T* input_buffer,
+                           T*,
+                           size_t buffer_size,
+                           Link&) {
+    if (!frame.pending) {
+      return;
+    }
+
+    frame.size = second.process(Span<const T>(frame.data, frame.size),
+                                Span<T>(input_buffer, buffer_size));
+    frame.data = input_buffer;
+    frame.check(second);
+    frame.pending = false;
+  }
+};
+
+/**
+ * A frames policy for Splitter that never lets a chunk grow: each chunk is
+ * written after the last stage of the pipeline that shrank it, preceded by a
+ * FrameType and by its size, so that a decoder finds the end of each frame
+ * without parsing it.
+ *
+ * Chunks whose entropy makes them incompressible (e.g. already compressed
+ * data) are stored without running the pipeline at all.
+ *
+ * Buffers are large enough for the bound() of both Workers, so that the
+ * common case writes to memory without any bounds check.
+ *
+ * When chunks are primed, the input buffer starts with the plain symbols that
+ * precede the chunk and the first Worker uses them as its initial dictionary
+ * (see SpanWorker::process()): chunks are still encoded independently.
+ */
+struct EncoderFrames {
+  static constexpr bool primed_from_input = true;
+  static constexpr FrameReferences references = REFERENCES_WRITTEN;
+  static constexpr FrameChecksums checksums = CHECKSUMS_WRITTEN;
+
+  template <typename W1, typename W2>
+  static size_t buffer_size(size_t chunk_size) {
+    return std::max({chunk_size, W1::bound(chunk_size), W2::bound(chunk_size)});
+  }
+
+  template <typename W1, typename InputIterator, typename T>
+  static size_t prepare_input_buffer(InputIterator& begin,
+                                     InputIterator end,
+                                     T* input_buffer,
+                                     size_t chunk_size,
+                                     size_t) {
+    return W1::prepare_input_buffer(begin, end, input_buffer, chunk_size);
+  }
+
+  template <typename W1, typename T>
+  static Frame<T> first_stage(W1& first,
+                              T* input_buffer,
+                              size_t dictionary_size,
+                              size_t input_size,
+                              T* intermediate_buffer,
+                              size_t buffer_size) {
+    Frame<T> frame;
+    const T* input = input_buffer + dictionary_size;
+
+    if (incompressible(input, input_size)) {
+      return stored(input, input_size);
+    }
+
+    Span<T> intermediate(intermediate_buffer, buffer_size);
+    size_t intermediate_size =
+        dictionary_size
+            ? first.process(Span<const T>(input_buffer, dictionary_size),
+                            Span<const T>(input, input_size),
+                            intermediate)
+            : first.process(Span<const T>(input, input_size), intermediate);
+
+    // OUTPUT_OVERFLOW is never smaller than the input
+    if (intermediate_size >= input_size) {
+      return stored(input, input_size);
+    }
+
+    frame.data = intermediate_buffer;
+    frame.size = intermediate_size;
+    frame.pending = true;
+    return frame;
+  }
+
+  template <typename W2, typename T, typename Link>
+  static void second_stage(W2& second,
+                           Frame<T>& frame,
+                           T* input_buffer,
+                           T*,
+                           size_t buffer_size,
+                           Link&) {
+    if (!frame.pending) {
+      return;
+    }
+
+    size_t output_size =
+        second.process(Span<const T>(frame.data, frame.size),
+                       Span<T>(input_buffer, buffer_size));
+    frame.pending = false;
+
+    if (output_size >= frame.size) {
+      frame.set_header(FRAME_FIRST_STAGE, frame.size, true);
+      return;
+    }
+
+    frame.set_header(FRAME_COMPLETE, output_size, true);
+    frame.data = input_buffer;
+    frame.size = output_size;
+  }
+
+  /**
+   * Write a chunk as a reference to an earlier chunk it repeats, instead of
+   * running it through the pipeline.
+   *
+   * @param distance the distance to the earlier chunk, in chunks
+   * @param[out] intermediate_buffer the buffer the data of the frame is
+   *                                 written to
+   * @return the frame
+   */
+  template <typename T>
+  static Frame<T> reference(size_t distance, T* intermediate_buffer) {
+    uint32_t data = distance;
+    std::memcpy(intermediate_buffer, &data, sizeof(data));
+
+    Frame<T> frame;
+    frame.set_header(FRAME_REFERENCE, sizeof(data), true);
+    frame.data = intermediate_buffer;
+    frame.size = sizeof(data);
+    frame.reference = distance;
+    return frame;
+  }
+
+  /**
+   * Append the checksum of a chunk to its frame, as a trailer counted in the
+   * size written to the header.
+   *
+   * @param[in,out] frame the frame of the chunk, complete
+   * @param checksum      the checksum of the chunk (see crc32c())
+   */
+  template <typename T>
+  static void add_checksum(Frame<T>& frame, uint32_t checksum) {
+    std::memcpy(frame.trailer, &checksum, sizeof(checksum));
+    frame.trailer_size = sizeof(checksum);
+
+    size_t size = frame.size + frame.trailer_size;
+    std::memcpy(frame.header + 1, &size, sizeof(size));
+  }
+
+ private:
+  template <typename T>
+  static Frame<T> stored(const T* input_buffer, size_t input_size) {
+    Frame<T> frame;
+    frame.set_header(FRAME_STORED, input_size, true);
+    frame.data = input_buffer;
+    frame.size = input_size;
+    return frame;
+  }
+};
+
+/**
+ * A frames policy for Splitter that decodes the frames written by
+ * EncoderFrames.
+ *
+ * Every copy and every write is bounded by the size of the buffers, so that
+ * corrupted frames are rejected instead of overflowing them.
+ *
+ * Sized frames are read as blocks (see read_block()), leaving all the parsing
+ * to the Workers; complete frames written before they were sized (container
+ * version 3 and older) are parsed by the first Worker as they are read.
+ *
+ * When chunks are primed, the second Worker starts from the dictionary of the
+ * chunk (see ChunkLink); if chunks are chained, the first stages still run in
+ * parallel, but Splitter runs the second stages in order.
+ *
+ * @tparam EncoderW1 the type of the first Worker of the encoding pipeline
+ * @tparam EncoderW2 the type of the second Worker of the encoding pipeline
+ * @tparam sized     whether or not complete frames are sized
+ */
+template <typename EncoderW1, typename EncoderW2, bool sized = true>
+struct DecoderFrames {
+  static constexpr bool primed_from_input = false;
+  static constexpr FrameReferences references = REFERENCES_READ;
+  static constexpr FrameChecksums checksums =
+      sized ? CHECKSUMS_READ : CHECKSUMS_NONE;
+
+  template <typename W1, typename W2>
+  static size_t buffer_size(size_t chunk_size) {
+    return EncoderFrames::buffer_size<EncoderW1, EncoderW2>(chunk_size) +
+           Frame<>::max_header_size + sizeof(uint32_t);
+  }
+
+  template <typename W1, typename InputIterator, typename T>
+  static size_t prepare_input_buffer(InputIterator& begin,
+                                     InputIterator end,
+                                     T* input_buffer,
+                                     size_t,
+                                     size_t buffer_size) {
+    T type = *begin;
+    ++begin;
+    input_buffer[0] = type;
+
+    if (type == FRAME_COMPLETE && !sized) {
+      return 1 + W1::prepare_input_buffer(
+                     begin, end, input_buffer + 1, buffer_size - 1);
+    }
+
+    size_t size = 0;
+    size_t current_size =
+        1 + read_block(begin, end, input_buffer + 1, sizeof(size));
+
+    std::memcpy(&size, input_buffer + 1, sizeof(size));
+    size = std::min(size, buffer_size - current_size);
+
+    return current_size +
+           read_block(begin, end, input_buffer + current_size, size);
+  }
+
+  template <typename W1, typename T>
+  static Frame<T> first_stage(W1& first,
+                              T* input_buffer,
+                              size_t,
+                              size_t input_size,
+                              T* intermediate_buffer,
+                              size_t buffer_size) {
+    Frame<T> frame;
+    T type = input_buffer[0];
+
+    if (type == FRAME_COMPLETE && !sized) {
+      return decode_first_stage(first,
+                                input_buffer + 1,
+                                input_size - 1,
+                                intermediate_buffer,
+                                buffer_size);
+    }
+
+    size_t size = 0;
+    if (input_size >= Frame<T>::max_header_size) {
+      std::memcpy(&size, input_buffer + 1, sizeof(size));
+    }
+
+    if (input_size < Frame<T>::max_header_size ||
+        size != input_size - Frame<T>::max_header_size ||
+        (type != FRAME_STORED && type != FRAME_FIRST_STAGE &&
+         type != FRAME_COMPLETE && type != FRAME_REFERENCE)) {
+      frame.reject(DECODE_INVALID_FRAME);
+      return frame;
+    }
+
+    T* data = input_buffer + Frame<T>::max_header_size;
+
+    // Splitter replaces the frame with the chunk it refers to
+    if (type == FRAME_REFERENCE) {
+      uint32_t distance = 0;
+      if (size == sizeof(distance)) {
+        std::memcpy(&distance, data, sizeof(distance));
+      }
+
+      frame.reference = distance;
+      if (distance == 0) {
+        frame.reject(DECODE_INVALID_FRAME);
+      }
+      return frame;
+    }
+
+    if (type == FRAME_COMPLETE) {
+      return decode_first_stage(
+          first, data, size, intermediate_buffer, buffer_size);
+    }
+
+    frame.data = data;
+    frame.size = size;
+    frame.pending = type == FRAME_FIRST_STAGE;
+    return frame;
+  }
+
+  /**
+   * Remove the checksum that ends a frame read by prepare_input_buffer(),
+   * leaving the frame as if it had none.
+   *
+   * @param[in,out] input_buffer the frame
+   * @param input_size           the size of the frame
+   * @param[out] checksum        the checksum of the chunk
+   * @return the size of the frame without its checksum, 0 if the frame is
+   *         too short to have one
+   */
+  template <typename T>
+  static size_t remove_checksum(T* input_buffer,
+                                size_t input_size,
+                                uint32_t& checksum) {
+    size_t size = 0;
+    if (input_size >= Frame<T>::max_header_size) {
+      std::memcpy(&size, input_buffer + 1, sizeof(size));
+    }
+
+    if (input_size < Frame<T>::max_header_size + sizeof(checksum) ||
+        size != input_size - Frame<T>::max_header_size) {
+      return 0;
+    }
+
+    input_size -= sizeof(checksum);
+    size -= sizeof(checksum);
+    std::memcpy(&checksum, input_buffer + input_size, sizeof(checksum));
+    std::memcpy(input_buffer + 1, &size, sizeof(size));
+    return input_size;
+  }
+
+  // Run the second Worker, primed with the dictionary of the chunk, and keep
+  // the end of the decoded chunk for priming the next one, if chained
+  template <typename W2, typename T, typename Link>
+  static void second_stage(W2& second,
+                           Frame<T>& frame,
+                           T* input_buffer,
+                           T* intermediate_buffer,
+                           size_t buffer_size,
+                           Link& link) {
+    if (frame.pending) {
+      // Decode into whichever buffer the data is not in
+      T* output_buffer = frame.data == intermediate_buffer
+                             ? input_buffer
+                             : intermediate_buffer;
+      Span<const T> data(frame.data, frame.size);
+      Span<T> output(output_buffer, buffer_size);
+
+      if (link.primed()) {
+        frame.size = second.process(link.dictionary(), data, output);
+      } else {
+        frame.size = second.process(data, output);
+      }
+
+      frame.data = output_buffer;
+      frame.check(second);
+      frame.pending = false;
+    }
+
+    if (frame.valid) {
+      link.extend(Span<const T>(frame.data, frame.size));
+    }
+  }
+
+ private:
+  // Run the first Worker on the data of a complete frame
+  template <typename W1, typename T>
+  static Frame<T> decode_first_stage(W1& first,
+                                     const T* data,
+                                     size_t size,
+                                     T* intermediate_buffer,
+                                     size_t buffer_size) {
+    Frame<T> frame;
+    frame.size = first.process(Span<const T>(data, size),
+                               Span<T>(intermediate_buffer, buffer_size));
+    frame.data = intermediate_buffer;
+    frame.check(first);
+    frame.pending = frame.valid;
+    return frame;
+  }
+};
+
+#endif /* FRAMES_H */
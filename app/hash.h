@@ -0,0 +1,128 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * A 128-bit hash.
+ */
+struct Hash128 {
+  uint64_t low = 0;
+  uint64_t high = 0;
+
+  bool operator==(const Hash128& rhs) const {
+    return low == rhs.low && high == rhs.high;
+  }
+
+  bool operator!=(const Hash128& rhs) const { return !(*this == rhs); }
+};
+
+namespace std {
+template <>
+struct hash<Hash128> {
+  size_t operator()(const Hash128& hash) const {
+    return static_cast<size_t>(hash.low);
+  }
+};
+}  // namespace std
+
+/**
+ * Hash a block of memory with MurmurHash3 (x64, 128 bits), which reads
+ * 16 bytes at a time and gives the same hash on every machine.
+ *
+ * @param data a pointer to the block
+ * @param size the size of the block, in bytes
+ * @param seed the seed of the hash
+ * @return the hash of the block
+ */
+inline Hash128 murmur3_128(const void* data, size_t size, uint64_t seed = 0) {
+  static constexpr uint64_t c1 = 0x87c37b91114253d5;
+  static constexpr uint64_t c2 = 0x4cf5ad432745937f;
+
+  struct Mix {
+    static uint64_t rotl(uint64_t x, int r) {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t fmix(uint64_t k) {
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccd;
+      k ^= k >> 33;
+      k *= 0xc4ceb9fe1a85ec53;
+      k ^= k >> 33;
+      return k;
+    }
+
+    // Little-endian, whatever the machine
+    static uint64_t load(const unsigned char* bytes, size_t count) {
+      uint64_t value = 0;
+      for (size_t i = 0; i < count; ++i) {
+        value |= uint64_t(bytes[i]) << (8 * i);
+      }
+      return value;
+    }
+  };
+
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  size_t blocks = size / 16;
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+
+  for (size_t i = 0; i < blocks; ++i) {
+    uint64_t k1 = Mix::load(bytes + 16 * i, 8);
+    uint64_t k2 = Mix::load(bytes + 16 * i + 8, 8);
+
+    k1 *= c1;
+    k1 = Mix::rotl(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = Mix::rotl(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = Mix::rotl(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = Mix::rotl(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  const unsigned char* tail = bytes + 16 * blocks;
+  size_t rest = size % 16;
+
+  if (rest > 8) {
+    uint64_t k2 = Mix::load(tail + 8, rest - 8);
+    k2 *= c2;
+    k2 = Mix::rotl(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+  }
+
+  if (rest > 0) {
+    uint64_t k1 = Mix::load(tail, rest > 8 ? 8 : rest);
+    k1 *= c1;
+    k1 = Mix::rotl(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = Mix::fmix(h1);
+  h2 = Mix::fmix(h2);
+  h1 += h2;
+  h2 += h1;
+
+  Hash128 hash;
+  hash.low = h1;
+  hash.high = h2;
+  return hash;
+}
+
+#endif /* HASH_H */
@@ -8,6 +8,9 @@
 /**
  * A functor that decodes a sequence of symbols encoded using Huffman coding.
  *
+ * Codes that lead out of the tree (e.g. from a corrupted table, or a corrupted
+ * sequence using a table that is not full) are rejected rather than followed.
+ *
  * @tparam T the type of symbols
  * @tparam W the type of the weights
  */
@@ -35,12 +38,27 @@ class HuffmanDecoder {
    * @param output_iterator an output iterator for writing the decoded sequence
    * @param skip_header whether or not @c begin points to the beginning of the
    *                    header
+   * @return DECODE_OK, or why the sequence could not be decoded
+   */
+  template <typename InputIterator, typename OutputIterator>
+  DecodeError operator()(InputIterator begin,
+                         InputIterator end,
+                         OutputIterator output_iterator,
+                         bool skip_header = false);
+
+  /**
+   * Decode a sequence of symbols whose header has already been read.
+   *
+   * @param[in,out] bit_reader a BitReader referring to the encoded symbols
+   * @param         bits       the number of encoded bits
+   * @param output_iterator an output iterator for writing the decoded sequence
+   * @return DECODE_OK, DECODE_TRUNCATED if the input ends before the encoded
+   *         bits, or DECODE_INVALID_CODE if a code is not in the tree
    */
   template <typename InputIterator, typename OutputIterator>
-  void operator()(InputIterator begin,
-                  InputIterator end,
-                  OutputIterator output_iterator,
-                  bool skip_header = false);
+  DecodeError decode(BitReader<InputIterator>& bit_reader,
+                     size_t bits,
+                     OutputIterator output_iterator) const;
 
  private:
   typedef typename HuffmanTreeBase<T, W>::ptr_type ptr_type;
@@ -51,22 +69,36 @@ class HuffmanDecoder {
 
 template <typename T, typename W>
 template <typename InputIterator, typename OutputIterator>
-void HuffmanDecoder<T, W>::operator()(InputIterator begin,
-                                      InputIterator end,
-                                      OutputIterator output_iterator,
-                                      bool skip_header) {
-  if (skip_header) {
-    std::advance(begin, header_size());
+DecodeError HuffmanDecoder<T, W>::operator()(InputIterator begin,
+                                             InputIterator end,
+                                             OutputIterator output_iterator,
+                                             bool skip_header) {
+  // The header may be cut by the end of the input
+  for (size_t i = skip_header ? header_size() : 0; i && begin != end; --i) {
+    ++begin;
   }
 
   BitReader<InputIterator> bit_reader(begin, end);
-  BitWriter<OutputIterator> bit_writer(output_iterator);
-  ptr_type current_node = root;
 
   size_t bits_to_read;
   bit_reader.read(bits_to_read);
 
-  while (bit_reader && bits_to_read--) {
+  if (bit_reader.overrun()) {
+    return DECODE_TRUNCATED;
+  }
+
+  return decode(bit_reader, bits_to_read, output_iterator);
+}
+
+template <typename T, typename W>
+template <typename InputIterator, typename OutputIterator>
+DecodeError HuffmanDecoder<T, W>::decode(BitReader<InputIterator>& bit_reader,
+                                         size_t bits_to_read,
+                                         OutputIterator output_iterator) const {
+  BitWriter<OutputIterator> bit_writer(output_iterator);
+  ptr_type current_node = root;
+
+  for (; bits_to_read && bit_reader; --bits_to_read) {
     bool bit = bit_reader.read();
 
     if (bit) {
@@ -75,15 +107,27 @@ void HuffmanDecoder<T, W>::operator()(InputIterator begin,
       current_node = current_node->left;
     }
 
+    // A missing child is a code no symbol has
+    if (!current_node) {
+      return DECODE_INVALID_CODE;
+    }
+
     if (current_node->leaf()) {
       bit_writer.write(current_node->data.symbol);
       current_node = root;
     }
   }
+
+  if (bits_to_read) {
+    return DECODE_TRUNCATED;
+  }
+
+  // The last code must be complete
+  return current_node == root ? DECODE_OK : DECODE_INVALID_CODE;
 }
 
 template <>
-size_t HuffmanDecoder<char>::header_size() const {
+inline size_t HuffmanDecoder<char>::header_size() const {
   return 256;
 }
 
@@ -1,19 +1,21 @@
 #ifndef HUFFMAN_DECODER_STACK_H
 #define HUFFMAN_DECODER_STACK_H
 
-#include <cmath>
-#include <type_traits>
 #include "canonical_huffman_tree.h"
 #include "huffman_decoder.h"
+#include "huffman_header.h"
 #include "bit_reader.h"
+#include "buffers.h"
+#include "worker.h"
 
 /**
  * A Worker for an HuffmanDecoder.
  *
  * @tparam T the type of the symbols
+ * @tparam H the type of the header (see RawHuffmanHeader)
  */
-template <typename T>
-struct HuffmanDecoderStack {
+template <typename T, typename H = CompactHuffmanHeader>
+struct HuffmanDecoderStack : SpanWorker<HuffmanDecoderStack<T, H>, T> {
   /**
    * Decode a sequence of symbols.
    *
@@ -27,11 +29,25 @@ struct HuffmanDecoderStack {
   void operator()(InputIterator begin,
                   InputIterator end,
                   OutputIterator output_iterator) {
-    CanonicalHuffmanTree<T> tree(begin, end);
-    HuffmanDecoder<T> decoder(tree);
-    decoder(begin, end, output_iterator, std::is_pointer<InputIterator>::value);
+    decode(begin, end, output_iterator);
   }
 
+  /**
+   * Decode a sequence of symbols.
+   *
+   * @param begin an input iterator referring to the beginning of the encoded
+   *              sequence
+   * @param end   an input iterator referring to past-the-end of the encoded
+   *              sequence
+   * @param output_iterator an output iterator for writing the decoded sequence
+   * @return an input iterator referring to past-the-end of the encoded
+   *         sequence; error() tells whether it could be decoded
+   */
+  template <typename InputIterator, typename OutputIterator>
+  InputIterator decode(InputIterator begin,
+                       InputIterator end,
+                       OutputIterator output_iterator);
+
   /**
    * Load an encoded sequence in a buffer.
    *
@@ -40,44 +56,82 @@ struct HuffmanDecoderStack {
    * @param      end   an input iterator referring to past-the-end of the
    *                   encoded sequence
    * @param[out] input_buffer the buffer to load the encoded sequence into
-   * @param      chunk_size   the maximum number of bytes to read
+   * @param      chunk_size   the maximum number of bytes to read; longer
+   *                          sequences are truncated
+   * @return the number of bytes loaded
    */
   template <typename InputIterator>
   static size_t prepare_input_buffer(InputIterator& begin,
                                      InputIterator end,
                                      T* input_buffer,
                                      size_t chunk_size);
+
+  /**
+   * Forget the table of the previous sequence.
+   */
+  void reset() { _header = H(); }
+
+  /**
+   * @return why the last sequence could not be decoded, DECODE_OK if it was
+   */
+  DecodeError error() const { return _error; }
+
+ private:
+  H _header;
+  DecodeError _error = DECODE_OK;
 };
 
-template <>
-template <typename InputIterator>
-size_t HuffmanDecoderStack<char>::prepare_input_buffer(InputIterator& begin,
-                                                       InputIterator end,
-                                                       char* input_buffer,
-                                                       size_t) {
-  size_t current_chunk_size = 0;
+template <typename T, typename H>
+template <typename InputIterator, typename OutputIterator>
+InputIterator HuffmanDecoderStack<T, H>::decode(
+    InputIterator begin, InputIterator end, OutputIterator output_iterator) {
+  BitReader<InputIterator> header_reader(begin, end);
+  size_t bits;
 
-  for (; current_chunk_size < 256 && begin != end;
-       ++current_chunk_size, ++begin) {
-    input_buffer[current_chunk_size] = *begin;
+  if (!_header.read(header_reader, bits) || header_reader.overrun()) {
+    _error = header_reader.overrun() ? DECODE_TRUNCATED : DECODE_INVALID_CODE;
+    return header_reader.next();
   }
 
-  size_t bits_to_decode;
-  BitReader<InputIterator> bit_reader(begin, end);
-  bit_reader.read(bits_to_decode);
+  const auto& code_lengths = _header.code_lengths();
+  CanonicalHuffmanTree<T> tree(code_lengths.data(), code_lengths.size());
+  HuffmanDecoder<T> decoder(tree);
+
+  // The encoded symbols start at the first byte after the header
+  BitReader<InputIterator> bit_reader(header_reader.next(), end);
+  _error = decoder.decode(bit_reader, bits, output_iterator);
 
-  *(reinterpret_cast<size_t*>(input_buffer + current_chunk_size)) =
-      bits_to_decode;
+  return bit_reader.next();
+}
+
+template <typename T, typename H>
+template <typename InputIterator>
+size_t HuffmanDecoderStack<T, H>::prepare_input_buffer(InputIterator& begin,
+                                                       InputIterator end,
+                                                       T* input_buffer,
+                                                       size_t chunk_size) {
+  typedef CopyingIterator<InputIterator, T> iterator_type;
 
-  current_chunk_size += sizeof(bits_to_decode);
+  BoundedPushBackBuffer<T> buffer(input_buffer, chunk_size);
+  BitReader<iterator_type> bit_reader(iterator_type(begin, &buffer),
+                                      iterator_type(end));
+
+  H header;
+  size_t bits = 0;
+  bool valid = header.read(bit_reader, bits);
+  begin = bit_reader.next().base();
+
+  if (!valid) {
+    return buffer.size();
+  }
 
-  size_t bytes_to_decode = std::ceil(bits_to_decode / 8.0);
-  for (begin = bit_reader.next(); bytes_to_decode--;
-       ++begin, ++current_chunk_size) {
-    input_buffer[current_chunk_size] = *begin;
+  for (size_t bytes = bits / 8 + (bits % 8 != 0);
+       bytes-- && begin != end && buffer.size() < chunk_size;
+       ++begin) {
+    buffer.push_back(*begin);
   }
 
-  return current_chunk_size;
+  return buffer.size();
 }
 
 #endif /* HUFFMAN_DECODER_STACK_H */
@@ -69,6 +69,16 @@ class HuffmanEncoder {
     return _codebook.at(symbol);
   }
 
+  /**
+   * @param symbol a symbol
+   * @return the length of the code of @c symbol, 0 if it is not in the
+   *         codebook
+   */
+  size_t code_length(symbol_type symbol) const {
+    auto it = _codebook.find(symbol);
+    return it != _codebook.end() ? it->second.size() : 0;
+  }
+
   /**
    * Make the encoding canonical.
    */
@@ -84,6 +94,15 @@ class HuffmanEncoder {
   void dump_encoded_bits(const HuffmanTree<T, W>& tree,
                          OutputIterator output_iterator) const;
 
+  /**
+   * Compute the number of bits needed to encode the sequence @c tree was
+   * built from.
+   *
+   * @param[in] tree an HuffmanTree
+   * @return the number of encoded bits
+   */
+  size_t encoded_bits(const HuffmanTree<T, W>& tree) const;
+
   /**
    * Write the codebook to an output iterator.
    *
@@ -134,7 +153,8 @@ template <typename TreeNode>
 void HuffmanEncoder<T, W>::navigate(const TreeNode* node,
                                     const bitset_type& code) {
   if (node->leaf()) {
-    _codebook[node->data.symbol] = code;
+    // A tree made of a single leaf still needs a one bit code
+    _codebook[node->data.symbol] = code.empty() ? bitset_type(1) : code;
   } else {
     auto child = node->left;
     if (child) {
@@ -194,17 +214,22 @@ void HuffmanEncoder<char>::dump_codebook(OutputIterator output_iterator) const {
 }
 
 template <typename T, typename W>
-template <typename OutputIterator>
-void HuffmanEncoder<T, W>::dump_encoded_bits(
-    const HuffmanTree<T, W>& tree, OutputIterator output_iterator) const {
-  size_t encoded_bits = 0;
+size_t HuffmanEncoder<T, W>::encoded_bits(const HuffmanTree<T, W>& tree) const {
+  size_t bits = 0;
 
   for (auto&& pair : _codebook) {
-    encoded_bits += pair.second.size() * tree.frequency(pair.first);
+    bits += pair.second.size() * tree.frequency(pair.first);
   }
 
+  return bits;
+}
+
+template <typename T, typename W>
+template <typename OutputIterator>
+void HuffmanEncoder<T, W>::dump_encoded_bits(
+    const HuffmanTree<T, W>& tree, OutputIterator output_iterator) const {
   BitWriter<OutputIterator> bit_writer(output_iterator);
-  bit_writer.write(encoded_bits);
+  bit_writer.write(encoded_bits(tree));
 }
 
 #endif /* HUFFMAN_ENCODER_H */
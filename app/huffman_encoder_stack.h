@@ -4,14 +4,20 @@
 #include <iterator>
 #include "huffman_tree.h"
 #include "huffman_encoder.h"
+#include "huffman_header.h"
+#include "worker.h"
 
 /**
  * A Worker for an HuffmanEncoder.
  *
+ * Consecutive sequences encoded by the same instance may share their table
+ * (see CompactHuffmanHeader).
+ *
  * @tparam T the type of the symbols
+ * @tparam H the type of the header (see RawHuffmanHeader)
  */
-template <typename T>
-struct HuffmanEncoderStack {
+template <typename T, typename H = CompactHuffmanHeader>
+struct HuffmanEncoderStack : SpanWorker<HuffmanEncoderStack<T, H>, T> {
   /**
    * Encode a sequence of symbols.
    *
@@ -26,14 +32,27 @@ struct HuffmanEncoderStack {
                   ForwardIterator end,
                   OutputIterator output_iterator) {
     HuffmanTree<T> tree(begin, end);
-    HuffmanEncoder<T> encoder(tree);
-    encoder.make_canonical();
-
-    encoder.dump_header(tree, output_iterator);
+    auto encoder = _header.write(tree, output_iterator);
 
     encoder(begin, end, output_iterator);
   }
 
+  /**
+   * Huffman coding never takes more bits than a fixed length code, so only
+   * the header may expand the input.
+   *
+   * @param input_size the number of symbols to encode
+   * @return the maximum number of bytes written by operator()
+   */
+  static size_t bound(size_t input_size) {
+    return H::max_size + input_size * sizeof(T);
+  }
+
+  /**
+   * Forget the table of the previous sequence.
+   */
+  void reset() { _header = H(); }
+
   /**
    * Encode a sequence of symbols.
    *
@@ -48,18 +67,18 @@ struct HuffmanEncoderStack {
     HuffmanTree<T> tree(input_iterator_t(input_stream.rdbuf()),
                         input_iterator_t());
 
-    HuffmanEncoder<T> encoder(tree);
-    encoder.make_canonical();
-
     input_stream.seekg(0);
 
     output_iterator_t output_iterator(output_stream);
-    encoder.dump_header(tree, output_iterator);
+    auto encoder = _header.write(tree, output_iterator);
 
     encoder(input_iterator_t(input_stream.rdbuf()),
             input_iterator_t(),
             output_iterator);
   }
+
+ private:
+  H _header;
 };
 
 #endif /* HUFFMAN_ENCODER_STACK_H */
@@ -0,0 +1,548 @@
+#ifndef HUFFMAN_HEADER_H
+#define HUFFMAN_HEADER_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "bit_reader.h"
+#include "bit_writer.h"
+#include "huffman_tree.h"
+#include "huffman_encoder.h"
+#include "canonical_huffman_tree.h"
+
+/**
+ * The code length of each byte value, 0 for the ones without a code.
+ */
+typedef std::array<unsigned char, 256> HuffmanCodeLengths;
+
+/**
+ * The header written before Huffman coded bytes by the original encoder
+ * stacks: 256 code lengths of one byte each, followed by the number of
+ * encoded bits as a @c size_t.
+ *
+ * Header classes are used by HuffmanEncoderStack and HuffmanDecoderStack to
+ * write and read the table of each sequence.
+ */
+class RawHuffmanHeader {
+ public:
+  static constexpr size_t max_size = 256 + sizeof(size_t);
+
+  /**
+   * Build the encoder for a sequence and write its header.
+   *
+   * @param[in] tree            the HuffmanTree of the sequence
+   * @param     output_iterator an output iterator
+   * @return the encoder to encode the sequence with
+   */
+  template <typename OutputIterator>
+  HuffmanEncoder<char> write(const HuffmanTree<char>& tree,
+                             OutputIterator output_iterator) {
+    HuffmanEncoder<char> encoder(tree);
+    encoder.make_canonical();
+    encoder.dump_header(tree, output_iterator);
+    return encoder;
+  }
+
+  /**
+   * Read a header; on success code_lengths() describes the table.
+   *
+   * @param[in,out] bit_reader a BitReader referring to the header
+   * @param[out]    bits       the number of encoded bits
+   * @return false if the header is malformed
+   */
+  template <typename InputIterator>
+  bool read(BitReader<InputIterator>& bit_reader, size_t& bits) {
+    // Sum of 2^(32 - length), for checking Kraft's inequality
+    uint64_t kraft_sum = 0;
+
+    for (auto&& length : _code_lengths) {
+      if (!bit_reader) {
+        return false;
+      }
+
+      bit_reader.read(length);
+
+      if (length > 32) {
+        return false;
+      }
+
+      if (length > 0) {
+        kraft_sum += uint64_t(1) << (32 - length);
+      }
+    }
+
+    if (!bit_reader || kraft_sum > (uint64_t(1) << 32)) {
+      return false;
+    }
+
+    bit_reader.read(bits);
+    return !bit_reader.overrun();
+  }
+
+  /**
+   * @return the code lengths of the last header read
+   */
+  const HuffmanCodeLengths& code_lengths() const { return _code_lengths; }
+
+ private:
+  HuffmanCodeLengths _code_lengths;
+};
+
+/**
+ * The kinds of CompactHuffmanHeader.
+ */
+enum HuffmanHeaderKind : unsigned char {
+  // The table of the previous header is used again
+  HUFFMAN_HEADER_REUSE = 0,
+  // Run-length encoded code lengths, written with a fixed number of bits
+  HUFFMAN_HEADER_RLE = 1,
+  // Run-length encoded code lengths, themselves Huffman coded
+  HUFFMAN_HEADER_CODED = 2
+};
+
+/**
+ * A compact header for Huffman coded bytes, in the spirit of DEFLATE: runs of
+ * code lengths are encoded with a small alphabet, which is Huffman coded too
+ * when that makes the header shorter; the number of encoded bits is a varint.
+ *
+ * An instance remembers the last table it wrote (or read): when that table
+ * encodes the next sequence about as well as its own table would, the header
+ * only says to reuse it.
+ */
+class CompactHuffmanHeader {
+  // The alphabet the code lengths are encoded with: lengths from 0 to 32
+  // stand for themselves
+  enum RunSymbol : unsigned char {
+    // The previous length, repeated 3 to 6 times
+    REPEAT = 33,
+    // 3 to 10 zeros
+    SHORT_ZEROS = 34,
+    // 11 to 138 zeros
+    LONG_ZEROS = 35,
+    RUN_SYMBOLS = 36
+  };
+
+  static constexpr bits_t kind_bits = 2;
+  static constexpr bits_t run_symbol_bits = 6;
+  static constexpr bits_t run_length_bits = 4;
+  static constexpr unsigned char max_code_length = 32;
+
+  struct Run {
+    unsigned char symbol;
+    unsigned char extra;
+  };
+
+  typedef std::array<unsigned char, RUN_SYMBOLS> run_lengths_type;
+  typedef std::array<uint_fast16_t, RUN_SYMBOLS> run_codes_type;
+
+ public:
+  static constexpr size_t max_size =
+      (kind_bits + 256 * run_symbol_bits + 7) / 8 + 10;
+
+  /**
+   * Build the encoder for a sequence and write its header.
+   *
+   * @param[in] tree            the HuffmanTree of the sequence
+   * @param     output_iterator an output iterator
+   * @return the encoder to encode the sequence with
+   */
+  template <typename OutputIterator>
+  HuffmanEncoder<char> write(const HuffmanTree<char>& tree,
+                             OutputIterator output_iterator);
+
+  /**
+   * Read a header; on success code_lengths() describes the table.
+   *
+   * @param[in,out] bit_reader a BitReader referring to the header
+   * @param[out]    bits       the number of encoded bits
+   * @return false if the header is malformed
+   */
+  template <typename InputIterator>
+  bool read(BitReader<InputIterator>& bit_reader, size_t& bits);
+
+  /**
+   * @return the code lengths of the last header written or read
+   */
+  const HuffmanCodeLengths& code_lengths() const { return _code_lengths; }
+
+ private:
+  HuffmanCodeLengths _code_lengths = {};
+  bool _has_table = false;
+
+  static bits_t extra_bits(unsigned char symbol) {
+    switch (symbol) {
+      case REPEAT:
+        return 2;
+      case SHORT_ZEROS:
+        return 3;
+      case LONG_ZEROS:
+        return 7;
+      default:
+        return 0;
+    }
+  }
+
+  static std::vector<Run> make_runs(const HuffmanCodeLengths& code_lengths);
+
+  static bool make_run_lengths(const std::vector<Run>& runs,
+                               run_lengths_type& run_lengths);
+
+  static void make_run_codes(const run_lengths_type& run_lengths,
+                             run_codes_type& run_codes);
+
+  template <typename Node>
+  static void navigate(const Node* node,
+                       size_t depth,
+                       run_lengths_type& run_lengths);
+
+  static size_t table_bits(const HuffmanCodeLengths& code_lengths);
+
+  template <typename OutputIterator>
+  static void write_table(const HuffmanCodeLengths& code_lengths,
+                          BitWriter<OutputIterator>& bit_writer);
+
+  template <typename InputIterator>
+  static bool read_table(unsigned char kind,
+                         BitReader<InputIterator>& bit_reader,
+                         HuffmanCodeLengths& code_lengths);
+
+  template <typename InputIterator>
+  static unsigned char read_run_symbol(BitReader<InputIterator>& bit_reader,
+                                       const run_lengths_type& run_lengths,
+                                       const run_codes_type& run_codes);
+};
+
+template <typename OutputIterator>
+HuffmanEncoder<char> CompactHuffmanHeader::write(
+    const HuffmanTree<char>& tree, OutputIterator output_iterator) {
+  HuffmanEncoder<char> encoder(tree);
+  encoder.make_canonical();
+
+  HuffmanCodeLengths code_lengths;
+  bool covered = _has_table;
+
+  for (size_t i = 0; i < code_lengths.size(); ++i) {
+    char symbol = static_cast<char>(i);
+    code_lengths[i] = encoder.code_length(symbol);
+    covered = covered && (_code_lengths[i] > 0 || tree.frequency(symbol) == 0);
+  }
+
+  size_t bits = encoder.encoded_bits(tree);
+  BitWriter<OutputIterator> bit_writer(output_iterator);
+
+  if (covered) {
+    HuffmanEncoder<char> previous(
+        CanonicalHuffmanTree<char>(_code_lengths.data(), _code_lengths.size()));
+    size_t previous_bits = previous.encoded_bits(tree);
+
+    if (previous_bits <= bits + table_bits(code_lengths)) {
+      bit_writer.write(static_cast<unsigned char>(HUFFMAN_HEADER_REUSE),
+                       kind_bits);
+      bit_writer.write_varint(previous_bits);
+      return previous;
+    }
+  }
+
+  write_table(code_lengths, bit_writer);
+  bit_writer.write_varint(bits);
+
+  _code_lengths = code_lengths;
+  _has_table = true;
+
+  return encoder;
+}
+
+template <typename InputIterator>
+bool CompactHuffmanHeader::read(BitReader<InputIterator>& bit_reader,
+                                size_t& bits) {
+  if (!bit_reader) {
+    return false;
+  }
+
+  unsigned char kind;
+  bit_reader.read(kind, kind_bits);
+
+  if (kind == HUFFMAN_HEADER_REUSE) {
+    if (!_has_table) {
+      return false;
+    }
+  } else {
+    HuffmanCodeLengths code_lengths;
+
+    if (!read_table(kind, bit_reader, code_lengths)) {
+      return false;
+    }
+
+    _code_lengths = code_lengths;
+    _has_table = true;
+  }
+
+  uint64_t value;
+  if (!bit_reader.read_varint(value) || bit_reader.overrun()) {
+    return false;
+  }
+
+  bits = value;
+  return true;
+}
+
+inline std::vector<CompactHuffmanHeader::Run> CompactHuffmanHeader::make_runs(
+    const HuffmanCodeLengths& code_lengths) {
+  std::vector<Run> runs;
+
+  for (size_t i = 0; i < code_lengths.size();) {
+    unsigned char length = code_lengths[i];
+    size_t count = 1;
+
+    while (i + count < code_lengths.size() &&
+           code_lengths[i + count] == length) {
+      ++count;
+    }
+
+    if (length == 0 && count >= 3) {
+      count = std::min<size_t>(count, 138);
+
+      if (count <= 10) {
+        runs.push_back({SHORT_ZEROS, static_cast<unsigned char>(count - 3)});
+      } else {
+        runs.push_back({LONG_ZEROS, static_cast<unsigned char>(count - 11)});
+      }
+
+      i += count;
+      continue;
+    }
+
+    runs.push_back({length, 0});
+    ++i;
+    --count;
+
+    for (; count >= 3; count -= std::min<size_t>(count, 6)) {
+      size_t repeat = std::min<size_t>(count, 6);
+      runs.push_back({REPEAT, static_cast<unsigned char>(repeat - 3)});
+      i += repeat;
+    }
+  }
+
+  return runs;
+}
+
+inline bool CompactHuffmanHeader::make_run_lengths(
+    const std::vector<Run>& runs, run_lengths_type& run_lengths) {
+  std::vector<unsigned char> symbols;
+  for (auto&& run : runs) {
+    symbols.push_back(run.symbol);
+  }
+
+  HuffmanTree<unsigned char> tree(symbols.begin(), symbols.end());
+
+  run_lengths.fill(0);
+  navigate(tree.root(), 0, run_lengths);
+
+  return std::all_of(
+      run_lengths.begin(), run_lengths.end(), [](unsigned char length) {
+        return length < (1 << run_length_bits);
+      });
+}
+
+template <typename Node>
+void CompactHuffmanHeader::navigate(const Node* node,
+                                    size_t depth,
+                                    run_lengths_type& run_lengths) {
+  if (node->leaf()) {
+    // A tree made of a single leaf still needs a one bit code
+    run_lengths[node->data.symbol] =
+        std::min<size_t>(std::max<size_t>(depth, 1), 0xff);
+    return;
+  }
+
+  if (node->left) {
+    navigate(node->left, depth + 1, run_lengths);
+  }
+
+  if (node->right) {
+    navigate(node->right, depth + 1, run_lengths);
+  }
+}
+
+inline void CompactHuffmanHeader::make_run_codes(
+    const run_lengths_type& run_lengths, run_codes_type& run_codes) {
+  uint_fast16_t code = 0;
+  unsigned char previous_length = 0;
+
+  for (unsigned char length = 1; length < (1 << run_length_bits); ++length) {
+    for (size_t symbol = 0; symbol < RUN_SYMBOLS; ++symbol) {
+      if (run_lengths[symbol] == length) {
+        code <<= length - previous_length;
+        run_codes[symbol] = code++;
+        previous_length = length;
+      }
+    }
+  }
+}
+
+inline size_t CompactHuffmanHeader::table_bits(
+    const HuffmanCodeLengths& code_lengths) {
+  std::vector<Run> runs = make_runs(code_lengths);
+  size_t rle_bits = kind_bits;
+  size_t coded_bits = kind_bits + RUN_SYMBOLS * run_length_bits;
+
+  run_lengths_type run_lengths;
+  bool coded = make_run_lengths(runs, run_lengths);
+
+  for (auto&& run : runs) {
+    rle_bits += run_symbol_bits + extra_bits(run.symbol);
+    coded_bits += run_lengths[run.symbol] + extra_bits(run.symbol);
+  }
+
+  return coded ? std::min(rle_bits, coded_bits) : rle_bits;
+}
+
+template <typename OutputIterator>
+void CompactHuffmanHeader::write_table(const HuffmanCodeLengths& code_lengths,
+                                       BitWriter<OutputIterator>& bit_writer) {
+  std::vector<Run> runs = make_runs(code_lengths);
+  size_t rle_bits = 0;
+  size_t coded_bits = RUN_SYMBOLS * run_length_bits;
+
+  run_lengths_type run_lengths;
+  bool coded = make_run_lengths(runs, run_lengths);
+
+  for (auto&& run : runs) {
+    rle_bits += run_symbol_bits;
+    coded_bits += run_lengths[run.symbol];
+  }
+
+  if (!coded || rle_bits <= coded_bits) {
+    bit_writer.write(static_cast<unsigned char>(HUFFMAN_HEADER_RLE),
+                     kind_bits);
+
+    for (auto&& run : runs) {
+      bit_writer.write(run.symbol, run_symbol_bits);
+      bit_writer.write(run.extra, extra_bits(run.symbol));
+    }
+
+    return;
+  }
+
+  run_codes_type run_codes;
+  make_run_codes(run_lengths, run_codes);
+
+  bit_writer.write(static_cast<unsigned char>(HUFFMAN_HEADER_CODED),
+                   kind_bits);
+
+  for (auto&& length : run_lengths) {
+    bit_writer.write(length, run_length_bits);
+  }
+
+  for (auto&& run : runs) {
+    bit_writer.write(run_codes[run.symbol], run_lengths[run.symbol]);
+    bit_writer.write(run.extra, extra_bits(run.symbol));
+  }
+}
+
+template <typename InputIterator>
+bool CompactHuffmanHeader::read_table(unsigned char kind,
+                                      BitReader<InputIterator>& bit_reader,
+                                      HuffmanCodeLengths& code_lengths) {
+  if (kind != HUFFMAN_HEADER_RLE && kind != HUFFMAN_HEADER_CODED) {
+    return false;
+  }
+
+  run_lengths_type run_lengths;
+  run_codes_type run_codes;
+
+  if (kind == HUFFMAN_HEADER_CODED) {
+    for (auto&& length : run_lengths) {
+      if (!bit_reader) {
+        return false;
+      }
+
+      bit_reader.read(length, run_length_bits);
+    }
+
+    make_run_codes(run_lengths, run_codes);
+  }
+
+  // Sum of 2^(max_code_length - length), for checking Kraft's inequality
+  uint64_t kraft_sum = 0;
+  size_t i = 0;
+
+  while (i < code_lengths.size()) {
+    if (!bit_reader) {
+      return false;
+    }
+
+    unsigned char symbol;
+    if (kind == HUFFMAN_HEADER_RLE) {
+      bit_reader.read(symbol, run_symbol_bits);
+    } else {
+      symbol = read_run_symbol(bit_reader, run_lengths, run_codes);
+    }
+
+    if (symbol >= RUN_SYMBOLS) {
+      return false;
+    }
+
+    unsigned char extra = 0;
+    bit_reader.read(extra, extra_bits(symbol));
+
+    size_t count = 1;
+    unsigned char length = symbol;
+
+    if (symbol == REPEAT) {
+      if (i == 0) {
+        return false;
+      }
+
+      count = extra + 3;
+      length = code_lengths[i - 1];
+    } else if (symbol == SHORT_ZEROS) {
+      count = extra + 3;
+      length = 0;
+    } else if (symbol == LONG_ZEROS) {
+      count = extra + 11;
+      length = 0;
+    }
+
+    if (count > code_lengths.size() - i) {
+      return false;
+    }
+
+    for (; count--; ++i) {
+      code_lengths[i] = length;
+
+      if (length > 0) {
+        kraft_sum += uint64_t(1) << (max_code_length - length);
+      }
+    }
+  }
+
+  return kraft_sum > 0 && kraft_sum <= (uint64_t(1) << max_code_length);
+}
+
+template <typename InputIterator>
+unsigned char CompactHuffmanHeader::read_run_symbol(
+    BitReader<InputIterator>& bit_reader,
+    const run_lengths_type& run_lengths,
+    const run_codes_type& run_codes) {
+  uint_fast16_t code = 0;
+
+  for (unsigned char length = 1; length < (1 << run_length_bits); ++length) {
+    if (!bit_reader) {
+      break;
+    }
+
+    code = (code << 1) | bit_reader.read();
+
+    for (size_t symbol = 0; symbol < RUN_SYMBOLS; ++symbol) {
+      if (run_lengths[symbol] == length && run_codes[symbol] == code) {
+        return symbol;
+      }
+    }
+  }
+
+  return RUN_SYMBOLS;
+}
+
+#endif /* HUFFMAN_HEADER_H */
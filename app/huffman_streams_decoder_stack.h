@@ -0,0 +1,153 @@
+#ifndef HUFFMAN_STREAMS_DECODER_STACK_H
+#define HUFFMAN_STREAMS_DECODER_STACK_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <iterator>
+#include "huffman_streams_encoder_stack.h"
+#include "huffman_decoder_stack.h"
+
+/**
+ * A Worker that decodes streams encoded by HuffmanStreamsEncoderStack and
+ * writes them back with write_stream().
+ *
+ * @tparam streams the number of streams
+ * @tparam T       the type of the symbols
+ * @tparam H       the type of the Huffman headers (see RawHuffmanHeader)
+ */
+template <size_t streams, typename T = char, typename H = CompactHuffmanHeader>
+struct HuffmanStreamsDecoderStack
+    : SpanWorker<HuffmanStreamsDecoderStack<streams, T, H>, T> {
+  /**
+   * Decode a sequence of streams.
+   *
+   * @param begin a forward iterator referring to the beginning of the encoded
+   *              streams
+   * @param end   a forward iterator referring to past-the-end of the encoded
+   *              streams
+   * @param output_iterator an output iterator for writing the decoded streams
+   */
+  template <typename ForwardIterator, typename OutputIterator>
+  void operator()(ForwardIterator begin,
+                  ForwardIterator end,
+                  OutputIterator output_iterator);
+
+  /**
+   * Load the encoded streams in a buffer.
+   *
+   * @param[out] begin an input iterator referring to the beginning of the
+   *                   encoded streams
+   * @param      end   an input iterator referring to past-the-end of the
+   *                   encoded streams
+   * @param[out] input_buffer the buffer to load the encoded streams into
+   * @param      chunk_size   the maximum number of bytes to read; longer
+   *                          streams are truncated
+   * @return the number of bytes loaded
+   */
+  template <typename InputIterator>
+  static size_t prepare_input_buffer(InputIterator& begin,
+                                     InputIterator end,
+                                     T* input_buffer,
+                                     size_t chunk_size);
+
+  /**
+   * Forget the tables of the previous sequence.
+   */
+  void reset() {
+    for (auto&& decoder : _decoders) {
+      decoder.reset();
+    }
+  }
+
+  /**
+   * @return why the last sequence could not be decoded, DECODE_OK if it was
+   */
+  DecodeError error() const { return _error; }
+
+ private:
+  // Each stream keeps the table of its previous occurrence
+  std::array<HuffmanDecoderStack<T, H>, streams> _decoders;
+  DecodeError _error = DECODE_OK;
+};
+
+template <size_t streams, typename T, typename H>
+template <typename ForwardIterator, typename OutputIterator>
+void HuffmanStreamsDecoderStack<streams, T, H>::operator()(
+    ForwardIterator begin,
+    ForwardIterator end,
+    OutputIterator output_iterator) {
+  std::vector<T> stream;
+  _error = DECODE_OK;
+
+  for (size_t i = 0; i < streams; ++i) {
+    if (begin == end) {
+      _error = DECODE_TRUNCATED;
+      return;
+    }
+
+    char mode = *begin++;
+
+    if (mode == HUFFMAN_RAW_STREAM) {
+      bool complete;
+      begin = read_stream(begin, end, stream, &complete);
+      _error = complete ? DECODE_OK : DECODE_TRUNCATED;
+    } else {
+      stream.clear();
+      begin = _decoders[i].decode(begin, end, std::back_inserter(stream));
+      _error = _decoders[i].error();
+    }
+
+    if (_error != DECODE_OK) {
+      return;
+    }
+
+    write_stream(stream.begin(), stream.end(), output_iterator);
+  }
+}
+
+template <size_t streams, typename T, typename H>
+template <typename InputIterator>
+size_t HuffmanStreamsDecoderStack<streams, T, H>::prepare_input_buffer(
+    InputIterator& begin,
+    InputIterator end,
+    T* input_buffer,
+    size_t chunk_size) {
+  size_t current_chunk_size = 0;
+
+  for (size_t i = 0; i < streams && begin != end; ++i) {
+    if (chunk_size - current_chunk_size < 1 + sizeof(size_t)) {
+      break;
+    }
+
+    char mode = *begin;
+    input_buffer[current_chunk_size++] = mode;
+    ++begin;
+
+    if (mode == HUFFMAN_RAW_STREAM) {
+      size_t size;
+      BitReader<InputIterator> bit_reader(begin, end);
+      bit_reader.read(size);
+
+      *(reinterpret_cast<size_t*>(input_buffer + current_chunk_size)) = size;
+      current_chunk_size += sizeof(size);
+      size = std::min(size, chunk_size - current_chunk_size);
+
+      for (begin = bit_reader.next(); size-- && begin != end;
+           ++begin, ++current_chunk_size) {
+        input_buffer[current_chunk_size] = *begin;
+      }
+    } else {
+      current_chunk_size +=
+          HuffmanDecoderStack<T, H>::prepare_input_buffer(
+              begin,
+              end,
+              input_buffer + current_chunk_size,
+              chunk_size - current_chunk_size);
+    }
+  }
+
+  return current_chunk_size;
+}
+
+#endif /* HUFFMAN_STREAMS_DECODER_STACK_H */
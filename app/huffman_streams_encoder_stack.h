@@ -0,0 +1,106 @@
+#ifndef HUFFMAN_STREAMS_ENCODER_STACK_H
+#define HUFFMAN_STREAMS_ENCODER_STACK_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <iterator>
+#include "huffman_tree.h"
+#include "huffman_encoder.h"
+#include "huffman_header.h"
+#include "streams.h"
+#include "worker.h"
+
+static constexpr char HUFFMAN_RAW_STREAM = 0;
+static constexpr char HUFFMAN_ENCODED_STREAM = 1;
+
+/**
+ * A Worker that entropy codes each of a fixed number of streams (see
+ * write_stream()) with its own Huffman table.
+ *
+ * Every stream is preceded by a mode symbol: streams that Huffman coding would
+ * not shrink (e.g. short ones, or ones made of a single symbol) are copied as
+ * they are.
+ *
+ * @tparam streams the number of streams
+ * @tparam T       the type of the symbols
+ * @tparam H       the type of the Huffman headers (see RawHuffmanHeader)
+ */
+template <size_t streams, typename T = char, typename H = CompactHuffmanHeader>
+struct HuffmanStreamsEncoderStack
+    : SpanWorker<HuffmanStreamsEncoderStack<streams, T, H>, T> {
+  static_assert(sizeof(T) == 1, "the Huffman header has 256 entries");
+
+  /**
+   * Encode a sequence of streams.
+   *
+   * @param begin a forward iterator referring to the beginning of the streams
+   *              to encode
+   * @param end   a forward iterator referring to past-the-end of the streams
+   *              to encode
+   * @param output_iterator an output iterator for writing the encoded streams
+   */
+  template <typename ForwardIterator, typename OutputIterator>
+  void operator()(ForwardIterator begin,
+                  ForwardIterator end,
+                  OutputIterator output_iterator) {
+    std::vector<T> stream;
+
+    for (size_t i = 0; i < streams; ++i) {
+      begin = read_stream(begin, end, stream);
+      encode_stream(stream, _headers[i], output_iterator);
+    }
+  }
+
+  /**
+   * Each stream is either coded or copied, whichever is shorter, so only the
+   * mode symbols expand the input.
+   *
+   * @param input_size the size of the streams to encode
+   * @return the maximum number of bytes written by operator()
+   */
+  static size_t bound(size_t input_size) { return input_size + streams; }
+
+  /**
+   * Forget the tables of the previous sequence.
+   */
+  void reset() { _headers.fill(H()); }
+
+ private:
+  // Each stream keeps the table of its previous occurrence
+  std::array<H, streams> _headers;
+
+  template <typename OutputIterator>
+  static void encode_stream(const std::vector<T>& stream,
+                            H& header,
+                            OutputIterator& output_iterator);
+};
+
+template <size_t streams, typename T, typename H>
+template <typename OutputIterator>
+void HuffmanStreamsEncoderStack<streams, T, H>::encode_stream(
+    const std::vector<T>& stream, H& header, OutputIterator& output_iterator) {
+  HuffmanTree<T> tree(stream.begin(), stream.end());
+
+  // Only commit to the new header if the stream is Huffman coded
+  H new_header(header);
+  std::vector<T> header_buffer;
+  auto encoder = new_header.write(tree, std::back_inserter(header_buffer));
+
+  size_t bits = encoder.encoded_bits(tree);
+  size_t raw_size = sizeof(size_t) + stream.size();
+  size_t encoded_size = header_buffer.size() + bits / 8 + (bits % 8 != 0);
+
+  if (encoded_size < raw_size) {
+    header = new_header;
+    *output_iterator++ = HUFFMAN_ENCODED_STREAM;
+    output_iterator =
+        std::copy(header_buffer.begin(), header_buffer.end(), output_iterator);
+    encoder(stream.begin(), stream.end(), output_iterator);
+  } else {
+    *output_iterator++ = HUFFMAN_RAW_STREAM;
+    write_stream(stream.begin(), stream.end(), output_iterator);
+  }
+}
+
+#endif /* HUFFMAN_STREAMS_ENCODER_STACK_H */
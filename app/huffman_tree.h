@@ -31,7 +31,8 @@ class HuffmanTree : public HuffmanTreeBase<T, W> {
    * @return the frequency of the specified symbol
    */
   W frequency(const T& symbol) const {
-    return _symbol_frequency_pairs.at(symbol);
+    auto it = _symbol_frequency_pairs.find(symbol);
+    return it != _symbol_frequency_pairs.end() ? it->second : W();
   }
 
  private:
@@ -78,7 +79,8 @@ HuffmanTree<T, W>::HuffmanTree(InputIterator begin, InputIterator end) {
     queue.push(new_node);
   }
 
-  this->_root = queue.top();
+  // An empty sequence still gets a (childless) root
+  this->_root = queue.empty() ? new node_type() : queue.top();
 }
 
 #endif /* HUFFMAN_TREE_H */
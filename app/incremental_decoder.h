@@ -0,0 +1,811 @@
+#ifndef INCREMENTAL_DECODER_H
+#define INCREMENTAL_DECODER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "bit_reader.h"
+#include "canonical_huffman_tree.h"
+#include "checksum.h"
+#include "container.h"
+#include "frames.h"
+#include "huffman_header.h"
+#include "lzss_grouped_encoder.h"
+#include "parallel.h"
+#include "preset_dictionary.h"
+#include "utils.h"
+
+/**
+ * A decoder for the containers written by encode_in_parallel() or compress()
+ * that is fed the container a block at a time and from which the decoded
+ * sequence is pulled a block at a time, in constant memory: the LZSS window,
+ * the input buffer and the Huffman table of the current frame, whatever the
+ * size of the container and of its chunks.
+ *
+ * Frames are decoded as their bytes arrive instead of being read whole: each
+ * Huffman code is decoded into a byte of LZSS tokens, and each token into
+ * symbols at once, the count of tokens that ends the frame being held back
+ * until the frame ends. Decoding pauses anywhere in a frame, in the middle of
+ * a match too, when the output is full or the input runs out.
+ *
+ * Containers from version 2 on are decoded, unless their chunks hold token
+ * streams, refer to earlier chunks, or are those of an archive: these need
+ * whole chunks in memory (see decompress() and extract_archive()).
+ *
+ * A frame is only known to be valid once it ends (its count of tokens, and
+ * its checksum if it has one), so the symbols pulled before an error is
+ * found are not taken back: the caller discards them if error() is set.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ */
+template <bits_t position_bits = 12, bits_t length_bits = 4>
+class IncrementalDecoder {
+ public:
+  // The size of the input buffer unless another one is given
+  static constexpr size_t default_input_buffer_size = 64 * 1024;
+
+  /**
+   * Construct an IncrementalDecoder.
+   *
+   * @param dictionary        the preset dictionary the containers were
+   *                          encoded with, if any
+   * @param input_buffer_size the size of the buffer the input is fed to, at
+   *                          least large enough for any header
+   */
+  explicit IncrementalDecoder(
+      const PresetDictionary<>& dictionary = PresetDictionary<>(),
+      size_t input_buffer_size = default_input_buffer_size);
+
+  /**
+   * Feed the next bytes of the container.
+   *
+   * @param data a pointer to the bytes
+   * @param size the number of bytes
+   * @return the number of bytes taken, fewer than @c size if the input
+   *         buffer is full: the others are fed again after pull()
+   */
+  size_t feed(const void* data, size_t size);
+
+  /**
+   * Tell that the whole container was fed, so that a container cut short is
+   * rejected rather than waited for.
+   */
+  void finish() { _finished = true; }
+
+  /**
+   * Decode what was fed so far, as far as it fits.
+   *
+   * @param destination a pointer to the memory the decoded symbols are
+   *                    written to
+   * @param capacity    the size of that memory
+   * @return the number of symbols written; fewer than @c capacity if more
+   *         input is needed, the container is done() or an error() was found
+   */
+  size_t pull(void* destination, size_t capacity);
+
+  /**
+   * @return whether or not the whole container was decoded
+   */
+  bool done() const { return _state == STATE_DONE; }
+
+  /**
+   * @return why the container could not be decoded, DECODE_OK if no error
+   *         was found so far
+   */
+  DecodeError error() const { return _error; }
+
+  /**
+   * Make the decoder ready for the next container, keeping its buffers.
+   */
+  void reset();
+
+ private:
+  enum State {
+    STATE_CONTAINER_HEADER,
+    STATE_FRAME_HEADER,
+    STATE_STORED,
+    STATE_TOKENS,
+    STATE_HUFFMAN_HEADER,
+    STATE_HUFFMAN_CODES,
+    STATE_SKIP,
+    STATE_TRAILER,
+    STATE_DONE,
+    STATE_FAILED
+  };
+
+  typedef typename HuffmanTreeBase<char, size_t>::ptr_type node_ptr;
+
+  static constexpr size_t minimum_match_length =
+      get_minimum_match_length(position_bits, length_bits);
+  static constexpr size_t match_bits = 1 + position_bits + length_bits;
+  static constexpr size_t grouped_match_size =
+      get_grouped_match_size(position_bits, length_bits);
+  static constexpr size_t max_dictionary_size = max_size(position_bits);
+  static constexpr size_t window_size = size_t(1) << position_bits;
+  static constexpr size_t max_huffman_header_size =
+      RawHuffmanHeader::max_size > CompactHuffmanHeader::max_size
+          ? RawHuffmanHeader::max_size
+          : CompactHuffmanHeader::max_size;
+  // Large enough for a Huffman header and the frame header before it
+  static constexpr size_t min_input_buffer_size = 1024;
+
+  // A token and the next byte fit in the buffer of the tokens
+  static_assert(match_bits + 7 <= 32, "LZSS tokens are too long");
+
+  std::vector<char> _preset;
+  uint32_t _dictionary_id;
+
+  // The bytes fed but not decoded yet are [_input_begin, _input_end)
+  std::vector<char> _input;
+  size_t _input_begin = 0;
+  size_t _input_end = 0;
+  bool _finished = false;
+
+  State _state = STATE_CONTAINER_HEADER;
+  DecodeError _error = DECODE_OK;
+
+  // How the chunks of the container were encoded
+  bool _sized = true;
+  bool _compact = true;
+  bool _primed = false;
+  bool _checksums = false;
+  bool _grouped = false;
+  size_t _chunk_size = 0;
+
+  // The data of the current frame left to read, if the frame is sized, and
+  // the size and checksum of its chunk so far
+  size_t _frame_remaining = 0;
+  size_t _frame_output = 0;
+  uint32_t _checksum = 0;
+
+  RawHuffmanHeader _raw_header;
+  CompactHuffmanHeader _compact_header;
+  std::unique_ptr<CanonicalHuffmanTree<char>> _tree;
+  node_ptr _node = nullptr;
+  // The encoded bits left to read, and the bits left in the current byte
+  size_t _code_bits = 0;
+  unsigned char _code_byte = 0;
+  unsigned char _code_byte_bits = 0;
+
+  // The bits of the token being read, the number of tokens read, the flags
+  // left of the current group if they are grouped, and the last bytes of the
+  // tokens, which end with their count
+  uint32_t _token_bits = 0;
+  size_t _token_bit_count = 0;
+  size_t _tokens = 0;
+  unsigned char _group_flags = 0;
+  size_t _group_tokens = 0;
+  unsigned char _held_back[sizeof(size_t)];
+  size_t _held_back_size = 0;
+  size_t _held_back_next = 0;
+
+  // The last symbols decoded, of which the last _window_size may be referred
+  // to, and what is left to copy of the current match
+  std::vector<char> _window;
+  size_t _window_position = 0;
+  size_t _window_size = 0;
+  size_t _match_distance = 0;
+  size_t _match_length = 0;
+
+  // The memory pull() writes to, and where its symbols of the current frame
+  // that are not checksummed yet begin
+  char* _output = nullptr;
+  char* _output_end = nullptr;
+  const char* _checksum_from = nullptr;
+
+  const char* input() const { return _input.data() + _input_begin; }
+  size_t available() const { return _input_end - _input_begin; }
+  void consume(size_t size) { _input_begin += size; }
+
+  bool fail(DecodeError error) {
+    _error = error;
+    _state = STATE_FAILED;
+    return false;
+  }
+
+  // Each step returns false when it cannot go on without more input or more
+  // room for the output, or on error
+  bool step();
+  bool read_container_header();
+  bool read_frame_header();
+  bool copy_stored();
+  bool read_tokens();
+  bool read_huffman_header();
+  bool read_huffman_codes();
+  bool skip();
+  bool read_trailer();
+
+  template <typename H>
+  bool read_table(H& header, BitReader<const char*>& bit_reader, size_t& bits);
+
+  void start_chunk();
+  void restart_window();
+  bool add_token_byte(unsigned char byte);
+  bool decode_token();
+  bool decode_grouped_token();
+  bool decode_literal(char symbol);
+  bool decode_match(uint32_t token);
+  bool end_tokens();
+  void copy_match();
+  void sum();
+};
+
+template <bits_t position_bits, bits_t length_bits>
+IncrementalDecoder<position_bits, length_bits>::IncrementalDecoder(
+    const PresetDictionary<>& dictionary, size_t input_buffer_size)
+    : _dictionary_id(dictionary.id()),
+      _input(std::max(input_buffer_size, size_t(min_input_buffer_size))),
+      _window(window_size) {
+  // Only the end of the preset dictionary is in the window
+  Span<const char> content = dictionary.content();
+  _preset.assign(
+      content.end() - std::min(content.size(), size_t(max_dictionary_size)),
+      content.end());
+}
+
+template <bits_t position_bits, bits_t length_bits>
+size_t IncrementalDecoder<position_bits, length_bits>::feed(const void* data,
+                                                           size_t size) {
+  if (_input.size() - _input_end < size && _input_begin) {
+    std::memmove(_input.data(), input(), available());
+    _input_end -= _input_begin;
+    _input_begin = 0;
+  }
+
+  size = std::min(size, _input.size() - _input_end);
+  std::memcpy(_input.data() + _input_end, data, size);
+  _input_end += size;
+  return size;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+size_t IncrementalDecoder<position_bits, length_bits>::pull(void* destination,
+                                                           size_t capacity) {
+  char* output = static_cast<char*>(destination);
+  _output = output;
+  _output_end = output + capacity;
+  _checksum_from = output;
+
+  while (step()) {
+  }
+
+  sum();
+  return _output - output;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+void IncrementalDecoder<position_bits, length_bits>::reset() {
+  _input_begin = 0;
+  _input_end = 0;
+  _finished = false;
+  _state = STATE_CONTAINER_HEADER;
+  _error = DECODE_OK;
+  _match_length = 0;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::step() {
+  // The match cut by the end of the previous output comes first
+  if (_match_length) {
+    copy_match();
+
+    if (_match_length) {
+      return false;
+    }
+  }
+
+  switch (_state) {
+    case STATE_CONTAINER_HEADER:
+      return read_container_header();
+    case STATE_FRAME_HEADER:
+      return read_frame_header();
+    case STATE_STORED:
+      return copy_stored();
+    case STATE_TOKENS:
+      return read_tokens();
+    case STATE_HUFFMAN_HEADER:
+      return read_huffman_header();
+    case STATE_HUFFMAN_CODES:
+      return read_huffman_codes();
+    case STATE_SKIP:
+      return skip();
+    case STATE_TRAILER:
+      return read_trailer();
+    case STATE_DONE:
+    case STATE_FAILED:
+      break;
+  }
+
+  return false;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_container_header() {
+  if (available() < ContainerHeader::max_size && !_finished) {
+    return false;
+  }
+
+  const char* begin = input();
+  ContainerHeader header;
+  bool found = header.read(begin, input() + available());
+
+  // Token streams, references and archives need whole chunks
+  if (!found || !header.supported() ||
+      header.dictionary_id != _dictionary_id || !header.framed() ||
+      header.has(CONTAINER_TOKEN_STREAMS) || header.has(CONTAINER_DEDUP) ||
+      header.has(CONTAINER_ARCHIVE)) {
+    return fail(DECODE_UNSUPPORTED);
+  }
+
+  consume(begin - input());
+
+  _sized = header.sized_frames();
+  _compact = header.compact_huffman();
+  _primed = header.has(CONTAINER_PRIMED);
+  _checksums = header.sized_frames() && header.has(CONTAINER_CHECKSUMS);
+  _grouped = header.has(CONTAINER_GROUPED_FLAGS);
+  _chunk_size = header.has(CONTAINER_CHUNK_SIZE) ? header.chunk_size
+                                                 : DEFAULT_CHUNK_SIZE;
+
+  restart_window();
+  _state = STATE_FRAME_HEADER;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_frame_header() {
+  if (!available()) {
+    if (_finished) {
+      _state = STATE_DONE;
+    }
+    return false;
+  }
+
+  char type = input()[0];
+
+  // Complete frames of older versions are only as long as their Huffman
+  // table says
+  if (type == FRAME_COMPLETE && !_sized) {
+    consume(1);
+    start_chunk();
+    _state = STATE_HUFFMAN_HEADER;
+    return true;
+  }
+
+  if (available() < Frame<>::max_header_size) {
+    return _finished ? fail(DECODE_TRUNCATED) : false;
+  }
+
+  size_t size;
+  std::memcpy(&size, input() + 1, sizeof(size));
+  consume(Frame<>::max_header_size);
+
+  if (_checksums) {
+    if (size < sizeof(uint32_t)) {
+      return fail(DECODE_INVALID_FRAME);
+    }
+    size -= sizeof(uint32_t);
+  }
+
+  switch (type) {
+    case FRAME_STORED:
+      if (size > _chunk_size) {
+        return fail(DECODE_INVALID_FRAME);
+      }
+      _state = STATE_STORED;
+      break;
+    case FRAME_FIRST_STAGE:
+      _state = STATE_TOKENS;
+      break;
+    case FRAME_COMPLETE:
+      _state = STATE_HUFFMAN_HEADER;
+      break;
+    default:
+      // References only appear in deduplicated containers
+      return fail(DECODE_INVALID_FRAME);
+  }
+
+  _frame_remaining = size;
+  start_chunk();
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::copy_stored() {
+  if (!_frame_remaining) {
+    _state = STATE_TRAILER;
+    return true;
+  }
+
+  size_t size = std::min(
+      {_frame_remaining, available(), size_t(_output_end - _output)});
+  if (!size) {
+    return !available() && _finished ? fail(DECODE_TRUNCATED) : false;
+  }
+
+  const char* data = input();
+  std::memcpy(_output, data, size);
+  _output += size;
+
+  // Only the last symbols stay in the window
+  for (size_t i = size - std::min(size, size_t(max_dictionary_size));
+       i < size;
+       ++i) {
+    _window[_window_position++ & (window_size - 1)] = data[i];
+  }
+  _window_size = std::min(_window_size + size, size_t(max_dictionary_size));
+
+  consume(size);
+  _frame_remaining -= size;
+  _frame_output += size;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_tokens() {
+  for (; _frame_remaining; --_frame_remaining) {
+    if (_output == _output_end) {
+      return false;
+    }
+
+    if (!available()) {
+      return _finished ? fail(DECODE_TRUNCATED) : false;
+    }
+
+    unsigned char byte = input()[0];
+    consume(1);
+
+    if (!add_token_byte(byte)) {
+      return false;
+    }
+  }
+
+  if (!end_tokens()) {
+    return false;
+  }
+
+  _state = STATE_TRAILER;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_huffman_header() {
+  size_t size = _sized ? std::min(available(), _frame_remaining) : available();
+  bool whole = _finished || (_sized && _frame_remaining <= available());
+
+  if (size < max_huffman_header_size && !whole) {
+    return false;
+  }
+
+  BitReader<const char*> bit_reader(input(), input() + size);
+  size_t bits = 0;
+  bool valid = _compact ? read_table(_compact_header, bit_reader, bits)
+                        : read_table(_raw_header, bit_reader, bits);
+
+  if (!valid) {
+    return fail(bit_reader.overrun() ? DECODE_TRUNCATED : DECODE_INVALID_CODE);
+  }
+
+  // The encoded symbols start at the first byte after the header
+  size_t header_size = bit_reader.next() - input();
+  consume(header_size);
+  if (_sized) {
+    _frame_remaining -= header_size;
+  }
+
+  _node = _tree->root();
+  _code_bits = bits;
+  _code_byte_bits = 0;
+  _state = STATE_HUFFMAN_CODES;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+template <typename H>
+bool IncrementalDecoder<position_bits, length_bits>::read_table(
+    H& header, BitReader<const char*>& bit_reader, size_t& bits) {
+  // Every chunk has its own table (see Splitter)
+  header = H();
+
+  if (!header.read(bit_reader, bits) || bit_reader.overrun()) {
+    return false;
+  }
+
+  const auto& code_lengths = header.code_lengths();
+  _tree.reset(
+      new CanonicalHuffmanTree<char>(code_lengths.data(), code_lengths.size()));
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_huffman_codes() {
+  node_ptr root = _tree->root();
+
+  for (; _code_bits; --_code_bits) {
+    // A code may complete a token
+    if (_output == _output_end) {
+      return false;
+    }
+
+    if (!_code_byte_bits) {
+      if (_sized && !_frame_remaining) {
+        return fail(DECODE_TRUNCATED);
+      }
+
+      if (!available()) {
+        return _finished ? fail(DECODE_TRUNCATED) : false;
+      }
+
+      _code_byte = input()[0];
+      _code_byte_bits = 8;
+      consume(1);
+      if (_sized) {
+        --_frame_remaining;
+      }
+    }
+
+    bool bit = (_code_byte >> --_code_byte_bits) & 1;
+    _node = bit ? _node->right : _node->left;
+
+    // A missing child is a code no symbol has
+    if (!_node) {
+      return fail(DECODE_INVALID_CODE);
+    }
+
+    if (_node->leaf()) {
+      unsigned char symbol = _node->data.symbol;
+      _node = root;
+
+      if (!add_token_byte(symbol)) {
+        return false;
+      }
+    }
+  }
+
+  // The last code must be complete
+  if (_node != root) {
+    return fail(DECODE_INVALID_CODE);
+  }
+
+  if (!end_tokens()) {
+    return false;
+  }
+
+  _state = _sized ? STATE_SKIP : STATE_TRAILER;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::skip() {
+  if (!_frame_remaining) {
+    _state = STATE_TRAILER;
+    return true;
+  }
+
+  size_t size = std::min(_frame_remaining, available());
+  if (!size) {
+    return _finished ? fail(DECODE_TRUNCATED) : false;
+  }
+
+  consume(size);
+  _frame_remaining -= size;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::read_trailer() {
+  if (_checksums) {
+    uint32_t checksum;
+    if (available() < sizeof(checksum)) {
+      return _finished ? fail(DECODE_TRUNCATED) : false;
+    }
+
+    std::memcpy(&checksum, input(), sizeof(checksum));
+    consume(sizeof(checksum));
+
+    sum();
+    if (checksum != _checksum) {
+      return fail(DECODE_CHECKSUM_MISMATCH);
+    }
+  }
+
+  _state = STATE_FRAME_HEADER;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+void IncrementalDecoder<position_bits, length_bits>::start_chunk() {
+  _frame_output = 0;
+  _checksum = 0;
+  _checksum_from = _output;
+
+  _token_bits = 0;
+  _token_bit_count = 0;
+  _tokens = 0;
+  _group_tokens = 0;
+  _held_back_size = 0;
+  _held_back_next = 0;
+
+  // Chunks that are not primed start from the preset dictionary, if any
+  if (!_primed) {
+    restart_window();
+  }
+}
+
+template <bits_t position_bits, bits_t length_bits>
+void IncrementalDecoder<position_bits, length_bits>::restart_window() {
+  std::copy(_preset.begin(), _preset.end(), _window.begin());
+  _window_position = _preset.size();
+  _window_size = _preset.size();
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::add_token_byte(
+    unsigned char byte) {
+  unsigned char& slot = _held_back[_held_back_next];
+  _held_back_next = (_held_back_next + 1) % sizeof(_held_back);
+
+  // The last bytes may be the count of tokens rather than tokens
+  if (_held_back_size < sizeof(_held_back)) {
+    slot = byte;
+    ++_held_back_size;
+    return true;
+  }
+
+  _token_bits = (_token_bits << 8) | slot;
+  _token_bit_count += 8;
+  slot = byte;
+
+  // No byte completes two tokens
+  return _grouped ? decode_grouped_token() : decode_token();
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::decode_token() {
+  bool flag = (_token_bits >> (_token_bit_count - 1)) & 1;
+
+  if (flag == LZSS_UNENCODED_FLAG) {
+    if (_token_bit_count < 9) {
+      return true;
+    }
+
+    _token_bit_count -= 9;
+    char symbol = static_cast<char>(_token_bits >> _token_bit_count);
+    _token_bits &= (uint32_t(1) << _token_bit_count) - 1;
+    return decode_literal(symbol);
+  }
+
+  if (_token_bit_count < match_bits) {
+    return true;
+  }
+
+  _token_bit_count -= match_bits;
+  uint32_t token = _token_bits >> _token_bit_count;
+  _token_bits &= (uint32_t(1) << _token_bit_count) - 1;
+  return decode_match(token);
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::decode_grouped_token() {
+  // A control byte holds the flags of the next tokens
+  if (!_group_tokens) {
+    _group_flags = static_cast<unsigned char>(_token_bits);
+    _group_tokens = LZSS_GROUP_SIZE;
+    _token_bits = 0;
+    _token_bit_count = 0;
+    return true;
+  }
+
+  bool flag = _group_flags & 0x80;
+
+  if (flag == LZSS_ENCODED_FLAG &&
+      _token_bit_count < 8 * grouped_match_size) {
+    return true;
+  }
+
+  uint32_t token = _token_bits;
+  _token_bits = 0;
+  _token_bit_count = 0;
+  _group_flags = static_cast<unsigned char>(_group_flags << 1);
+  --_group_tokens;
+
+  return flag == LZSS_UNENCODED_FLAG ? decode_literal(static_cast<char>(token))
+                                     : decode_match(token);
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::decode_literal(
+    char symbol) {
+  ++_tokens;
+
+  if (_frame_output == _chunk_size) {
+    return fail(DECODE_OUTPUT_OVERFLOW);
+  }
+
+  *_output++ = symbol;
+  _window[_window_position++ & (window_size - 1)] = symbol;
+  _window_size = std::min(_window_size + 1, size_t(max_dictionary_size));
+  ++_frame_output;
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::decode_match(
+    uint32_t token) {
+  ++_tokens;
+
+  size_t position = (token >> length_bits) & max_size(position_bits);
+  size_t length = (token & max_size(length_bits)) + minimum_match_length;
+
+  // A position of 0 wraps around, past the size of the window
+  if (position - 1 >= _window_size) {
+    return fail(DECODE_INVALID_MATCH);
+  }
+
+  if (length > _chunk_size - _frame_output) {
+    return fail(DECODE_OUTPUT_OVERFLOW);
+  }
+
+  _frame_output += length;
+  _match_distance = position;
+  _match_length = length;
+  copy_match();
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+bool IncrementalDecoder<position_bits, length_bits>::end_tokens() {
+  size_t count;
+  if (_held_back_size < sizeof(count)) {
+    return fail(DECODE_TRUNCATED);
+  }
+
+  unsigned char bytes[sizeof(count)];
+  for (size_t i = 0; i < sizeof(count); ++i) {
+    bytes[i] = _held_back[(_held_back_next + i) % sizeof(count)];
+  }
+  std::memcpy(&count, bytes, sizeof(count));
+
+  if (_tokens < count) {
+    return fail(DECODE_TRUNCATED);
+  }
+
+  // Only the padding of the last token may lie between it and the count, and
+  // a control byte is followed by a token at least
+  if (_tokens > count || _token_bit_count >= 8 ||
+      _group_tokens == LZSS_GROUP_SIZE) {
+    return fail(DECODE_TRAILING_DATA);
+  }
+
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+void IncrementalDecoder<position_bits, length_bits>::copy_match() {
+  size_t size = std::min(_match_length, size_t(_output_end - _output));
+
+  // Symbol by symbol, since a match may repeat its own symbols
+  for (size_t i = 0; i < size; ++i) {
+    char symbol =
+        _window[(_window_position - _match_distance) & (window_size - 1)];
+    _window[_window_position++ & (window_size - 1)] = symbol;
+    *_output++ = symbol;
+  }
+
+  _window_size = std::min(_window_size + size, size_t(max_dictionary_size));
+  _match_length -= size;
+}
+
+template <bits_t position_bits, bits_t length_bits>
+void IncrementalDecoder<position_bits, length_bits>::sum() {
+  if (_checksums) {
+    _checksum =
+        CRC32C::extend(_checksum, _checksum_from, _output - _checksum_from);
+  }
+  _checksum_from = _output;
+}
+
+#endif /* INCREMENTAL_DECODER_H */
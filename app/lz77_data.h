@@ -36,6 +36,27 @@ class LZ77Data {
         _lookahead_buffer_end(begin),
         _end(end) {}
 
+  /**
+   * Construct a LZ77Data whose dictionary starts with the symbols that
+   * precede the sequence to encode (only the last @c max_dictionary_size of
+   * them are kept).
+   *
+   * @param dictionary_begin an iterator referring to the beginning of the
+   *                         symbols preceding the sequence to encode
+   * @param begin an iterator referring to the beginning of a sequence to
+   *              encode, and to past-the-end of the preceding symbols
+   * @param end   an iterator referring to past-the-end of a sequence to encode
+   */
+  LZ77Data(iterator dictionary_begin, iterator begin, iterator end)
+      : _dictionary_begin(dictionary_begin),
+        _lookahead_buffer_begin(begin),
+        _lookahead_buffer_end(begin),
+        _end(end) {
+    if (dictionary_size() > max_dictionary_size) {
+      std::advance(_dictionary_begin, dictionary_size() - max_dictionary_size);
+    }
+  }
+
   /**
    * @return an iterator referring to the beginning of the dictionary
    */
@@ -32,6 +32,10 @@ struct LZ77MatchRetriever {
 /**
  * A functor that decodes a sequence of symbols encoded with LZ77.
  *
+ * Tokens cut by the end of the input and matches that begin before the
+ * dictionary stop the decoding (see error()): each match is checked once,
+ * against the size of the dictionary, rather than each symbol it copies.
+ *
  * @tparam position_bits the number of bits used to encode the match position
  * @tparam length_bits   the number of bits used to encode the match length
  * @tparam T             the type of the symbols
@@ -51,29 +55,87 @@ class LZ77Decoder {
    * @param output_iterator an output iterator for writing the decoded sequence
    * @param times           the number of matches to process
    * @param match_retriever the functor to use for retrieving single matches
+   * @return an input iterator referring to past-the-end of the last token
+   *         read; error() tells whether the sequence could be decoded
    */
   template <
       typename InputIterator,
       typename OutputIterator,
       typename MatchRetriever = LZ77MatchRetriever<position_bits, length_bits>>
-  void operator()(InputIterator begin,
-                  InputIterator end,
-                  OutputIterator output_iterator,
-                  size_t times = std::numeric_limits<size_t>::max(),
-                  MatchRetriever match_retriever = MatchRetriever());
+  InputIterator operator()(InputIterator begin,
+                           InputIterator end,
+                           OutputIterator output_iterator,
+                           size_t times = std::numeric_limits<size_t>::max(),
+                           MatchRetriever match_retriever = MatchRetriever());
+
+  /**
+   * @return UNKNOWN_BOUND, since a corrupted input may expand without limit
+   */
+  static size_t bound(size_t) { return UNKNOWN_BOUND; }
 
   /**
    * Remove all symbols from the internal dictionary.
    */
   void clear() { _dictionary.clear(); }
 
- private:
-  typedef std::deque<T> dictionary_type;
-  dictionary_type _dictionary;
+  /**
+   * @return why the last sequence could not be decoded, DECODE_OK if it was
+   */
+  DecodeError error() const { return _error; }
 
+  /**
+   * Replace the internal dictionary with the symbols that precede the
+   * sequence to decode, so that matches may refer to them; only the last
+   * @c max_dictionary_size of them are kept.
+   *
+   * @param begin an input iterator referring to the beginning of the symbols
+   * @param end   an input iterator referring to past-the-end of the symbols
+   */
+  template <typename InputIterator>
+  void prime(InputIterator begin, InputIterator end) {
+    _dictionary.assign(begin, end);
+    resize_dictionary();
+  }
+
+ protected:
   static constexpr size_t max_dictionary_size = max_size(position_bits);
   typedef Match<max_dictionary_size, max_size(length_bits)> match_type;
 
+  DecodeError _error = DECODE_OK;
+
+  /**
+   * Write the symbols referred by a match and, optionally, a symbol.
+   *
+   * @param output_iterator an output iterator for writing the decoded symbols
+   * @param[in] match       the match to copy from the dictionary
+   * @param append_symbol   whether or not @c symbol has to be written
+   * @param symbol          the symbol to write after the match
+   * @return false, with DECODE_INVALID_MATCH as error(), if the match begins
+   *         before the dictionary
+   */
+  template <typename OutputIterator>
+  bool decode(OutputIterator& output_iterator,
+              const match_type& match,
+              bool append_symbol,
+              symbol_type symbol);
+
+  /**
+   * Write symbols that are not part of a match, resizing the dictionary once
+   * for all of them.
+   *
+   * @param output_iterator an output iterator for writing the decoded symbols
+   * @param[in] symbols     a pointer to the symbols to write
+   * @param count           the number of symbols to write
+   */
+  template <typename OutputIterator>
+  void decode_symbols(OutputIterator& output_iterator,
+                      const symbol_type* symbols,
+                      size_t count);
+
+ private:
+  typedef std::deque<T> dictionary_type;
+  dictionary_type _dictionary;
+
   template <typename OutputIterator>
   void write_symbol(OutputIterator& output_iterator, symbol_type symbol);
 
@@ -84,32 +146,80 @@ template <bits_t position_bits, bits_t length_bits, typename T>
 template <typename InputIterator,
           typename OutputIterator,
           typename MatchRetriever>
-inline void LZ77Decoder<position_bits, length_bits, T>::operator()(
+inline InputIterator LZ77Decoder<position_bits, length_bits, T>::operator()(
     InputIterator begin,
     InputIterator end,
     OutputIterator output_iterator,
     size_t times,
     MatchRetriever match_retriever) {
   BitReader<InputIterator> bit_reader(begin, end);
+  size_t steps = 0;
+  _error = DECODE_OK;
 
-  for (size_t steps = 0; steps < times && bit_reader; ++steps) {
+  for (; steps < times && bit_reader; ++steps) {
     match_type match;
-    symbol_type symbol;
+    symbol_type symbol = symbol_type();
 
     bool append_symbol = match_retriever(bit_reader, match, symbol);
 
-    for (size_t i = _dictionary.size() - match.position, j = 0;
-         j < match.length;
-         ++j) {
-      write_symbol(output_iterator, _dictionary[i + (j % match.position)]);
+    // A token cut by the end of the input is not decoded
+    if (bit_reader.overrun()) {
+      _error = DECODE_TRUNCATED;
+      break;
     }
 
-    if (append_symbol) {
-      write_symbol(output_iterator, symbol);
+    if (!decode(output_iterator, match, append_symbol, symbol)) {
+      break;
     }
+  }
 
-    resize_dictionary();
+  // Fewer tokens than announced
+  if (_error == DECODE_OK && steps < times &&
+      times != std::numeric_limits<size_t>::max()) {
+    _error = DECODE_TRUNCATED;
+  }
+
+  return bit_reader.next();
+}
+
+template <bits_t position_bits, bits_t length_bits, typename T>
+template <typename OutputIterator>
+inline bool LZ77Decoder<position_bits, length_bits, T>::decode(
+    OutputIterator& output_iterator,
+    const match_type& match,
+    bool append_symbol,
+    symbol_type symbol) {
+  // A position of 0 wraps around, past the size of the dictionary
+  if (match.length && size_t(match.position) - 1 >= _dictionary.size()) {
+    _error = DECODE_INVALID_MATCH;
+    return false;
+  }
+
+  for (size_t i = _dictionary.size() - match.position, j = 0;
+       j < match.length;
+       ++j) {
+    write_symbol(output_iterator, _dictionary[i + (j % match.position)]);
+  }
+
+  if (append_symbol) {
+    write_symbol(output_iterator, symbol);
+  }
+
+  resize_dictionary();
+  return true;
+}
+
+template <bits_t position_bits, bits_t length_bits, typename T>
+template <typename OutputIterator>
+inline void LZ77Decoder<position_bits, length_bits, T>::decode_symbols(
+    OutputIterator& output_iterator,
+    const symbol_type* symbols,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    write_symbol(output_iterator, symbols[i]);
   }
+
+  resize_dictionary();
 }
 
 template <bits_t position_bits, bits_t length_bits, typename T>
@@ -38,28 +38,35 @@ typename LZ77NaiveDictionary<max_dictionary_size,
 LZ77NaiveDictionary<max_dictionary_size,
                     max_lookahead_buffer_size,
                     T>::find_match(const Data& data) const {
-  // Find a match (without repetition)
-  auto dictionary_current = data.dictionary_begin();
+  // Find a match (without repetition), trying the closest symbols first so
+  // that they win ties: no match is longer than the lookahead buffer, so the
+  // search stops at the first that long rather than going through the whole
+  // dictionary for each symbol of a long run
+  auto dictionary_begin = data.dictionary_begin();
   auto dictionary_end = data.dictionary_end();
-
-  size_t current_position = data.dictionary_size();
+  auto lookahead_buffer_begin = data.lookahead_buffer_begin();
+  auto lookahead_buffer_end = data.lookahead_buffer_end();
+  size_t lookahead_buffer_size = lookahead_buffer_end - lookahead_buffer_begin;
   match_type match;
 
-  for (; dictionary_current != dictionary_end;
-       ++dictionary_current, --current_position) {
+  for (auto dictionary_current = dictionary_end;
+       dictionary_current != dictionary_begin &&
+       match.length < lookahead_buffer_size;) {
+    --dictionary_current;
+
     auto it1 = dictionary_current;
-    auto it2 = data.lookahead_buffer_begin();
+    auto it2 = lookahead_buffer_begin;
     decltype(match.length) current_length = 0;
 
-    while (it1 != dictionary_end && it2 != data.lookahead_buffer_end() &&
+    while (it1 != dictionary_end && it2 != lookahead_buffer_end &&
            *it1 == *it2) {
       ++current_length;
       ++it1;
       ++it2;
     }
 
-    if (current_length >= match.length) {
-      match.position = current_position;
+    if (current_length > match.length) {
+      match.position = dictionary_end - dictionary_current;
       match.length = current_length;
     }
   }
@@ -13,6 +13,13 @@
  */
 template <size_t position_bits, size_t length_bits, size_t minimum_match_length>
 struct LZSSMatchRetriever {
+  // A position and a length are read with a single call, then split with
+  // constant shifts
+  static constexpr size_t match_bits = position_bits + length_bits;
+  static_assert(match_bits < 32, "matches must fit in 31 bits");
+
+  typedef typename UnsignedInteger<max_size(match_bits)>::type match_type;
+
   /**
    * @param[out] bit_reader the BitReader to use
    * @param[out] match      the Match to initialize
@@ -24,9 +31,10 @@ struct LZSSMatchRetriever {
     bool encoded_flag = bit_reader.read();
 
     if (encoded_flag == LZSS_ENCODED_FLAG) {
-      bit_reader.read(match.position, position_bits);
-      bit_reader.read(match.length, length_bits);
-      match.length += minimum_match_length;
+      match_type token;
+      bit_reader.read(token, match_bits);
+      match.position = token >> length_bits;
+      match.length = (token & max_size(length_bits)) + minimum_match_length;
       return false;
     } else {
       bit_reader.read(symbol);
@@ -62,13 +70,15 @@ class LZSSDecoder : public LZ77Decoder<position_bits, length_bits, T> {
    *              sequence
    * @param output_iterator an output iterator for writing the decoded sequence
    * @param times the number of matches to process
+   * @return an input iterator referring to past-the-end of the last token
+   *         read; error() tells whether the sequence could be decoded
    */
   template <typename InputIterator, typename OutputIterator>
-  void operator()(InputIterator begin,
-                  InputIterator end,
-                  OutputIterator output_iterator,
-                  size_t times = std::numeric_limits<size_t>::max()) {
-    base_type::operator()(
+  InputIterator operator()(InputIterator begin,
+                           InputIterator end,
+                           OutputIterator output_iterator,
+                           size_t times = std::numeric_limits<size_t>::max()) {
+    return base_type::operator()(
         begin,
         end,
         output_iterator,
@@ -1,10 +1,12 @@
 #ifndef LZSS_ENCODER_H
 #define LZSS_ENCODER_H
 
+#include <vector>
 #include "lz77_data.h"
 #include "bit_writer.h"
 #include "lz77_boyer_moore_dictionary.h"
 #include "lz77_naive_dictionary.h"
+#include "span.h"
 
 static constexpr bool LZSS_ENCODED_FLAG = false;
 static constexpr bool LZSS_UNENCODED_FLAG = true;
@@ -14,6 +16,85 @@ constexpr size_t get_minimum_match_length(bits_t position_bits,
   return (position_bits + length_bits) / 9 + 1;
 }
 
+/**
+ * A token writer that packs LZSS flags, symbols and matches into a single
+ * bitstream.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ * @tparam minimum_match_length the minimum match length to accept
+ * @tparam OutputIterator an output iterator type for writing a single
+ *                        character
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename OutputIterator>
+class LZSSBitTokenWriter {
+  // A whole token, flag first, is packed into one integer with constant
+  // shifts and written with a single call
+  static constexpr bits_t match_bits = 1 + position_bits + length_bits;
+  static_assert(match_bits < 32, "matches must fit in 31 bits");
+
+  typedef typename UnsignedInteger<max_size(match_bits)>::type match_type;
+
+ public:
+  /**
+   * Construct a LZSSBitTokenWriter.
+   *
+   * @param[out] output_iterator an output iterator
+   */
+  explicit LZSSBitTokenWriter(const OutputIterator& output_iterator)
+      : _bit_writer(output_iterator) {}
+
+  /**
+   * Write an unencoded symbol.
+   *
+   * @param symbol the symbol to write
+   */
+  template <typename T>
+  void write_symbol(const T& symbol) {
+    static_assert(sizeof(T) < sizeof(uint64_t), "symbols must fit in 63 bits");
+    static constexpr bits_t symbol_bits = 8 * sizeof(T);
+    typedef typename std::conditional<(sizeof(T) < sizeof(uint32_t)),
+                                      uint32_t,
+                                      uint64_t>::type token_type;
+
+    _bit_writer.write(
+        (token_type(LZSS_UNENCODED_FLAG) << symbol_bits) |
+            static_cast<typename std::make_unsigned<T>::type>(symbol),
+        1 + symbol_bits);
+  }
+
+  /**
+   * Write a match.
+   *
+   * @param[in] match the match to write
+   */
+  template <typename MatchType>
+  void write_match(const MatchType& match) {
+    _bit_writer.write(
+        static_cast<match_type>(
+            (match_type(LZSS_ENCODED_FLAG) << (match_bits - 1)) |
+            ((match.position & max_size(position_bits)) << length_bits) |
+            ((match.length - minimum_match_length) & max_size(length_bits))),
+        match_bits);
+  }
+
+  /**
+   * @param symbols     the number of symbols to encode
+   * @param symbol_bits the size of a symbol, in bits
+   * @return the maximum number of bytes written
+   */
+  static size_t bound(size_t symbols, size_t symbol_bits = 8) {
+    // A match never takes more bits than its symbols would as literals
+    return (symbols * (1 + symbol_bits) + 7) / 8;
+  }
+
+ private:
+  BitWriter<OutputIterator> _bit_writer;
+};
+
 /**
  * A functor that encodes a sequence of symbols using LZSS.
  *
@@ -26,17 +107,20 @@ constexpr size_t get_minimum_match_length(bits_t position_bits,
  *                                   lookahead buffer may contain
  * @tparam T the type of the symbols
  * @tparam D the type of the matching algorithm to use
+ * @tparam W the type of the token writer to use
  */
-template <
-    bits_t position_bits,
-    bits_t length_bits,
-    size_t minimum_match_length =
-        get_minimum_match_length(position_bits, length_bits),
-    size_t max_dictionary_size = max_size(position_bits),
-    size_t max_lookahead_buffer_size =
-        max_size(length_bits) + minimum_match_length,
-    typename T = char,
-    template <size_t, size_t, typename> class D = LZ77BoyerMooreDictionary>
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          size_t max_dictionary_size = max_size(position_bits),
+          size_t max_lookahead_buffer_size =
+              max_size(length_bits) + minimum_match_length,
+          typename T = char,
+          template <size_t, size_t, typename> class D =
+              LZ77BoyerMooreDictionary,
+          template <bits_t, bits_t, size_t, typename> class W =
+              LZSSBitTokenWriter>
 class LZSSEncoder {
  public:
   typedef T symbol_type;
@@ -63,7 +147,55 @@ class LZSSEncoder {
     return encode(data, output_iterator);
   }
 
+  /**
+   * Encode a sequence of symbols, with a dictionary primed with the symbols
+   * that precede it; matches may refer to them.
+   *
+   * The dictionary is used in place when it lies in memory right before the
+   * sequence, otherwise both are copied first.
+   *
+   * @param dictionary the symbols that precede the sequence
+   * @param begin a pointer to the beginning of the sequence to encode
+   * @param end   a pointer to past-the-end of the sequence to encode
+   * @param output_iterator an output iterator for writing the encoded sequence
+   * @return the number of steps for decoding
+   */
+  template <typename OutputIterator>
+  size_t operator()(Span<const T> dictionary,
+                    const T* begin,
+                    const T* end,
+                    OutputIterator output_iterator) {
+    if (dictionary.end() != begin) {
+      std::vector<T> buffer(dictionary.begin(), dictionary.end());
+      buffer.insert(buffer.end(), begin, end);
+
+      const T* buffer_begin = buffer.data() + dictionary.size();
+      return (*this)(Span<const T>(buffer.data(), dictionary.size()),
+                     buffer_begin,
+                     buffer.data() + buffer.size(),
+                     output_iterator);
+    }
+
+    LZ77Data<max_dictionary_size, max_lookahead_buffer_size, const T*, T> data(
+        dictionary.begin(), begin, end);
+    return encode(data, output_iterator);
+  }
+
+  /**
+   * @param input_size the number of symbols to encode
+   * @return the maximum number of bytes written by operator()
+   */
+  static size_t bound(size_t input_size) {
+    return W<position_bits,
+             length_bits,
+             minimum_match_length,
+             T*>::bound(input_size, 8 * sizeof(T));
+  }
+
  private:
+  // Kept between sequences, so that its tables are reused
+  dictionary_type _dictionary;
+
   template <typename Data, typename OutputIterator>
   size_t encode(Data& data, OutputIterator output_iterator);
 };
@@ -89,7 +221,8 @@ template <bits_t position_bits,
           size_t max_dictionary_size,
           size_t max_lookahead_buffer_size,
           typename T,
-          template <size_t, size_t, typename> class D>
+          template <size_t, size_t, typename> class D,
+          template <bits_t, bits_t, size_t, typename> class W>
 template <typename Data, typename OutputIterator>
 size_t LZSSEncoder<position_bits,
                    length_bits,
@@ -97,26 +230,24 @@ size_t LZSSEncoder<position_bits,
                    max_dictionary_size,
                    max_lookahead_buffer_size,
                    T,
-                   D>::encode(Data& data, OutputIterator output_iterator) {
-  dictionary_type dictionary;
-  BitWriter<OutputIterator> bit_writer(output_iterator);
+                   D,
+                   W>::encode(Data& data, OutputIterator output_iterator) {
+  W<position_bits, length_bits, minimum_match_length, OutputIterator>
+      token_writer(output_iterator);
   size_t steps = 0;
 
   while (!data.empty()) {
     data.fill_lookahead_buffer();
 
     // Find a match
-    auto match = dictionary.find_match(data);
+    auto match = _dictionary.find_match(data);
 
     // Decide whether to encode it or not
     if (match.length < minimum_match_length) {
-      bit_writer.write(LZSS_UNENCODED_FLAG, 1);
-      bit_writer.write(data.lookahead_buffer_at(0));
+      token_writer.write_symbol(data.lookahead_buffer_at(0));
       data.slide_window();
     } else {
-      bit_writer.write(LZSS_ENCODED_FLAG, 1);
-      bit_writer.write(match.position, position_bits);
-      bit_writer.write(match.length - minimum_match_length, length_bits);
+      token_writer.write_match(match);
       data.slide_window(match.length);
     }
 
@@ -0,0 +1,130 @@
+#ifndef LZSS_GROUPED_DECODER_H
+#define LZSS_GROUPED_DECODER_H
+
+#include <algorithm>
+#include "lzss_grouped_encoder.h"
+#include "lz77_decoder.h"
+
+/**
+ * A functor that decodes a sequence of symbols encoded with
+ * LZSSGroupedEncoder.
+ *
+ * The flags of a group are read with its control byte and shifted out of it
+ * token by token; a group of literals only, the common case on data that does
+ * not compress well, is copied without testing its flags at all.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ * @tparam minimum_match_length the minimum match length to accept
+ * @tparam T             the type of the symbols
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          typename T = char>
+class LZSSGroupedDecoder : public LZ77Decoder<position_bits, length_bits, T> {
+ private:
+  typedef LZ77Decoder<position_bits, length_bits, T> base_type;
+  typedef typename base_type::match_type match_type;
+
+  static constexpr size_t match_size =
+      get_grouped_match_size(position_bits, length_bits);
+
+  // The control byte of a whole group of literals
+  static constexpr unsigned char literals_only =
+      LZSS_UNENCODED_FLAG ? max_size(LZSS_GROUP_SIZE) : 0;
+
+ public:
+  /**
+   * Decode a sequence of symbols.
+   *
+   * @param begin an input iterator referring to the beginning of the encoded
+   *              sequence
+   * @param end   an input iterator referring to past-the-end of the encoded
+   *              sequence
+   * @param output_iterator an output iterator for writing the decoded sequence
+   * @param times the number of tokens to process
+   * @return an input iterator referring to past-the-end of the last token
+   *         read; error() tells whether the sequence could be decoded
+   */
+  template <typename InputIterator, typename OutputIterator>
+  InputIterator operator()(InputIterator begin,
+                           InputIterator end,
+                           OutputIterator output_iterator,
+                           size_t times = std::numeric_limits<size_t>::max());
+};
+
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename T>
+template <typename InputIterator, typename OutputIterator>
+InputIterator
+LZSSGroupedDecoder<position_bits, length_bits, minimum_match_length, T>::
+operator()(InputIterator begin,
+           InputIterator end,
+           OutputIterator output_iterator,
+           size_t times) {
+  size_t steps = 0;
+  this->_error = DECODE_OK;
+
+  while (steps < times && begin != end) {
+    unsigned char flags = *begin;
+    ++begin;
+
+    // The last group may hold fewer tokens than it has flags
+    size_t tokens = std::min(times - steps, LZSS_GROUP_SIZE);
+
+    if (flags == literals_only) {
+      T literals[LZSS_GROUP_SIZE];
+      size_t size = 0;
+      for (; size < tokens && begin != end; ++size) {
+        literals[size] = *begin;
+        ++begin;
+      }
+
+      this->decode_symbols(output_iterator, literals, size);
+      steps += size;
+      continue;
+    }
+
+    for (; tokens && begin != end; --tokens, ++steps, flags <<= 1) {
+      if (bool(flags & 0x80) == LZSS_UNENCODED_FLAG) {
+        this->decode(output_iterator, match_type(), true, *begin);
+        ++begin;
+        continue;
+      }
+
+      uint32_t token = 0;
+      size_t size = 0;
+      for (; size < match_size && begin != end; ++size) {
+        token = (token << 8) | static_cast<unsigned char>(*begin);
+        ++begin;
+      }
+
+      // A match cut by the end of the input is not decoded
+      if (size < match_size) {
+        this->_error = DECODE_TRUNCATED;
+        return begin;
+      }
+
+      match_type match;
+      match.position = (token >> length_bits) & max_size(position_bits);
+      match.length = (token & max_size(length_bits)) + minimum_match_length;
+
+      if (!this->decode(output_iterator, match, false, T())) {
+        return begin;
+      }
+    }
+  }
+
+  // Fewer tokens than announced
+  if (steps < times && times != std::numeric_limits<size_t>::max()) {
+    this->_error = DECODE_TRUNCATED;
+  }
+
+  return begin;
+}
+
+#endif /* LZSS_GROUPED_DECODER_H */
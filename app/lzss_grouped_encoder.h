@@ -0,0 +1,183 @@
+#ifndef LZSS_GROUPED_ENCODER_H
+#define LZSS_GROUPED_ENCODER_H
+
+#include <algorithm>
+#include <iterator>
+#include "lzss_encoder.h"
+
+/**
+ * The number of LZSS tokens whose flags are grouped in a control byte.
+ */
+static constexpr size_t LZSS_GROUP_SIZE = 8;
+
+/**
+ * @param position_bits the number of bits used to encode the match position
+ * @param length_bits   the number of bits used to encode the match length
+ * @return the number of bytes a match takes in a grouped token stream
+ */
+constexpr size_t get_grouped_match_size(bits_t position_bits,
+                                        bits_t length_bits) {
+  return (position_bits + length_bits + 7) / 8;
+}
+
+/**
+ * A token writer that groups the LZSS flags of every 8 tokens in a control
+ * byte written ahead of them, as LZ4 and LZO-style coders do, so that the
+ * decoder tests flags already in a register instead of reading them one at
+ * a time from the bitstream.
+ *
+ * The flags of a control byte are written most significant bit first. Tokens
+ * are whole bytes: a symbol, or a match whose position and length are packed
+ * like in LZSSBitTokenWriter and written most significant byte first (two
+ * bytes for 12/4, which is as long as in the bitstream). The control byte of
+ * the last group is padded with zeros.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ * @tparam minimum_match_length the minimum match length to accept
+ * @tparam OutputIterator an output iterator type for writing a single
+ *                        character
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename OutputIterator>
+class LZSSGroupedTokenWriter {
+  static constexpr size_t match_size =
+      get_grouped_match_size(position_bits, length_bits);
+  static_assert(match_size <= sizeof(uint32_t), "matches must fit in 4 bytes");
+
+  typedef char symbol_type;
+
+ public:
+  /**
+   * Construct a LZSSGroupedTokenWriter.
+   *
+   * @param[out] output_iterator an output iterator
+   */
+  explicit LZSSGroupedTokenWriter(const OutputIterator& output_iterator)
+      : _output_iterator(output_iterator) {}
+
+  LZSSGroupedTokenWriter(const LZSSGroupedTokenWriter&) = delete;
+
+  /**
+   * Write an unencoded symbol.
+   *
+   * @param symbol the symbol to write
+   */
+  void write_symbol(symbol_type symbol) {
+    _group[_size++] = symbol;
+    add_flag(LZSS_UNENCODED_FLAG);
+  }
+
+  /**
+   * Write a match.
+   *
+   * @param[in] match the match to write
+   */
+  template <typename MatchType>
+  void write_match(const MatchType& match) {
+    uint32_t token =
+        ((match.position & max_size(position_bits)) << length_bits) |
+        ((match.length - minimum_match_length) & max_size(length_bits));
+
+    for (size_t i = match_size; i--;) {
+      _group[_size++] = static_cast<symbol_type>(token >> (8 * i));
+    }
+
+    add_flag(LZSS_ENCODED_FLAG);
+  }
+
+  /**
+   * @param symbols     the number of symbols to encode
+   * @param symbol_bits the size of a symbol, in bits
+   * @return the maximum number of bytes written
+   */
+  static size_t bound(size_t symbols, size_t symbol_bits = 8) {
+    size_t literal_size = (symbol_bits + 7) / 8;
+    size_t payload =
+        std::max(symbols * literal_size,
+                 (symbols * match_size + minimum_match_length - 1) /
+                     minimum_match_length);
+
+    return (symbols + LZSS_GROUP_SIZE - 1) / LZSS_GROUP_SIZE + payload;
+  }
+
+  /**
+   * Write the last group, if any.
+   */
+  ~LZSSGroupedTokenWriter() {
+    if (_tokens) {
+      _flags <<= LZSS_GROUP_SIZE - _tokens;
+      write_group();
+    }
+  }
+
+ private:
+  OutputIterator _output_iterator;
+
+  // The flags and the bytes of the tokens of the current group
+  unsigned char _flags = 0;
+  size_t _tokens = 0;
+  symbol_type _group[LZSS_GROUP_SIZE * match_size];
+  size_t _size = 0;
+
+  void add_flag(bool flag) {
+    _flags = static_cast<unsigned char>((_flags << 1) | flag);
+
+    if (++_tokens == LZSS_GROUP_SIZE) {
+      write_group();
+    }
+  }
+
+  void write_group() {
+    *_output_iterator = static_cast<symbol_type>(_flags);
+    ++_output_iterator;
+    _output_iterator = std::copy(_group, _group + _size, _output_iterator);
+
+    _flags = 0;
+    _tokens = 0;
+    _size = 0;
+  }
+};
+
+/**
+ * A LZSSEncoder that groups the flags of its tokens (see
+ * LZSSGroupedTokenWriter) instead of writing a single bitstream.
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          size_t max_dictionary_size = max_size(position_bits),
+          size_t max_lookahead_buffer_size =
+              max_size(length_bits) + minimum_match_length,
+          typename T = char,
+          template <size_t, size_t, typename> class D =
+              LZ77BoyerMooreDictionary>
+using LZSSGroupedEncoder = LZSSEncoder<position_bits,
+                                       length_bits,
+                                       minimum_match_length,
+                                       max_dictionary_size,
+                                       max_lookahead_buffer_size,
+                                       T,
+                                       D,
+                                       LZSSGroupedTokenWriter>;
+
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          size_t max_dictionary_size = max_size(position_bits),
+          size_t max_lookahead_buffer_size =
+              max_size(length_bits) + minimum_match_length,
+          typename T = char>
+using NaiveLZSSGroupedEncoder = LZSSGroupedEncoder<position_bits,
+                                                   length_bits,
+                                                   minimum_match_length,
+                                                   max_dictionary_size,
+                                                   max_lookahead_buffer_size,
+                                                   T,
+                                                   LZ77NaiveDictionary>;
+
+#endif /* LZSS_GROUPED_ENCODER_H */
@@ -0,0 +1,175 @@
+#ifndef LZSS_STREAM_DECODER_H
+#define LZSS_STREAM_DECODER_H
+
+#include <bitset>
+#include "lzss_stream_encoder.h"
+#include "lz77_decoder.h"
+#include "span.h"
+
+/**
+ * A functor that decodes a sequence of symbols encoded with
+ * LZSSStreamEncoder.
+ *
+ * The sizes of the streams are checked against each other, and the flags
+ * counted, once per sequence: the tokens are then read from the streams
+ * without bounds checks.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ * @tparam minimum_match_length the minimum match length to accept
+ * @tparam T             the type of the symbols
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          typename T = char>
+class LZSSStreamDecoder : public LZ77Decoder<position_bits, length_bits, T> {
+ private:
+  typedef LZ77Decoder<position_bits, length_bits, T> base_type;
+  typedef typename base_type::match_type match_type;
+  typedef LZSSStreams<T> streams_type;
+  typedef typename streams_type::stream_type::const_iterator stream_iterator;
+
+ public:
+  /**
+   * Decode a sequence of symbols, starting from an empty dictionary.
+   *
+   * @param begin an input iterator referring to the beginning of the encoded
+   *              streams
+   * @param end   an input iterator referring to past-the-end of the encoded
+   *              streams
+   * @param output_iterator an output iterator for writing the decoded sequence
+   */
+  template <typename InputIterator, typename OutputIterator>
+  void operator()(InputIterator begin,
+                  InputIterator end,
+                  OutputIterator output_iterator) {
+    this->clear();
+    decode_streams(begin, end, output_iterator);
+  }
+
+  /**
+   * Decode a sequence of symbols, with a dictionary primed with the decoded
+   * symbols that precede it (see LZ77Decoder::prime()).
+   *
+   * @param dictionary the decoded symbols that precede the sequence
+   * @param begin an input iterator referring to the beginning of the encoded
+   *              streams
+   * @param end   an input iterator referring to past-the-end of the encoded
+   *              streams
+   * @param output_iterator an output iterator for writing the decoded sequence
+   */
+  template <typename InputIterator, typename OutputIterator>
+  void operator()(Span<const T> dictionary,
+                  InputIterator begin,
+                  InputIterator end,
+                  OutputIterator output_iterator) {
+    this->prime(dictionary.begin(), dictionary.end());
+    decode_streams(begin, end, output_iterator);
+  }
+
+ private:
+  // Kept between sequences, so that the streams are read without allocating
+  streams_type _streams;
+
+  template <typename InputIterator, typename OutputIterator>
+  void decode_streams(InputIterator begin,
+                      InputIterator end,
+                      OutputIterator output_iterator);
+
+  // Check that the streams hold every token that they announce
+  DecodeError check_streams() const;
+};
+
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename T>
+template <typename InputIterator, typename OutputIterator>
+void LZSSStreamDecoder<position_bits, length_bits, minimum_match_length, T>::
+    decode_streams(InputIterator begin,
+                   InputIterator end,
+                   OutputIterator output_iterator) {
+  bool complete;
+  if (_streams.read(begin, end, &complete) != end) {
+    this->_error = DECODE_TRAILING_DATA;
+    return;
+  }
+
+  this->_error = complete ? check_streams() : DECODE_TRUNCATED;
+  if (this->_error != DECODE_OK) {
+    return;
+  }
+
+  const auto& flags = _streams[LZSS_FLAGS_STREAM];
+  BitReader<stream_iterator> flag_reader(flags.begin(), flags.end());
+
+  auto literal = _streams[LZSS_LITERALS_STREAM].begin();
+  auto length = _streams[LZSS_LENGTHS_STREAM].begin();
+  auto position_low = _streams[LZSS_POSITIONS_LOW_STREAM].begin();
+  auto position_high = _streams[LZSS_POSITIONS_HIGH_STREAM].begin();
+
+  size_t tokens = _streams[LZSS_LITERALS_STREAM].size() +
+                  _streams[LZSS_LENGTHS_STREAM].size();
+
+  while (tokens--) {
+    match_type match;
+
+    if (flag_reader.read() == LZSS_ENCODED_FLAG) {
+      match.position = static_cast<unsigned char>(*position_low++);
+
+      if (position_bits > 8) {
+        match.position |= static_cast<unsigned char>(*position_high++) << 8;
+      }
+
+      match.length =
+          static_cast<unsigned char>(*length++) + minimum_match_length;
+
+      if (!this->decode(output_iterator, match, false, T())) {
+        return;
+      }
+    } else {
+      this->decode(output_iterator, match, true, *literal++);
+    }
+  }
+}
+
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename T>
+DecodeError LZSSStreamDecoder<position_bits,
+                              length_bits,
+                              minimum_match_length,
+                              T>::check_streams() const {
+  const auto& flags = _streams[LZSS_FLAGS_STREAM];
+  size_t literals = _streams[LZSS_LITERALS_STREAM].size();
+  size_t matches = _streams[LZSS_LENGTHS_STREAM].size();
+  size_t tokens = literals + matches;
+
+  // Every match has a length and a position
+  if (_streams[LZSS_POSITIONS_LOW_STREAM].size() != matches ||
+      (position_bits > 8 &&
+       _streams[LZSS_POSITIONS_HIGH_STREAM].size() != matches) ||
+      flags.size() < (tokens + 7) / 8) {
+    return DECODE_TRUNCATED;
+  }
+
+  // The flags of the tokens, most significant bit first, must tell as many
+  // literals as the literals stream holds
+  size_t set = 0;
+  for (size_t i = 0; i < tokens / 8; ++i) {
+    set += std::bitset<8>(static_cast<unsigned char>(flags[i])).count();
+  }
+  if (tokens % 8) {
+    set += std::bitset<8>(static_cast<unsigned char>(flags[tokens / 8]) >>
+                          (8 - tokens % 8)).count();
+  }
+
+  return (LZSS_ENCODED_FLAG ? tokens - set : set) == literals
+             ? DECODE_OK
+             : DECODE_INVALID_MATCH;
+}
+
+#endif /* LZSS_STREAM_DECODER_H */
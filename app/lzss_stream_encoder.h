@@ -0,0 +1,226 @@
+#ifndef LZSS_STREAM_ENCODER_H
+#define LZSS_STREAM_ENCODER_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <iterator>
+#include "lzss_encoder.h"
+#include "streams.h"
+
+/**
+ * The streams a LZSS token stream is made of.
+ */
+enum LZSSStream {
+  LZSS_FLAGS_STREAM,
+  LZSS_LITERALS_STREAM,
+  LZSS_LENGTHS_STREAM,
+  LZSS_POSITIONS_LOW_STREAM,
+  LZSS_POSITIONS_HIGH_STREAM,
+  LZSS_STREAMS
+};
+
+/**
+ * The tokens of a LZSS-encoded sequence, split by field so that each field
+ * can be entropy coded on its own.
+ *
+ * Flags are packed 8 per symbol, positions are split in their low and high
+ * bytes, lengths are stored minus the minimum match length.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class LZSSStreams {
+ public:
+  typedef std::vector<T> stream_type;
+
+  /**
+   * @param i the index of a stream (see LZSSStream)
+   * @return the requested stream
+   */
+  stream_type& operator[](size_t i) { return _streams[i]; }
+
+  /**
+   * @param i the index of a stream (see LZSSStream)
+   * @return the requested stream
+   */
+  const stream_type& operator[](size_t i) const { return _streams[i]; }
+
+  /**
+   * Write all the streams, one after the other.
+   *
+   * @param output_iterator an output iterator
+   */
+  template <typename OutputIterator>
+  void write(OutputIterator output_iterator) const {
+    for (auto&& stream : _streams) {
+      write_stream(stream.begin(), stream.end(), output_iterator);
+    }
+  }
+
+  /**
+   * Read all the streams written by write().
+   *
+   * @param begin an input iterator referring to the beginning of the streams
+   * @param end   an input iterator referring to past-the-end of the streams
+   * @param[out] complete set to whether or not the input holds every stream
+   *                      whole, if not null
+   * @return an input iterator referring to past-the-end of the last stream
+   */
+  template <typename InputIterator>
+  InputIterator read(InputIterator begin,
+                     InputIterator end,
+                     bool* complete = nullptr) {
+    bool all = true;
+
+    for (auto&& stream : _streams) {
+      bool whole;
+      begin = read_stream(begin, end, stream, &whole);
+      all = all && whole;
+    }
+
+    if (complete) {
+      *complete = all;
+    }
+
+    return begin;
+  }
+
+ private:
+  std::array<stream_type, LZSS_STREAMS> _streams;
+};
+
+/**
+ * A token writer that splits LZSS flags, symbols, positions and lengths into
+ * separate streams; the streams are written on destruction.
+ *
+ * @tparam position_bits the number of bits used to encode the match position
+ * @tparam length_bits   the number of bits used to encode the match length
+ * @tparam minimum_match_length the minimum match length to accept
+ * @tparam OutputIterator an output iterator type for writing a single
+ *                        character
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length,
+          typename OutputIterator>
+class LZSSStreamTokenWriter {
+  static_assert(position_bits <= 16, "positions must fit in two bytes");
+  static_assert(length_bits <= 8, "lengths must fit in one byte");
+
+  typedef char symbol_type;
+  typedef LZSSStreams<symbol_type> streams_type;
+  typedef std::back_insert_iterator<typename streams_type::stream_type>
+      flags_iterator;
+
+ public:
+  /**
+   * Construct a LZSSStreamTokenWriter.
+   *
+   * @param[out] output_iterator an output iterator
+   */
+  explicit LZSSStreamTokenWriter(const OutputIterator& output_iterator)
+      : _output_iterator(output_iterator),
+        _flags(std::back_inserter(_streams[LZSS_FLAGS_STREAM])) {}
+
+  LZSSStreamTokenWriter(const LZSSStreamTokenWriter&) = delete;
+
+  /**
+   * Write an unencoded symbol.
+   *
+   * @param symbol the symbol to write
+   */
+  void write_symbol(symbol_type symbol) {
+    _flags.write(LZSS_UNENCODED_FLAG, 1);
+    _streams[LZSS_LITERALS_STREAM].push_back(symbol);
+  }
+
+  /**
+   * Write a match.
+   *
+   * @param[in] match the match to write
+   */
+  template <typename MatchType>
+  void write_match(const MatchType& match) {
+    _flags.write(LZSS_ENCODED_FLAG, 1);
+    _streams[LZSS_LENGTHS_STREAM].push_back(match.length -
+                                            minimum_match_length);
+    _streams[LZSS_POSITIONS_LOW_STREAM].push_back(match.position & 0xff);
+
+    if (position_bits > 8) {
+      _streams[LZSS_POSITIONS_HIGH_STREAM].push_back(match.position >> 8);
+    }
+  }
+
+  /**
+   * @param symbols     the number of symbols to encode
+   * @param symbol_bits the size of a symbol, in bits
+   * @return the maximum number of bytes written
+   */
+  static size_t bound(size_t symbols, size_t symbol_bits = 8) {
+    static constexpr size_t match_size = position_bits > 8 ? 3 : 2;
+    size_t literal_size = (symbol_bits + 7) / 8;
+    size_t payload =
+        std::max(symbols * literal_size,
+                 (symbols * match_size + minimum_match_length - 1) /
+                     minimum_match_length);
+
+    return (symbols + 7) / 8 + payload + LZSS_STREAMS * sizeof(size_t);
+  }
+
+  /**
+   * Flush the flags and write all the streams.
+   */
+  ~LZSSStreamTokenWriter() {
+    if (!_flags.empty()) {
+      _flags.flush();
+    }
+
+    _streams.write(_output_iterator);
+  }
+
+ private:
+  OutputIterator _output_iterator;
+  streams_type _streams;
+  BitWriter<flags_iterator> _flags;
+};
+
+/**
+ * A LZSSEncoder that writes LZSSStreams instead of a single bitstream.
+ */
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          size_t max_dictionary_size = max_size(position_bits),
+          size_t max_lookahead_buffer_size =
+              max_size(length_bits) + minimum_match_length,
+          typename T = char,
+          template <size_t, size_t, typename> class D =
+              LZ77BoyerMooreDictionary>
+using LZSSStreamEncoder = LZSSEncoder<position_bits,
+                                      length_bits,
+                                      minimum_match_length,
+                                      max_dictionary_size,
+                                      max_lookahead_buffer_size,
+                                      T,
+                                      D,
+                                      LZSSStreamTokenWriter>;
+
+template <bits_t position_bits,
+          bits_t length_bits,
+          size_t minimum_match_length =
+              get_minimum_match_length(position_bits, length_bits),
+          size_t max_dictionary_size = max_size(position_bits),
+          size_t max_lookahead_buffer_size =
+              max_size(length_bits) + minimum_match_length,
+          typename T = char>
+using NaiveLZSSStreamEncoder = LZSSStreamEncoder<position_bits,
+                                                 length_bits,
+                                                 minimum_match_length,
+                                                 max_dictionary_size,
+                                                 max_lookahead_buffer_size,
+                                                 T,
+                                                 LZ77NaiveDictionary>;
+
+#endif /* LZSS_STREAM_ENCODER_H */
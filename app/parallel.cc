@@ -1,33 +1,1234 @@
 #include "parallel.h"
+#include <map>
+#include "archive.h"
+#include "async_io.h"
+#include "container.h"
 #include "splitter.h"
+#include "sources.h"
 #include "worker.h"
 #include "lzss_encoder.h"
+#include "lzss_stream_encoder.h"
+#include "lzss_grouped_encoder.h"
 #include "encoder_wrapper.h"
 #include "huffman_encoder_stack.h"
+#include "huffman_streams_encoder_stack.h"
 #include "lzss_decoder.h"
+#include "lzss_stream_decoder.h"
+#include "lzss_grouped_decoder.h"
 #include "decoder_wrapper.h"
 #include "huffman_decoder_stack.h"
+#include "huffman_streams_decoder_stack.h"
+#include "incremental_decoder.h"
 
-void encode_in_parallel(const char* input,
+typedef Worker<EncoderWrapper<LZSSEncoder<12, 4>>> LZSSEncoderWorker;
+typedef Worker<LZSSStreamEncoder<12, 4>> LZSSStreamEncoderWorker;
+typedef Worker<EncoderWrapper<LZSSGroupedEncoder<12, 4>>>
+    LZSSGroupedEncoderWorker;
+typedef HuffmanStreamsEncoderStack<LZSS_STREAMS> StreamsEncoderStack;
+
+// The size of the dictionary of LZSSEncoder<12, 4>
+static constexpr size_t PRIMED_DICTIONARY_SIZE = max_size(12);
+
+/**
+ * Build the header of a container.
+ */
+static ContainerHeader container_header(bool token_streams,
+                                        bool primed,
+                                        const PresetDictionary<>& dictionary,
+                                        size_t chunk_size,
+                                        bool deduplicate = false,
+                                        bool checksums = false,
+                                        bool grouped_flags = false) {
+  ContainerHeader header;
+  if (token_streams) {
+    header.set(CONTAINER_TOKEN_STREAMS);
+  }
+  if (primed) {
+    header.set(CONTAINER_PRIMED);
+  }
+  if (!dictionary.empty()) {
+    header.set(CONTAINER_DICTIONARY);
+    header.dictionary_id = dictionary.id();
+  }
+  if (chunk_size != DEFAULT_CHUNK_SIZE) {
+    header.set(CONTAINER_CHUNK_SIZE);
+    header.chunk_size = chunk_size;
+  }
+  if (deduplicate) {
+    header.set(CONTAINER_DEDUP);
+  }
+  if (checksums) {
+    header.set(CONTAINER_CHECKSUMS);
+  }
+  // Token streams already keep flags apart from the tokens
+  if (grouped_flags && !token_streams) {
+    header.set(CONTAINER_GROUPED_FLAGS);
+  }
+
+  return header;
+}
+
+/**
+ * @return the size of the chunks of a container
+ */
+static size_t container_chunk_size(const ContainerHeader& header) {
+  return header.has(CONTAINER_CHUNK_SIZE) ? header.chunk_size
+                                          : DEFAULT_CHUNK_SIZE;
+}
+
+/**
+ * @return the chunk size requested, within bounds, or else the adaptive one
+ */
+static size_t choose_chunk_size(size_t size,
+                                size_t threads,
+                                size_t chunk_size) {
+  if (!chunk_size) {
+    return adaptive_chunk_size(size, threads);
+  }
+
+  return std::min<size_t>(std::max(chunk_size, MIN_CHUNK_SIZE),
+                          CONTAINER_MAX_CHUNK_SIZE);
+}
+
+size_t adaptive_chunk_size(size_t size, size_t threads, size_t window_size) {
+  // Chunks per thread, for threads to balance chunks of different costs
+  static constexpr size_t chunks_per_thread = 4;
+
+  // A window warms up at the beginning of each chunk: a few windows per chunk
+  // keep that cost low, and past a hundred or so the ratio stops improving
+  size_t smallest = std::max(MIN_CHUNK_SIZE, 4 * window_size);
+  size_t largest = std::max(smallest, 128 * window_size);
+
+  size_t chunk_size = size / ((threads ? threads : default_threads()) *
+                              chunks_per_thread);
+  chunk_size = std::min(std::max(chunk_size, smallest), largest);
+
+  // Whole windows
+  return (chunk_size + window_size - 1) / window_size * window_size;
+}
+
+/**
+ * Make a Splitter ready for the next sequence, creating it on first use.
+ */
+template <typename SplitterType>
+static SplitterType& reuse(std::unique_ptr<SplitterType>& splitter,
+                           size_t dictionary_size,
+                           Span<const char> preset,
+                           size_t threads_per_node,
+                           bool content_defined = false,
+                           bool deduplicate = false,
+                           bool checksums = false) {
+  if (!splitter) {
+    splitter.reset(new SplitterType());
+  }
+
+  splitter->prime(dictionary_size, preset);
+  splitter->pin(threads_per_node);
+  splitter->cut_by_content(content_defined);
+  splitter->deduplicate(deduplicate);
+  splitter->checksum(checksums);
+  return *splitter;
+}
+
+/**
+ * Process a sequence with a Splitter, counting its chunks if chunks is not
+ * null, and telling why a chunk could not be processed if error is not null.
+ */
+template <typename SplitterType, typename InputIterator, typename Sink>
+static bool split(SplitterType& splitter,
+                  InputIterator begin,
+                  InputIterator end,
+                  Sink& sink,
+                  size_t threads,
+                  size_t chunk_size,
+                  size_t* chunks,
+                  DecodeError* error = nullptr) {
+  bool result = splitter.split(begin, end, sink, threads, chunk_size);
+
+  if (chunks) {
+    *chunks = splitter.chunks();
+  }
+
+  if (error) {
+    *error = splitter.error();
+  }
+
+  return result;
+}
+
+/**
+ * The Splitters encoding containers, kept so that their buffers and Workers
+ * are reused by the next sequences.
+ */
+struct EncoderSplitters {
+  std::unique_ptr<Splitter<LZSSStreamEncoderWorker,
+                           StreamsEncoderStack,
+                           char,
+                           EncoderFrames>> streams;
+  std::unique_ptr<Splitter<Worker<NaiveLZSSStreamEncoder<12, 4>>,
+                           StreamsEncoderStack,
+                           char,
+                           EncoderFrames>> naive_streams;
+  std::unique_ptr<Splitter<LZSSEncoderWorker,
+                           HuffmanEncoderStack<char>,
+                           char,
+                           EncoderFrames>> tokens;
+  std::unique_ptr<Splitter<Worker<EncoderWrapper<NaiveLZSSEncoder<12, 4>>>,
+                           HuffmanEncoderStack<char>,
+                           char,
+                           EncoderFrames>> naive_tokens;
+  std::unique_ptr<Splitter<LZSSGroupedEncoderWorker,
+                           HuffmanEncoderStack<char>,
+                           char,
+                           EncoderFrames>> grouped;
+  std::unique_ptr<
+      Splitter<Worker<EncoderWrapper<NaiveLZSSGroupedEncoder<12, 4>>>,
+               HuffmanEncoderStack<char>,
+               char,
+               EncoderFrames>> naive_grouped;
+};
+
+/**
+ * Encode a sequence into the chunks of a container described by header.
+ */
+template <typename InputIterator, typename Sink>
+static bool encode_chunks(const ContainerHeader& header,
+                          InputIterator begin,
+                          InputIterator end,
+                          Sink& sink,
+                          size_t threads,
+                          size_t threads_per_node,
+                          bool boyer_moore,
+                          Span<const char> preset,
+                          EncoderSplitters& splitters,
+                          bool content_defined = false,
+                          size_t* chunks = nullptr) {
+  size_t dictionary_size =
+      header.has(CONTAINER_PRIMED) ? PRIMED_DICTIONARY_SIZE : 0;
+  size_t chunk_size = container_chunk_size(header);
+  bool deduplicate = header.has(CONTAINER_DEDUP);
+  bool checksums = header.has(CONTAINER_CHECKSUMS);
+
+  if (header.has(CONTAINER_TOKEN_STREAMS)) {
+    if (boyer_moore) {
+      return split(reuse(splitters.streams,
+                         dictionary_size,
+                         preset,
+                         threads_per_node,
+                         content_defined,
+                         deduplicate,
+                         checksums),
+                   begin,
+                   end,
+                   sink,
+                   threads,
+                   chunk_size,
+                   chunks);
+    }
+
+    return split(reuse(splitters.naive_streams,
+                       dictionary_size,
+                       preset,
+                       threads_per_node,
+                       content_defined,
+                       deduplicate,
+                       checksums),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 chunks);
+  }
+
+  if (header.has(CONTAINER_GROUPED_FLAGS)) {
+    if (boyer_moore) {
+      return split(reuse(splitters.grouped,
+                         dictionary_size,
+                         preset,
+                         threads_per_node,
+                         content_defined,
+                         deduplicate,
+                         checksums),
+                   begin,
+                   end,
+                   sink,
+                   threads,
+                   chunk_size,
+                   chunks);
+    }
+
+    return split(reuse(splitters.naive_grouped,
+                       dictionary_size,
+                       preset,
+                       threads_per_node,
+                       content_defined,
+                       deduplicate,
+                       checksums),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 chunks);
+  }
+
+  if (boyer_moore) {
+    return split(reuse(splitters.tokens,
+                       dictionary_size,
+                       preset,
+                       threads_per_node,
+                       content_defined,
+                       deduplicate,
+                       checksums),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 chunks);
+  }
+
+  return split(reuse(splitters.naive_tokens,
+                     dictionary_size,
+                     preset,
+                     threads_per_node,
+                     content_defined,
+                     deduplicate,
+                     checksums),
+               begin,
+               end,
+               sink,
+               threads,
+               chunk_size,
+               chunks);
+}
+
+EncodingStats encode_in_parallel(const char* input,
+                                 const char* output,
+                                 size_t threads,
+                                 bool boyer_moore,
+                                 bool token_streams,
+                                 bool primed,
+                                 const PresetDictionary<>& dictionary,
+                                 bool positioned_writes,
+                                 size_t threads_per_node,
+                                 size_t chunk_size,
+                                 bool content_defined,
+                                 bool deduplicate,
+                                 bool checksums,
+                                 bool grouped_flags) {
+  // The input is read ahead asynchronously
+  AsyncReadBuffer input_buffer;
+  input_buffer.open(input);
+  StreamBufferIterator<char> begin(&input_buffer);
+
+  EncodingStats stats;
+  stats.input_size = input_buffer.size();
+  stats.chunk_size = choose_chunk_size(stats.input_size, threads, chunk_size);
+
+  ContainerHeader header = container_header(token_streams,
+                                            primed,
+                                            dictionary,
+                                            stats.chunk_size,
+                                            deduplicate,
+                                            checksums,
+                                            grouped_flags);
+  EncoderSplitters splitters;
+
+  if (positioned_writes) {
+    // Each chunk is written to the preallocated file once the chunks before
+    // it are done, without waiting for them to be written
+    FileSink<char> sink(output);
+    sink.reserve(compress_bound(stats.input_size));
+
+    char header_buffer[ContainerHeader::max_size];
+    sink.write(header_buffer, header.write(header_buffer) - header_buffer);
+
+    encode_chunks(header,
+                  begin,
+                  StreamBufferIterator<char>(),
+                  sink,
+                  threads,
+                  threads_per_node,
+                  boyer_moore,
+                  dictionary.content(),
+                  splitters,
+                  content_defined,
+                  &stats.chunks);
+
+    stats.output_size = sink.size();
+    return stats;
+  }
+
+  // The output is written behind asynchronously
+  AsyncWriteBuffer output_buffer;
+  output_buffer.open(output);
+  std::ostream output_file(&output_buffer);
+  header.write(output_file);
+
+  StreamSink<char> sink(output_file);
+  encode_chunks(header,
+                begin,
+                StreamBufferIterator<char>(),
+                sink,
+                threads,
+                threads_per_node,
+                boyer_moore,
+                dictionary.content(),
+                splitters,
+                content_defined,
+                &stats.chunks);
+
+  output_buffer.close();
+  stats.output_size = output_buffer.size();
+  return stats;
+}
+
+size_t compress_bound(size_t size) {
+  // Chunks are never smaller than MIN_CHUNK_SIZE, and their frames may end
+  // with a checksum
+  size_t chunks = (size + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE;
+  return ContainerHeader::max_size + size +
+         chunks * (Frame<>::max_header_size + sizeof(uint32_t));
+}
+
+CompressionContext::CompressionContext(size_t threads,
+                                       bool boyer_moore,
+                                       bool token_streams,
+                                       bool primed,
+                                       const PresetDictionary<>& dictionary,
+                                       size_t chunk_size,
+                                       bool checksums,
+                                       bool grouped_flags)
+    : _threads(threads),
+      _boyer_moore(boyer_moore),
+      _token_streams(token_streams),
+      _primed(primed),
+      _dictionary(dictionary),
+      _chunk_size(chunk_size),
+      _checksums(checksums),
+      _grouped_flags(grouped_flags),
+      _splitters(new EncoderSplitters()) {}
+
+CompressionContext::~CompressionContext() = default;
+
+size_t CompressionContext::compress(const void* source,
+                                    size_t size,
+                                    void* destination,
+                                    size_t capacity) {
+  ContainerHeader header =
+      container_header(_token_streams,
+                       _primed,
+                       _dictionary,
+                       choose_chunk_size(size, _threads, _chunk_size),
+                       false,
+                       _checksums,
+                       _grouped_flags);
+
+  if (capacity < ContainerHeader::max_size) {
+    return OUTPUT_OVERFLOW;
+  }
+
+  char* output = static_cast<char*>(destination);
+  size_t header_size = header.write(output) - output;
+
+  const char* input = static_cast<const char*>(source);
+  MemorySink<char> sink(output + header_size, capacity - header_size);
+  encode_chunks(header,
+                input,
+                input + size,
+                sink,
+                _threads,
+                0,
+                _boyer_moore,
+                _dictionary.content(),
+                *_splitters);
+
+  return sink.overflow() ? OUTPUT_OVERFLOW : header_size + sink.size();
+}
+
+size_t compress(const void* source,
+                size_t size,
+                void* destination,
+                size_t capacity,
+                size_t threads,
+                bool boyer_moore,
+                bool token_streams,
+                bool primed,
+                const PresetDictionary<>& dictionary,
+                size_t chunk_size,
+                bool checksums,
+                bool grouped_flags) {
+  CompressionContext context(threads,
+                             boyer_moore,
+                             token_streams,
+                             primed,
+                             dictionary,
+                             chunk_size,
+                             checksums,
+                             grouped_flags);
+
+  return context.compress(source, size, destination, capacity);
+}
+
+/**
+ * The Splitters decoding the chunks of containers whose Huffman tables are
+ * written with the header H.
+ */
+template <typename H>
+struct HuffmanDecoderSplitters {
+  typedef HuffmanStreamsEncoderStack<LZSS_STREAMS, char, H> streams_encoder;
+  typedef HuffmanStreamsDecoderStack<LZSS_STREAMS, char, H> streams_decoder;
+
+  std::unique_ptr<Splitter<streams_decoder, Worker<LZSSStreamDecoder<12, 4>>>>
+      unframed_streams;
+  std::unique_ptr<Splitter<HuffmanDecoderStack<char, H>,
+                           DecoderWrapper<LZSSDecoder<12, 4>>>>
+      unframed_tokens;
+  std::unique_ptr<
+      Splitter<streams_decoder,
+               Worker<LZSSStreamDecoder<12, 4>>,
+               char,
+               DecoderFrames<LZSSStreamEncoderWorker, streams_encoder, false>>>
+      unsized_streams;
+  std::unique_ptr<Splitter<
+      HuffmanDecoderStack<char, H>,
+      DecoderWrapper<LZSSDecoder<12, 4>>,
+      char,
+      DecoderFrames<LZSSEncoderWorker, HuffmanEncoderStack<char, H>, false>>>
+      unsized_tokens;
+  std::unique_ptr<
+      Splitter<streams_decoder,
+               Worker<LZSSStreamDecoder<12, 4>>,
+               char,
+               DecoderFrames<LZSSStreamEncoderWorker, streams_encoder>>>
+      streams;
+  std::unique_ptr<
+      Splitter<HuffmanDecoderStack<char, H>,
+               DecoderWrapper<LZSSDecoder<12, 4>>,
+               char,
+               DecoderFrames<LZSSEncoderWorker, HuffmanEncoderStack<char, H>>>>
+      tokens;
+  std::unique_ptr<Splitter<
+      HuffmanDecoderStack<char, H>,
+      DecoderWrapper<LZSSGroupedDecoder<12, 4>>,
+      char,
+      DecoderFrames<LZSSGroupedEncoderWorker, HuffmanEncoderStack<char, H>>>>
+      grouped;
+};
+
+/**
+ * The Splitters decoding containers, kept so that their buffers and Workers
+ * are reused by the next sequences.
+ */
+struct DecoderSplitters {
+  HuffmanDecoderSplitters<CompactHuffmanHeader> compact;
+  HuffmanDecoderSplitters<RawHuffmanHeader> raw;
+};
+
+/**
+ * Decode the chunks of a container whose Huffman tables are written with the
+ * header H.
+ */
+template <typename H, typename InputIterator, typename Sink>
+static bool decode_chunks(const ContainerHeader& header,
+                          InputIterator begin,
+                          InputIterator end,
+                          Sink& sink,
+                          size_t threads,
+                          size_t threads_per_node,
+                          Span<const char> preset,
+                          HuffmanDecoderSplitters<H>& splitters,
+                          DecodeError* error) {
+  if (!header.framed()) {
+    // Chunks are not framed and may be larger than the chunk size
+    size_t chunk_size = 2 * DEFAULT_CHUNK_SIZE;
+
+    if (header.has(CONTAINER_TOKEN_STREAMS)) {
+      return split(reuse(splitters.unframed_streams,
+                         0,
+                         Span<const char>(),
+                         threads_per_node),
+                   begin,
+                   end,
+                   sink,
+                   threads,
+                   chunk_size,
+                   nullptr,
+                   error);
+    }
+
+    return split(reuse(splitters.unframed_tokens,
+                       0,
+                       Span<const char>(),
+                       threads_per_node),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 nullptr,
+                 error);
+  }
+
+  size_t dictionary_size =
+      header.has(CONTAINER_PRIMED) ? PRIMED_DICTIONARY_SIZE : 0;
+  size_t chunk_size = container_chunk_size(header);
+
+  if (!header.sized_frames()) {
+    if (header.has(CONTAINER_TOKEN_STREAMS)) {
+      return split(reuse(splitters.unsized_streams,
+                         dictionary_size,
+                         preset,
+                         threads_per_node),
+                   begin,
+                   end,
+                   sink,
+                   threads,
+                   chunk_size,
+                   nullptr,
+                   error);
+    }
+
+    return split(reuse(splitters.unsized_tokens,
+                       dictionary_size,
+                       preset,
+                       threads_per_node),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 nullptr,
+                 error);
+  }
+
+  // Only sized frames may refer to earlier chunks, or end with checksums
+  bool deduplicate = header.has(CONTAINER_DEDUP);
+  bool checksums = header.has(CONTAINER_CHECKSUMS);
+
+  if (header.has(CONTAINER_TOKEN_STREAMS)) {
+    return split(reuse(splitters.streams,
+                       dictionary_size,
+                       preset,
+                       threads_per_node,
+                       false,
+                       deduplicate,
+                       checksums),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 nullptr,
+                 error);
+  }
+
+  if (header.has(CONTAINER_GROUPED_FLAGS)) {
+    return split(reuse(splitters.grouped,
+                       dictionary_size,
+                       preset,
+                       threads_per_node,
+                       false,
+                       deduplicate,
+                       checksums),
+                 begin,
+                 end,
+                 sink,
+                 threads,
+                 chunk_size,
+                 nullptr,
+                 error);
+  }
+
+  return split(reuse(splitters.tokens,
+                     dictionary_size,
+                     preset,
+                     threads_per_node,
+                     false,
+                     deduplicate,
+                     checksums),
+               begin,
+               end,
+               sink,
+               threads,
+               chunk_size,
+               nullptr,
+               error);
+}
+
+/**
+ * Decode the chunks of a container described by header, telling why it
+ * could not be decoded if error is not null.
+ */
+template <typename InputIterator, typename Sink>
+static bool decode_chunks(const ContainerHeader& header,
+                          InputIterator begin,
+                          InputIterator end,
+                          Sink& sink,
+                          size_t threads,
+                          size_t threads_per_node,
+                          const PresetDictionary<>& dictionary,
+                          DecoderSplitters& splitters,
+                          DecodeError* error = nullptr) {
+  if (!header.supported() || header.dictionary_id != dictionary.id()) {
+    if (error) {
+      *error = DECODE_UNSUPPORTED;
+    }
+    return false;
+  }
+
+  if (header.compact_huffman()) {
+    return decode_chunks(header,
+                         begin,
+                         end,
+                         sink,
+                         threads,
+                         threads_per_node,
+                         dictionary.content(),
+                         splitters.compact,
+                         error);
+  }
+
+  return decode_chunks(header,
+                       begin,
+                       end,
+                       sink,
+                       threads,
+                       threads_per_node,
+                       dictionary.content(),
+                       splitters.raw,
+                       error);
+}
+
+bool decode_in_parallel(const char* input,
                         const char* output,
                         size_t threads,
-                        bool boyer_moore) {
-  if (boyer_moore) {
-    Splitter<Worker<EncoderWrapper<LZSSEncoder<12, 4>>>,
-             HuffmanEncoderStack<char>> splitter;
+                        const PresetDictionary<>& dictionary,
+                        bool positioned_writes,
+                        size_t threads_per_node,
+                        DecodeError* error) {
+  AsyncReadBuffer input_buffer;
+  input_buffer.open(input);
+  std::istream input_file(&input_buffer);
 
-    process_in_parallel(input, output, threads, splitter);
-  } else {
-    Splitter<Worker<EncoderWrapper<NaiveLZSSEncoder<12, 4>>>,
-             HuffmanEncoderStack<char>> splitter;
+  ContainerHeader header;
+  header.read(input_file);
 
-    process_in_parallel(input, output, threads, splitter);
+  // Archives are extracted by extract_archive()
+  if (!header.supported() || header.dictionary_id != dictionary.id() ||
+      header.has(CONTAINER_ARCHIVE)) {
+    if (error) {
+      *error = DECODE_UNSUPPORTED;
+    }
+    return false;
   }
+
+  StreamBufferIterator<char> begin(&input_buffer);
+  DecoderSplitters splitters;
+
+  // The decoded size is not known: the file is not preallocated
+  if (positioned_writes) {
+    FileSink<char> sink(output);
+    bool decoded = decode_chunks(header,
+                                 begin,
+                                 StreamBufferIterator<char>(),
+                                 sink,
+                                 threads,
+                                 threads_per_node,
+                                 dictionary,
+                                 splitters,
+                                 error);
+
+    return sink.close() && decoded;
+  }
+
+  AsyncWriteBuffer output_buffer;
+  output_buffer.open(output);
+  std::ostream output_file(&output_buffer);
+  StreamSink<char> sink(output_file);
+
+  bool decoded = decode_chunks(header,
+                               begin,
+                               StreamBufferIterator<char>(),
+                               sink,
+                               threads,
+                               threads_per_node,
+                               dictionary,
+                               splitters,
+                               error);
+
+  return output_buffer.close() && decoded;
 }
 
-void decode_in_parallel(const char* input, const char* output, size_t threads) {
-  Splitter<HuffmanDecoderStack<char>, DecoderWrapper<LZSSDecoder<12, 4>>>
-      splitter;
+bool decode_incrementally(const char* input,
+                          const char* output,
+                          const PresetDictionary<>& dictionary,
+                          DecodeError* error) {
+  typedef IncrementalDecoder<12, 4> decoder_type;
+
+  std::ifstream input_file(input, std::ios::binary);
+  std::ofstream output_file(output, std::ios::binary | std::ios::trunc);
+  decoder_type decoder(dictionary);
+
+  std::vector<char> input_block(decoder_type::default_input_buffer_size);
+  std::vector<char> output_block(decoder_type::default_input_buffer_size);
+  size_t fed = 0;
+  size_t read = 0;
+
+  while (!decoder.done() && decoder.error() == DECODE_OK && output_file) {
+    size_t size = decoder.pull(output_block.data(), output_block.size());
+    output_file.write(output_block.data(), size);
+
+    if (size) {
+      continue;
+    }
+
+    // Nothing more is decoded without more input
+    if (fed == read) {
+      input_file.read(input_block.data(), input_block.size());
+      fed = 0;
+      read = input_file.gcount();
+
+      if (!read) {
+        decoder.finish();
+      }
+    }
+
+    fed += decoder.feed(input_block.data() + fed, read - fed);
+  }
+
+  if (error) {
+    *error = decoder.error();
+  }
+
+  output_file.close();
+  return decoder.done() && output_file;
+}
+
+DecompressionContext::DecompressionContext(
+    size_t threads, const PresetDictionary<>& dictionary)
+    : _threads(threads),
+      _dictionary(dictionary),
+      _splitters(new DecoderSplitters()) {}
+
+DecompressionContext::~DecompressionContext() = default;
+
+size_t DecompressionContext::decompress(const void* source,
+                                        size_t size,
+                                        void* destination,
+                                        size_t capacity) {
+  const char* input = static_cast<const char*>(source);
+  const char* end = input + size;
+
+  ContainerHeader header;
+  header.read(input, end);
+
+  if (header.has(CONTAINER_ARCHIVE)) {
+    _error = DECODE_UNSUPPORTED;
+    return INVALID_INPUT;
+  }
+
+  MemorySink<char> sink(static_cast<char*>(destination), capacity);
+  if (!decode_chunks(header,
+                     input,
+                     end,
+                     sink,
+                     _threads,
+                     0,
+                     _dictionary,
+                     *_splitters,
+                     &_error)) {
+    return INVALID_INPUT;
+  }
+
+  if (sink.overflow()) {
+    _error = DECODE_OUTPUT_OVERFLOW;
+    return OUTPUT_OVERFLOW;
+  }
+
+  return sink.size();
+}
+
+size_t decompress(const void* source,
+                  size_t size,
+                  void* destination,
+                  size_t capacity,
+                  size_t threads,
+                  const PresetDictionary<>& dictionary) {
+  DecompressionContext context(threads, dictionary);
+
+  return context.decompress(source, size, destination, capacity);
+}
+
+EncodingStats archive_in_parallel(const std::vector<std::string>& inputs,
+                                  const char* output,
+                                  size_t threads,
+                                  bool boyer_moore,
+                                  bool token_streams,
+                                  const PresetDictionary<>& dictionary,
+                                  size_t chunk_size,
+                                  bool deduplicate,
+                                  bool grouped_flags) {
+  DirectoryWalker walker(threads);
+  std::vector<ArchiveMember> members = walker.walk(inputs);
+
+  // The sizes the files had when they were walked
+  EncodingStats stats;
+  for (const ArchiveMember& member : members) {
+    stats.input_size += member.size;
+  }
+  stats.chunk_size = choose_chunk_size(stats.input_size, threads, chunk_size);
+
+  // Archives are always checksummed
+  ContainerHeader header = container_header(token_streams,
+                                            false,
+                                            dictionary,
+                                            stats.chunk_size,
+                                            deduplicate,
+                                            true,
+                                            grouped_flags);
+  header.set(CONTAINER_ARCHIVE);
+
+  AsyncWriteBuffer output_buffer;
+  output_buffer.open(output);
+  std::ostream output_file(&output_buffer);
+
+  char header_buffer[ContainerHeader::max_size];
+  size_t header_size = header.write(header_buffer) - header_buffer;
+  output_file.write(header_buffer, header_size);
+
+  StreamSink<char> stream_sink(output_file);
+  FrameIndexSink<StreamSink<char>> sink(stream_sink, header_size);
+  MemberReadBuffer input_buffer(&members, threads);
+  EncoderSplitters splitters;
+
+  encode_chunks(header,
+                StreamBufferIterator<char>(&input_buffer),
+                StreamBufferIterator<char>(),
+                sink,
+                threads,
+                0,
+                boyer_moore,
+                dictionary.content(),
+                splitters,
+                false,
+                &stats.chunks);
+
+  ArchiveDirectory directory;
+  directory.chunk_size = stats.chunk_size;
+  directory.frames = sink.frames();
+  stats.input_size = 0;
+
+  for (ArchiveMember& member : members) {
+    std::string path = archive_path(member.path);
+
+    // The roots of the trees are not members of their own
+    if (member.mode && !path.empty()) {
+      member.path = path;
+      stats.input_size += member.size;
+      directory.members.push_back(std::move(member));
+    }
+  }
+
+  // The checksum of the whole content, from those of its chunks
+  const std::vector<uint32_t>& checksums = sink.checksums();
+  for (size_t i = 0; i < checksums.size(); ++i) {
+    uint64_t offset = uint64_t(i) * stats.chunk_size;
+    uint64_t size = offset < stats.input_size
+                        ? std::min<uint64_t>(stats.chunk_size,
+                                             stats.input_size - offset)
+                        : 0;
+    directory.checksum =
+        CRC32C::combine(directory.checksum, checksums[i], size);
+  }
+
+  directory.write(output_file);
+  output_buffer.close();
+
+  stats.output_size = output_buffer.size();
+  stats.unreadable = walker.unreadable() + input_buffer.unreadable();
+  return stats;
+}
+
+/**
+ * Read the header and the directory of an archive.
+ */
+static bool read_archive(const char* archive,
+                         ContainerHeader& header,
+                         ArchiveDirectory& directory) {
+  std::ifstream input_file(archive, std::ios::binary);
+
+  return header.read(input_file) && header.supported() &&
+         header.has(CONTAINER_ARCHIVE) && directory.read(input_file);
+}
+
+bool list_archive(const char* archive, ArchiveDirectory& directory) {
+  ContainerHeader header;
+  return read_archive(archive, header, directory);
+}
+
+/**
+ * Extract some members of an archive: only the chunks holding them, and the
+ * chunks those refer to, are read and decoded, each run of consecutive chunks
+ * by a task of its own.
+ */
+static bool extract_members(const char* archive,
+                            const ContainerHeader& header,
+                            const ArchiveDirectory& directory,
+                            const std::vector<ArchiveMember>& members,
+                            const char* destination,
+                            size_t threads,
+                            const PresetDictionary<>& dictionary) {
+  // The largest run of chunks decoded by a task
+  static constexpr uint64_t max_run_size = 16 << 20;
+
+  uint64_t chunk_size = directory.chunk_size;
+  uint64_t content_size = directory.content_size();
+  size_t chunks = directory.chunks();
+  ArchiveFrameReader reader(archive, directory);
+
+  if (!reader.is_open() || chunk_size != container_chunk_size(header) ||
+      chunks != (content_size + chunk_size - 1) / chunk_size) {
+    return false;
+  }
+
+  // The size of the content of a chunk, every chunk but the last one full
+  auto content = [&](size_t chunk) {
+    return std::min(chunk_size, content_size - chunk * chunk_size);
+  };
+
+  // The chunks holding the members, by the chunk their content is decoded
+  // from: itself, or the chunk it repeats
+  std::map<size_t, std::vector<size_t>> sources;
+  std::vector<bool> needed(chunks);
+
+  for (const ArchiveMember& member : members) {
+    if (member.offset > content_size ||
+        member.size > content_size - member.offset) {
+      return false;
+    }
+
+    for (size_t chunk = member.offset / chunk_size;
+         chunk * chunk_size < member.offset + member.size;
+         ++chunk) {
+      if (needed[chunk]) {
+        continue;
+      }
+
+      size_t source = reader.source(chunk);
+      if (source == chunks || content(source) != content(chunk)) {
+        return false;
+      }
+
+      needed[chunk] = true;
+      sources[source].push_back(chunk);
+    }
+  }
+
+  size_t run_chunks = std::max<uint64_t>(1, max_run_size / chunk_size);
+  std::vector<std::pair<size_t, size_t>> runs;
+
+  for (const auto& source : sources) {
+    if (!runs.empty() && runs.back().second == source.first &&
+        runs.back().second - runs.back().first < run_chunks) {
+      ++runs.back().second;
+    } else {
+      runs.push_back(std::make_pair(source.first, source.first + 1));
+    }
+  }
+
+  mkdir(destination, 0755);
+  PositionedMemberSink sink(members, destination);
+
+  // The Splitters of the tasks, reused by the next ones
+  std::mutex mutex;
+  std::vector<std::unique_ptr<DecoderSplitters>> idle;
+  std::atomic<bool> failed(false);
+
+  {
+    WorkStealingExecutor executor(threads ? threads : default_threads());
+
+    for (const auto& run : runs) {
+      executor.submit([&, run] {
+        std::unique_ptr<DecoderSplitters> splitters;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!idle.empty()) {
+            splitters = std::move(idle.back());
+            idle.pop_back();
+          }
+        }
+
+        if (!splitters) {
+          splitters.reset(new DecoderSplitters());
+        }
+
+        // The chunks of a run do not refer to each other, nor are primed:
+        // they are decoded on their own, by this thread only
+        std::vector<char> input;
+        std::vector<char> decoded((run.second - run.first) * chunk_size);
+        MemorySink<char> run_sink(decoded.data(), decoded.size());
+        uint64_t size =
+            std::min(run.second * chunk_size, content_size) -
+            run.first * chunk_size;
+
+        bool read = reader.read(run.first, run.second, input);
+        const char* frames = input.data();
+
+        if (!read ||
+            !decode_chunks(header,
+                           frames,
+                           frames + input.size(),
+                           run_sink,
+                           1,
+                           0,
+                           dictionary,
+                           *splitters) ||
+            run_sink.overflow() || run_sink.size() != size) {
+          failed = true;
+        } else {
+          for (size_t source = run.first; source < run.second; ++source) {
+            const char* data =
+                decoded.data() + (source - run.first) * chunk_size;
+
+            for (size_t chunk : sources.at(source)) {
+              sink.write_at(chunk * chunk_size, data, content(chunk));
+            }
+          }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(splitters));
+      });
+    }
+  }
+
+  return sink.close() && !failed;
+}
+
+bool extract_archive(const char* archive,
+                     const char* destination,
+                     size_t threads,
+                     const PresetDictionary<>& dictionary,
+                     const std::vector<std::string>& names) {
+  ContainerHeader header;
+  ArchiveDirectory directory;
+
+  // Nothing is created for an archive that cannot be decoded
+  if (!read_archive(archive, header, directory) ||
+      header.dictionary_id != dictionary.id()) {
+    return false;
+  }
+
+  if (!names.empty()) {
+    std::vector<std::string> missing;
+    std::vector<ArchiveMember> members = directory.select(names, &missing);
+
+    return extract_members(archive,
+                           header,
+                           directory,
+                           members,
+                           destination,
+                           threads,
+                           dictionary) &&
+           missing.empty();
+  }
+
+  AsyncReadBuffer input_buffer;
+  input_buffer.open(archive);
+  std::istream input_file(&input_buffer);
+  header.read(input_file);
+
+  // The frames end where the directory begins
+  BoundedStreamBuffer<char> frames(
+      &input_buffer, directory.frames.back() - directory.frames.front());
+
+  mkdir(destination, 0755);
+  MemberSink sink(directory.members, destination);
+  DecoderSplitters splitters;
+
+  bool decoded = decode_chunks(header,
+                               StreamBufferIterator<char>(&frames),
+                               StreamBufferIterator<char>(),
+                               sink,
+                               threads,
+                               0,
+                               dictionary,
+                               splitters);
+
+  return sink.close() && decoded;
+}
+
+bool verify_in_parallel(const char* input,
+                        size_t threads,
+                        const PresetDictionary<>& dictionary,
+                        DecodeError* error) {
+  AsyncReadBuffer input_buffer;
+  input_buffer.open(input);
+  std::istream input_file(&input_buffer);
+
+  ContainerHeader header;
+  header.read(input_file);
+
+  if (!header.supported() || header.dictionary_id != dictionary.id()) {
+    if (error) {
+      *error = DECODE_UNSUPPORTED;
+    }
+    return false;
+  }
+
+  // What is decoded is only checksummed
+  ChecksumSink<char> sink;
+  DecoderSplitters splitters;
+
+  if (!header.has(CONTAINER_ARCHIVE)) {
+    return decode_chunks(header,
+                         StreamBufferIterator<char>(&input_buffer),
+                         StreamBufferIterator<char>(),
+                         sink,
+                         threads,
+                         0,
+                         dictionary,
+                         splitters,
+                         error);
+  }
+
+  ContainerHeader archive_header;
+  ArchiveDirectory directory;
+  if (!read_archive(input, archive_header, directory)) {
+    if (error) {
+      *error = DECODE_INVALID_FRAME;
+    }
+    return false;
+  }
+
+  // The frames end where the directory begins
+  BoundedStreamBuffer<char> frames(
+      &input_buffer, directory.frames.back() - directory.frames.front());
+
+  bool decoded = decode_chunks(header,
+                               StreamBufferIterator<char>(&frames),
+                               StreamBufferIterator<char>(),
+                               sink,
+                               threads,
+                               0,
+                               dictionary,
+                               splitters,
+                               error);
+
+  if (!decoded) {
+    return false;
+  }
+
+  if (sink.size() != directory.content_size() ||
+      sink.checksum() != directory.checksum) {
+    if (error) {
+      *error = DECODE_CHECKSUM_MISMATCH;
+    }
+    return false;
+  }
 
-  process_in_parallel(input, output, threads, splitter);
+  return true;
 }
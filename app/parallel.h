@@ -4,32 +4,453 @@
 #include <fstream>
 #include <ios>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sinks.h"
+#include "utils.h"
+#include "preset_dictionary.h"
+
+// The chunk size of containers that do not declare one
+static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1000;
+
+// The smallest chunk size, adaptive or requested
+static constexpr size_t MIN_CHUNK_SIZE = 16 * 1024;
+
+// The size of the LZSS window of the chunks
+static constexpr size_t LZSS_WINDOW_SIZE = 1 << 12;
+
+/**
+ * Choose the size of the chunks of a sequence: small enough that every thread
+ * gets a few chunks to balance, but large enough that the LZSS window warming
+ * up at the beginning of each chunk, the Huffman table and the frame header of
+ * each chunk cost little, and no larger than what stops paying off in ratio.
+ *
+ * @param size        the size of the sequence
+ * @param threads     the number of threads, 0 for one per hardware thread
+ * @param window_size the size of the LZSS window
+ * @return the chunk size, at least MIN_CHUNK_SIZE
+ */
+size_t adaptive_chunk_size(size_t size,
+                           size_t threads,
+                           size_t window_size = LZSS_WINDOW_SIZE);
+
+/**
+ * What encode_in_parallel() or archive_in_parallel() did.
+ */
+struct EncodingStats {
+  size_t input_size = 0;
+  size_t output_size = 0;
+  size_t chunk_size = 0;
+  size_t chunks = 0;
+  // The files and directories of an archive that could not be read
+  size_t unreadable = 0;
+};
 
 template <typename SplitterType>
-static void process_in_parallel(const char* input,
-                                const char* output,
+static bool process_in_parallel(std::istream& input_stream,
+                                std::ostream& output_stream,
                                 size_t threads,
-                                SplitterType& splitter) {
-  std::ifstream input_file(input, std::ios::binary);
-  std::ofstream output_file(output, std::ios::binary | std::ios::trunc);
+                                SplitterType& splitter,
+                                size_t chunk_size = DEFAULT_CHUNK_SIZE) {
+  input_stream >> std::noskipws;
 
-  input_file >> std::noskipws;
+  StreamSink<char> sink(output_stream);
+  return splitter.split(std::istreambuf_iterator<char>(input_stream.rdbuf()),
+                        std::istreambuf_iterator<char>(),
+                        sink,
+                        threads,
+                        chunk_size);
+}
 
-  splitter(std::istreambuf_iterator<char>(input_file.rdbuf()),
-           std::istreambuf_iterator<char>(),
-           std::ostreambuf_iterator<char>(output_file),
-           threads,
-           64 * 1000);
+/**
+ * Encode a file with LZSS and Huffman coding.
+ *
+ * @param input         the path of the file to encode
+ * @param output        the path of the encoded file
+ * @param threads       the number of threads to use, 0 for one per
+ *                      hardware thread
+ * @param boyer_moore   whether to look for matches with Boyer-Moore or not
+ * @param token_streams whether to entropy code LZSS literals, lengths,
+ *                      positions and flags separately or not
+ * @param primed        whether to prime the LZSS dictionary of each chunk
+ *                      with the end of the previous chunk or not
+ * @param dictionary    the preset dictionary the LZSS dictionary starts from
+ *                      (the first chunk's only, if primed), if not empty
+ * @param positioned_writes whether to preallocate the encoded file and write
+ *                          each chunk at its offset as soon as the chunks
+ *                          before it are done (see FileSink), or to write
+ *                          the chunks one after the other
+ * @param threads_per_node  the number of threads pinned to each NUMA node in
+ *                          turn, with the buffers they use allocated there;
+ *                          0 leaves the threads to the system
+ * @param chunk_size        the size of the chunks, 0 for
+ *                          adaptive_chunk_size(); at least MIN_CHUNK_SIZE
+ * @param content_defined   whether to end the chunks at content-defined
+ *                          boundaries, chunk_size being the largest (see
+ *                          GearChunker), so that editing the file only
+ *                          changes the chunks around the edits
+ * @param deduplicate       whether to write the chunks that repeat a recent
+ *                          chunk as references to it (see ChunkIndex)
+ * @param checksums         whether to end each frame with the CRC-32C of its
+ *                          chunk, checked when the chunk is decoded
+ * @param grouped_flags     whether to group the LZSS flags of every 8 tokens
+ *                          in a control byte ahead of them, which decodes
+ *                          faster (see LZSSGroupedEncoder); ignored with
+ *                          token streams
+ * @return the sizes of the input, the output and the chunks
+ */
+EncodingStats encode_in_parallel(
+    const char* input,
+    const char* output,
+    size_t threads,
+    bool boyer_moore = true,
+    bool token_streams = false,
+    bool primed = false,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    bool positioned_writes = false,
+    size_t threads_per_node = 0,
+    size_t chunk_size = 0,
+    bool content_defined = false,
+    bool deduplicate = false,
+    bool checksums = false,
+    bool grouped_flags = false);
 
-  input_file.close();
-  output_file.close();
-}
+/**
+ * @param size the size of a sequence
+ * @return the maximum size of the output of compress() for that sequence
+ */
+size_t compress_bound(size_t size);
+
+/**
+ * Encode a sequence in memory with LZSS and Huffman coding, producing the
+ * same container as encode_in_parallel().
+ *
+ * @param source        a pointer to the sequence to encode
+ * @param size          the size of the sequence
+ * @param destination   a pointer to the memory the container is written to
+ * @param capacity      the size of that memory (see compress_bound())
+ * @param threads       the number of threads to use, 0 for one per
+ *                      hardware thread
+ * @param boyer_moore   whether to look for matches with Boyer-Moore or not
+ * @param token_streams whether to entropy code LZSS literals, lengths,
+ *                      positions and flags separately or not
+ * @param primed        whether to prime the LZSS dictionary of each chunk
+ *                      with the end of the previous chunk or not
+ * @param dictionary    the preset dictionary the LZSS dictionary starts from
+ *                      (the first chunk's only, if primed), if not empty
+ * @param chunk_size    the size of the chunks, 0 for adaptive_chunk_size();
+ *                      at least MIN_CHUNK_SIZE
+ * @param checksums     whether to end each frame with the CRC-32C of its
+ *                      chunk, checked when the chunk is decoded
+ * @param grouped_flags whether to group the LZSS flags of every 8 tokens in a
+ *                      control byte ahead of them; ignored with token streams
+ * @return the size of the container, or OUTPUT_OVERFLOW if it did not fit
+ */
+size_t compress(const void* source,
+                size_t size,
+                void* destination,
+                size_t capacity,
+                size_t threads = 0,
+                bool boyer_moore = true,
+                bool token_streams = false,
+                bool primed = false,
+                const PresetDictionary<>& dictionary = PresetDictionary<>(),
+                size_t chunk_size = 0,
+                bool checksums = false,
+                bool grouped_flags = false);
+
+struct EncoderSplitters;
+
+/**
+ * The state of compress() kept between calls: the buffers, LZSS dictionaries
+ * and Huffman tables of the pipelines are reset rather than allocated again
+ * for each sequence, which matters when compressing many short ones.
+ *
+ * A context compresses one sequence at a time.
+ */
+class CompressionContext {
+ public:
+  /**
+   * Construct a CompressionContext.
+   *
+   * @param threads       the number of threads to use, 0 for one per
+   *                      hardware thread
+   * @param boyer_moore   whether to look for matches with Boyer-Moore or not
+   * @param token_streams whether to entropy code LZSS literals, lengths,
+   *                      positions and flags separately or not
+   * @param primed        whether to prime the LZSS dictionary of each chunk
+   *                      with the end of the previous chunk or not
+   * @param dictionary    the preset dictionary the LZSS dictionary starts from
+   *                      (the first chunk's only, if primed), if not empty
+   * @param chunk_size    the size of the chunks, 0 for adaptive_chunk_size()
+   *                      of each sequence; at least MIN_CHUNK_SIZE
+   * @param checksums     whether to end each frame with the CRC-32C of its
+   *                      chunk
+   * @param grouped_flags whether to group the LZSS flags of every 8 tokens in
+   *                      a control byte ahead of them; ignored with token
+   *                      streams
+   */
+  explicit CompressionContext(
+      size_t threads = 0,
+      bool boyer_moore = true,
+      bool token_streams = false,
+      bool primed = false,
+      const PresetDictionary<>& dictionary = PresetDictionary<>(),
+      size_t chunk_size = 0,
+      bool checksums = false,
+      bool grouped_flags = false);
+
+  ~CompressionContext();
+
+  /**
+   * Encode a sequence in memory (see ::compress()).
+   *
+   * @param source      a pointer to the sequence to encode
+   * @param size        the size of the sequence
+   * @param destination a pointer to the memory the container is written to
+   * @param capacity    the size of that memory (see compress_bound())
+   * @return the size of the container, or OUTPUT_OVERFLOW if it did not fit
+   */
+  size_t compress(const void* source,
+                  size_t size,
+                  void* destination,
+                  size_t capacity);
+
+ private:
+  size_t _threads;
+  bool _boyer_moore;
+  bool _token_streams;
+  bool _primed;
+  PresetDictionary<> _dictionary;
+  size_t _chunk_size;
+  bool _checksums;
+  bool _grouped_flags;
+  std::unique_ptr<EncoderSplitters> _splitters;
+};
+
+/**
+ * Decode a file encoded by encode_in_parallel().
+ *
+ * @param input      the path of the file to decode
+ * @param output     the path of the decoded file
+ * @param threads    the number of threads to use, 0 for one per
+ *                   hardware thread
+ * @param dictionary the preset dictionary the file was encoded with, if any
+ * @param positioned_writes whether to write each chunk at its offset as soon
+ *                          as the chunks before it are done (see FileSink),
+ *                          or to write the chunks one after the other
+ * @param threads_per_node  see encode_in_parallel()
+ * @param[out] error        why the file could not be decoded, if not null
+ * @return false if the file was written by an unsupported version, with
+ *         another preset dictionary, or is corrupted (a chunk not matching
+ *         its checksum, if the file has them)
+ */
+bool decode_in_parallel(
+    const char* input,
+    const char* output,
+    size_t threads,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    bool positioned_writes = false,
+    size_t threads_per_node = 0,
+    DecodeError* error = nullptr);
+
+/**
+ * Decode a file encoded by encode_in_parallel() in constant memory, reading,
+ * decoding and writing it a block at a time on the calling thread (see
+ * IncrementalDecoder), whatever the size of the file and of its chunks.
+ *
+ * @param input      the path of the file to decode
+ * @param output     the path of the decoded file
+ * @param dictionary the preset dictionary the file was encoded with, if any
+ * @param[out] error why the file could not be decoded, if not null
+ * @return false if the file was written by an unsupported version, with
+ *         another preset dictionary, with token streams or references to
+ *         earlier chunks, or is corrupted
+ */
+bool decode_incrementally(
+    const char* input,
+    const char* output,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    DecodeError* error = nullptr);
+
+/**
+ * Check a file encoded by encode_in_parallel(), or an archive written by
+ * archive_in_parallel(), by decoding it without writing what is decoded.
+ * The chunks of an archive are checked against their checksums, and its
+ * content against the checksum in its directory; the chunks of other files
+ * only if they were encoded with checksums.
+ *
+ * @param input      the path of the file to check
+ * @param threads    the number of threads to use, 0 for one per
+ *                   hardware thread
+ * @param dictionary the preset dictionary the file was encoded with, if any
+ * @param[out] error why the file is not valid, if not null
+ * @return false if the file was written by an unsupported version, with
+ *         another preset dictionary, or is corrupted
+ */
+bool verify_in_parallel(
+    const char* input,
+    size_t threads,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    DecodeError* error = nullptr);
+
+/**
+ * The size returned by decompress() for a container written by an unsupported
+ * version, with another preset dictionary, or corrupted.
+ */
+static constexpr size_t INVALID_INPUT = OUTPUT_OVERFLOW - 1;
+
+struct DecoderSplitters;
+
+/**
+ * The state of decompress() kept between calls (see CompressionContext).
+ *
+ * A context decompresses one container at a time.
+ */
+class DecompressionContext {
+ public:
+  /**
+   * Construct a DecompressionContext.
+   *
+   * @param threads    the number of threads to use, 0 for one per
+   *                   hardware thread
+   * @param dictionary the preset dictionary the containers were encoded with,
+   *                   if any
+   */
+  explicit DecompressionContext(
+      size_t threads = 0,
+      const PresetDictionary<>& dictionary = PresetDictionary<>());
+
+  ~DecompressionContext();
+
+  /**
+   * Decode in memory a container (see ::decompress()).
+   *
+   * @param source      a pointer to the container
+   * @param size        the size of the container
+   * @param destination a pointer to the memory the sequence is written to
+   * @param capacity    the size of that memory
+   * @return the size of the decoded sequence, INVALID_INPUT, or
+   *         OUTPUT_OVERFLOW if it did not fit
+   */
+  size_t decompress(const void* source,
+                    size_t size,
+                    void* destination,
+                    size_t capacity);
+
+  /**
+   * @return why the last container could not be decoded, DECODE_OK if it
+   *         was; a corrupted container is rejected without reading past it
+   *         nor writing past the memory it is decoded to
+   */
+  DecodeError error() const { return _error; }
+
+ private:
+  size_t _threads;
+  PresetDictionary<> _dictionary;
+  std::unique_ptr<DecoderSplitters> _splitters;
+  DecodeError _error = DECODE_OK;
+};
+
+/**
+ * Decode in memory a container written by compress() or encode_in_parallel().
+ *
+ * @param source      a pointer to the container
+ * @param size        the size of the container
+ * @param destination a pointer to the memory the sequence is written to
+ * @param capacity    the size of that memory
+ * @param threads     the number of threads to use, 0 for one per
+ *                    hardware thread
+ * @param dictionary  the preset dictionary the container was encoded with, if
+ *                    any
+ * @return the size of the decoded sequence, INVALID_INPUT, or OUTPUT_OVERFLOW
+ *         if it did not fit
+ */
+size_t decompress(const void* source,
+                  size_t size,
+                  void* destination,
+                  size_t capacity,
+                  size_t threads = 0,
+                  const PresetDictionary<>& dictionary = PresetDictionary<>());
+
+struct ArchiveDirectory;
+
+/**
+ * Encode files and directory trees into an archive: a container whose chunks
+ * hold the contents of the files one after the other, followed by a central
+ * directory (see ArchiveDirectory). Small files share chunks and large files
+ * span many, so that every thread has work whatever the sizes of the files;
+ * the trees are walked and the small files read by a pool of threads.
+ *
+ * Chunks are of a fixed size and are not primed, so that the chunks holding a
+ * file are found from its offset. Each frame ends with the CRC-32C of its
+ * chunk, and the directory holds that of the whole content, combined from
+ * those of the chunks (see CRC32C::combine()).
+ *
+ * @param inputs        the paths of the files and directories to archive
+ * @param output        the path of the archive
+ * @param threads       the number of threads to use, 0 for one per
+ *                      hardware thread
+ * @param boyer_moore   whether to look for matches with Boyer-Moore or not
+ * @param token_streams whether to entropy code LZSS literals, lengths,
+ *                      positions and flags separately or not
+ * @param dictionary    the preset dictionary the LZSS dictionary of each chunk
+ *                      starts from, if not empty
+ * @param chunk_size    the size of the chunks, 0 for adaptive_chunk_size();
+ *                      at least MIN_CHUNK_SIZE
+ * @param deduplicate   whether to write the chunks that repeat a recent chunk
+ *                      as references to it (see ChunkIndex)
+ * @param grouped_flags whether to group the LZSS flags of every 8 tokens in a
+ *                      control byte ahead of them; ignored with token streams
+ * @return the sizes of the files, the archive and the chunks, and the number
+ *         of files and directories that could not be read
+ */
+EncodingStats archive_in_parallel(
+    const std::vector<std::string>& inputs,
+    const char* output,
+    size_t threads,
+    bool boyer_moore = true,
+    bool token_streams = false,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    size_t chunk_size = 0,
+    bool deduplicate = false,
+    bool grouped_flags = false);
 
-void encode_in_parallel(const char* input,
-                        const char* output,
-                        size_t threads,
-                        bool boyer_moore = true);
+/**
+ * Read the directory of an archive written by archive_in_parallel(), without
+ * decoding its chunks.
+ *
+ * @param archive        the path of the archive
+ * @param[out] directory the directory of the archive
+ * @return false if the file is not an archive of a supported version, or is
+ *         corrupted
+ */
+bool list_archive(const char* archive, ArchiveDirectory& directory);
 
-void decode_in_parallel(const char* input, const char* output, size_t threads);
+/**
+ * Extract the members of an archive written by archive_in_parallel(), or some
+ * of them: the chunks holding those are then found from the directory, and
+ * only they are read and decoded, runs of consecutive chunks in parallel.
+ *
+ * @param archive     the path of the archive
+ * @param destination the directory the members are extracted to, created if
+ *                    needed
+ * @param threads     the number of threads to use, 0 for one per
+ *                    hardware thread
+ * @param dictionary  the preset dictionary the archive was encoded with, if
+ *                    any
+ * @param names       the paths of the members to extract, a directory
+ *                    standing for its entries too; empty for every member
+ * @return false if the archive was written by an unsupported version, with
+ *         another preset dictionary, or is corrupted, if a member could not
+ *         be written, or if a name is not that of a member
+ */
+bool extract_archive(
+    const char* archive,
+    const char* destination,
+    size_t threads,
+    const PresetDictionary<>& dictionary = PresetDictionary<>(),
+    const std::vector<std::string>& names = std::vector<std::string>());
 
 #endif /* PARALLEL_H */
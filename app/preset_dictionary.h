@@ -0,0 +1,228 @@
+#ifndef PRESET_DICTIONARY_H
+#define PRESET_DICTIONARY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include "span.h"
+
+// The size of the k-mers scored by PresetDictionary::train()
+static constexpr size_t DICTIONARY_KMER_SIZE = 8;
+
+// The size of the segments PresetDictionary::train() picks from the samples
+static constexpr size_t DICTIONARY_SEGMENT_SIZE = 64;
+
+/**
+ * A dictionary that LZ77 windows start from before the first symbol of a
+ * sequence, so that short sequences similar to the ones it was trained on
+ * (e.g. JSON records) can be encoded with matches from the beginning.
+ *
+ * The same dictionary must be given to the encoder and to the decoder: its
+ * id() is recorded in the encoded output to tell them apart.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class PresetDictionary {
+ public:
+  typedef std::vector<T> sample_type;
+
+  /**
+   * Construct an empty PresetDictionary.
+   */
+  PresetDictionary() = default;
+
+  /**
+   * Construct a PresetDictionary.
+   *
+   * @param begin an input iterator referring to the beginning of the content
+   * @param end   an input iterator referring to past-the-end of the content
+   */
+  template <typename InputIterator>
+  PresetDictionary(InputIterator begin, InputIterator end)
+      : _content(begin, end) {}
+
+  /**
+   * Build a dictionary from a sample corpus.
+   *
+   * Each k-mer of the samples scores the number of samples it occurs in;
+   * segments of the samples are then picked greedily by the total score of
+   * their k-mers not yet in the dictionary. The best segments are placed at
+   * the end of the dictionary, which stays in the window the longest.
+   *
+   * @param samples  the sample corpus
+   * @param max_size the maximum size of the dictionary, usually the size of
+   *                 the LZ77 window
+   * @return the trained dictionary
+   */
+  static PresetDictionary train(const std::vector<sample_type>& samples,
+                                size_t max_size);
+
+  /**
+   * Load a dictionary from a file.
+   *
+   * @param path the path of the file, which holds just the content
+   * @return the loaded dictionary, empty if the file could not be read
+   */
+  static PresetDictionary load(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    return PresetDictionary(std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>());
+  }
+
+  /**
+   * Save the dictionary to a file.
+   *
+   * @param path the path of the file
+   * @return whether or not the file was written
+   */
+  bool save(const char* path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(_content.data(), _content.size());
+    return static_cast<bool>(file);
+  }
+
+  /**
+   * @return the content of the dictionary
+   */
+  Span<const T> content() const {
+    return Span<const T>(_content.data(), _content.size());
+  }
+
+  /**
+   * @return whether or not the dictionary is empty
+   */
+  bool empty() const { return _content.empty(); }
+
+  /**
+   * @return the identifier of the dictionary (a FNV-1a hash of the content),
+   *         or 0 if it is empty
+   */
+  uint32_t id() const {
+    if (_content.empty()) {
+      return 0;
+    }
+
+    uint32_t hash = 2166136261u;
+    for (T symbol : _content) {
+      hash = (hash ^ static_cast<unsigned char>(symbol)) * 16777619u;
+    }
+
+    // 0 stands for no dictionary
+    return hash ? hash : 1;
+  }
+
+ private:
+  std::vector<T> _content;
+
+  static uint64_t kmer_hash(const T* kmer) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < DICTIONARY_KMER_SIZE; ++i) {
+      hash = (hash ^ static_cast<unsigned char>(kmer[i])) * 1099511628211ull;
+    }
+
+    return hash;
+  }
+};
+
+template <typename T>
+PresetDictionary<T> PresetDictionary<T>::train(
+    const std::vector<sample_type>& samples, size_t max_size) {
+  // Number the distinct k-mers and score them by the samples they occur in
+  std::unordered_map<uint64_t, uint32_t> kmer_ids;
+  std::vector<size_t> scores;
+  std::vector<size_t> last_sample;
+  std::vector<std::vector<uint32_t>> kmers(samples.size());
+
+  for (size_t s = 0; s < samples.size(); ++s) {
+    const sample_type& sample = samples[s];
+    if (sample.size() < DICTIONARY_KMER_SIZE) {
+      continue;
+    }
+
+    for (size_t i = 0; i + DICTIONARY_KMER_SIZE <= sample.size(); ++i) {
+      auto inserted =
+          kmer_ids.emplace(kmer_hash(sample.data() + i), scores.size());
+      uint32_t id = inserted.first->second;
+
+      if (inserted.second) {
+        scores.push_back(0);
+        last_sample.push_back(samples.size());
+      }
+
+      if (last_sample[id] != s) {
+        last_sample[id] = s;
+        ++scores[id];
+      }
+
+      kmers[s].push_back(id);
+    }
+  }
+
+  // A k-mer seen in a single sample is not worth a place
+  for (auto& score : scores) {
+    if (score < 2) {
+      score = 0;
+    }
+  }
+
+  // Pick segments greedily, filling the dictionary from its end
+  std::vector<T> content(max_size);
+  size_t begin = max_size;
+  size_t kmers_per_segment = DICTIONARY_SEGMENT_SIZE - DICTIONARY_KMER_SIZE + 1;
+
+  while (begin > 0) {
+    size_t best_score = 0;
+    size_t best_sample = 0;
+    size_t best_offset = 0;
+
+    for (size_t s = 0; s < samples.size(); ++s) {
+      const auto& ids = kmers[s];
+      size_t score = 0;
+
+      // Slide a window of kmers_per_segment k-mers over the sample
+      for (size_t i = 0; i < ids.size(); ++i) {
+        score += scores[ids[i]];
+        if (i >= kmers_per_segment) {
+          score -= scores[ids[i - kmers_per_segment]];
+        }
+
+        if (score > best_score) {
+          best_score = score;
+          best_sample = s;
+          best_offset =
+              i + 1 > kmers_per_segment ? i + 1 - kmers_per_segment : 0;
+        }
+      }
+    }
+
+    if (best_score == 0) {
+      break;
+    }
+
+    const sample_type& sample = samples[best_sample];
+    size_t size = std::min({DICTIONARY_SEGMENT_SIZE,
+                            sample.size() - best_offset,
+                            begin});
+
+    begin -= size;
+    std::copy(sample.begin() + best_offset,
+              sample.begin() + best_offset + size,
+              content.begin() + begin);
+
+    // The k-mers of the segment are now in the dictionary
+    const auto& ids = kmers[best_sample];
+    for (size_t i = best_offset;
+         i < std::min(best_offset + kmers_per_segment, ids.size());
+         ++i) {
+      scores[ids[i]] = 0;
+    }
+  }
+
+  return PresetDictionary(content.begin() + begin, content.end());
+}
+
+#endif /* PRESET_DICTIONARY_H */
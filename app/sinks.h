@@ -0,0 +1,316 @@
+#ifndef SINKS_H
+#define SINKS_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include "checksum.h"
+
+/**
+ * Whether or not chunks are written to a Sink at given offsets.
+ *
+ * A positioned sink has, besides write(), a @c place(size) member function
+ * that reserves the next @c size symbols of the output and returns their
+ * offset, and a @c write_at(offset, data, size) member function that writes
+ * them and may run concurrently with the writes of other places.
+ *
+ * @tparam Sink the type of the sink
+ */
+template <typename Sink, typename = void>
+struct is_positioned_sink : std::false_type {};
+
+template <typename Sink>
+struct is_positioned_sink<
+    Sink,
+    decltype(std::declval<Sink&>().write_at(
+                 std::declval<Sink&>().place(size_t()), nullptr, size_t()),
+             void())> : std::true_type {};
+
+/**
+ * A sink that writes whole chunks through an output iterator, one symbol at a
+ * time.
+ *
+ * @tparam OutputIterator an output iterator type
+ */
+template <typename OutputIterator>
+class IteratorSink {
+ public:
+  /**
+   * Construct an IteratorSink.
+   *
+   * @param output_iterator the output iterator to write to
+   */
+  explicit IteratorSink(const OutputIterator& output_iterator)
+      : _output_iterator(output_iterator) {}
+
+  /**
+   * Write a chunk.
+   *
+   * @param[in] data a pointer to the chunk
+   * @param     size the size of the chunk
+   */
+  template <typename T>
+  void write(const T* data, size_t size) {
+    _output_iterator = std::copy(data, data + size, _output_iterator);
+  }
+
+ private:
+  OutputIterator _output_iterator;
+};
+
+/**
+ * A sink that writes whole chunks to an output stream with a single call.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class StreamSink {
+ public:
+  /**
+   * Construct a StreamSink.
+   *
+   * @param[out] output_stream the stream to write to
+   */
+  explicit StreamSink(std::basic_ostream<T>& output_stream)
+      : _output_stream(output_stream) {}
+
+  /**
+   * Write a chunk.
+   *
+   * @param[in] data a pointer to the chunk
+   * @param     size the size of the chunk
+   */
+  void write(const T* data, size_t size) { _output_stream.write(data, size); }
+
+ private:
+  std::basic_ostream<T>& _output_stream;
+};
+
+/**
+ * A positioned sink that writes whole chunks to a file with pwrite(), so that
+ * chunks are written as soon as their offset is known rather than after the
+ * chunks before them (see is_positioned_sink).
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class FileSink {
+ public:
+  /**
+   * Construct a FileSink.
+   *
+   * @param path the path of the file to create or truncate
+   */
+  explicit FileSink(const char* path)
+      : _fd(open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)),
+        _failed(_fd < 0) {}
+
+  ~FileSink() { close(); }
+
+  FileSink(const FileSink&) = delete;
+  FileSink& operator=(const FileSink&) = delete;
+
+  /**
+   * Preallocate the blocks of the file, so that writes at offsets past its
+   * end do not have to allocate them one write at a time. The blocks past
+   * the last symbol written are released by close().
+   *
+   * @param size the maximum number of symbols written
+   */
+  void reserve(size_t size) {
+#ifdef __linux__
+    if (_fd >= 0) {
+      fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, size * sizeof(T));
+    }
+#else
+    (void)size;
+#endif
+  }
+
+  /**
+   * Reserve the next symbols of the file.
+   *
+   * @param size the number of symbols
+   * @return the offset of the first one
+   */
+  size_t place(size_t size) {
+    size_t offset = _size;
+    _size += size;
+    return offset;
+  }
+
+  /**
+   * Write a chunk at a place.
+   *
+   * @param     offset the offset of the chunk (see place())
+   * @param[in] data   a pointer to the chunk
+   * @param     size   the size of the chunk
+   */
+  void write_at(size_t offset, const T* data, size_t size) {
+    const char* bytes = reinterpret_cast<const char*>(data);
+    size_t remaining = size * sizeof(T);
+    off_t position = offset * sizeof(T);
+
+    while (remaining > 0) {
+      ssize_t written = pwrite(_fd, bytes, remaining, position);
+      if (written <= 0) {
+        _failed = true;
+        return;
+      }
+
+      bytes += written;
+      remaining -= written;
+      position += written;
+    }
+  }
+
+  /**
+   * Write a chunk after the ones placed before it.
+   *
+   * @param[in] data a pointer to the chunk
+   * @param     size the size of the chunk
+   */
+  void write(const T* data, size_t size) { write_at(place(size), data, size); }
+
+  /**
+   * Release the blocks reserved past the last symbol, then close the file.
+   *
+   * @return whether or not every chunk was written
+   */
+  bool close() {
+    if (_fd >= 0) {
+      if (ftruncate(_fd, _size * sizeof(T)) != 0) {
+        _failed = true;
+      }
+
+      ::close(_fd);
+      _fd = -1;
+    }
+
+    return !_failed;
+  }
+
+  /**
+   * @return the number of symbols placed
+   */
+  size_t size() const { return _size; }
+
+ private:
+  int _fd;
+  size_t _size = 0;
+  std::atomic<bool> _failed;
+};
+
+/**
+ * A positioned sink that writes whole chunks to a fixed-size memory area;
+ * chunks that do not fit are dropped and the sink overflows.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class MemorySink {
+ public:
+  /**
+   * Construct a MemorySink.
+   *
+   * @param[out] data     a pointer to the memory to write to
+   * @param      capacity the size of the memory
+   */
+  MemorySink(T* data, size_t capacity) : _data(data), _capacity(capacity) {}
+
+  /**
+   * Reserve the next symbols of the memory area.
+   *
+   * @param size the number of symbols
+   * @return the offset of the first one, past the end of the memory area if
+   *         they do not fit
+   */
+  size_t place(size_t size) {
+    if (_overflow || size > _capacity - _size) {
+      _overflow = true;
+      return _capacity;
+    }
+
+    size_t offset = _size;
+    _size += size;
+    return offset;
+  }
+
+  /**
+   * Write a chunk at a place, unless it is past the end of the memory area.
+   *
+   * @param     offset the offset of the chunk (see place())
+   * @param[in] data   a pointer to the chunk
+   * @param     size   the size of the chunk
+   */
+  void write_at(size_t offset, const T* data, size_t size) {
+    if (offset + size <= _capacity) {
+      std::copy(data, data + size, _data + offset);
+    }
+  }
+
+  /**
+   * Write a chunk after the ones placed before it.
+   *
+   * @param[in] data a pointer to the chunk
+   * @param     size the size of the chunk
+   */
+  void write(const T* data, size_t size) { write_at(place(size), data, size); }
+
+  /**
+   * @return the number of symbols written
+   */
+  size_t size() const { return _size; }
+
+  /**
+   * @return whether or not a chunk did not fit
+   */
+  bool overflow() const { return _overflow; }
+
+ private:
+  T* _data;
+  size_t _capacity;
+  size_t _size = 0;
+  bool _overflow = false;
+};
+
+/**
+ * A sink that keeps only the CRC-32C and the size of what is written to it,
+ * to check decoded data without storing it.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class ChecksumSink {
+ public:
+  /**
+   * Write a chunk.
+   *
+   * @param[in] data a pointer to the chunk
+   * @param     size the size of the chunk
+   */
+  void write(const T* data, size_t size) {
+    _checksum = CRC32C::extend(_checksum, data, size * sizeof(T));
+    _size += size;
+  }
+
+  /**
+   * @return the CRC-32C of the symbols written (see CRC32C)
+   */
+  uint32_t checksum() const { return _checksum; }
+
+  /**
+   * @return the number of symbols written
+   */
+  size_t size() const { return _size; }
+
+ private:
+  uint32_t _checksum = 0;
+  size_t _size = 0;
+};
+
+#endif /* SINKS_H */
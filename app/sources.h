@@ -0,0 +1,181 @@
+#ifndef SOURCES_H
+#define SOURCES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <streambuf>
+#include <string>
+
+/**
+ * An input iterator over the symbols of a stream buffer, like
+ * std::istreambuf_iterator, that also gives access to the buffer so that
+ * blocks of symbols are read with a single call (see read_block()).
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class StreamBufferIterator {
+ public:
+  typedef std::input_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const T* pointer;
+  typedef T reference;
+  typedef std::basic_streambuf<T> buffer_type;
+
+  /**
+   * Construct the past-the-end StreamBufferIterator.
+   */
+  StreamBufferIterator() : _buffer(nullptr) {}
+
+  /**
+   * Construct a StreamBufferIterator.
+   *
+   * @param buffer the stream buffer to read from
+   */
+  explicit StreamBufferIterator(buffer_type* buffer) : _buffer(buffer) {}
+
+  T operator*() const { return traits_type::to_char_type(_buffer->sgetc()); }
+
+  StreamBufferIterator& operator++() {
+    _buffer->sbumpc();
+    return *this;
+  }
+
+  bool operator==(const StreamBufferIterator& rhs) const {
+    return at_end() == rhs.at_end();
+  }
+
+  bool operator!=(const StreamBufferIterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * @return the stream buffer, @c nullptr for the past-the-end iterator
+   */
+  buffer_type* buffer() const { return _buffer; }
+
+ private:
+  typedef std::char_traits<T> traits_type;
+
+  buffer_type* _buffer;
+
+  bool at_end() const {
+    return !_buffer ||
+           traits_type::eq_int_type(_buffer->sgetc(), traits_type::eof());
+  }
+};
+
+/**
+ * A stream buffer that reads at most a given number of symbols from another
+ * stream buffer, e.g. the part of a file before a trailer.
+ *
+ * Blocks are read from the other stream buffer with a single call, without
+ * being copied into this one.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T = char>
+class BoundedStreamBuffer : public std::basic_streambuf<T> {
+ public:
+  typedef typename std::basic_streambuf<T>::int_type int_type;
+  typedef std::char_traits<T> traits_type;
+
+  /**
+   * Construct a BoundedStreamBuffer.
+   *
+   * @param buffer the stream buffer to read from
+   * @param size   the number of symbols to read from it
+   */
+  BoundedStreamBuffer(std::basic_streambuf<T>* buffer, size_t size)
+      : _buffer(buffer), _remaining(size) {}
+
+ protected:
+  int_type underflow() override {
+    if (!_remaining) {
+      return traits_type::eof();
+    }
+
+    int_type symbol = _buffer->sbumpc();
+    if (traits_type::eq_int_type(symbol, traits_type::eof())) {
+      _remaining = 0;
+      return symbol;
+    }
+
+    --_remaining;
+    _symbol = traits_type::to_char_type(symbol);
+    this->setg(&_symbol, &_symbol, &_symbol + 1);
+    return symbol;
+  }
+
+  std::streamsize xsgetn(T* output, std::streamsize count) override {
+    std::streamsize read = 0;
+    if (count > 0 && this->gptr() < this->egptr()) {
+      *output = *this->gptr();
+      this->gbump(1);
+      read = 1;
+    }
+
+    std::streamsize size = std::min<std::streamsize>(count - read, _remaining);
+    size = _buffer->sgetn(output + read, size);
+    _remaining -= size;
+    return read + size;
+  }
+
+ private:
+  std::basic_streambuf<T>* _buffer;
+  size_t _remaining;
+  T _symbol;
+};
+
+/**
+ * Read a block of symbols, one at a time.
+ *
+ * @param[out] begin an input iterator referring to the beginning of the
+ *                   symbols, moved past the symbols read
+ * @param      end   an input iterator referring to past-the-end of the
+ *                   symbols
+ * @param[out] output a pointer to at least @c size symbols
+ * @param      size   the number of symbols to read
+ * @return the number of symbols read, smaller than @c size only at @c end
+ */
+template <typename InputIterator, typename T>
+size_t read_block(InputIterator& begin,
+                  InputIterator end,
+                  T* output,
+                  size_t size) {
+  size_t count = 0;
+  for (; count < size && begin != end; ++count, ++begin) {
+    output[count] = *begin;
+  }
+
+  return count;
+}
+
+/**
+ * Read a block of symbols from memory with a single copy (see read_block()).
+ */
+template <typename T>
+size_t read_block(const T*& begin, const T* end, T* output, size_t size) {
+  size = std::min(size, static_cast<size_t>(end - begin));
+  std::memcpy(output, begin, size * sizeof(T));
+  begin += size;
+
+  return size;
+}
+
+/**
+ * Read a block of symbols from a stream buffer with a single call (see
+ * read_block()).
+ */
+template <typename T>
+size_t read_block(StreamBufferIterator<T>& begin,
+                  StreamBufferIterator<T>,
+                  T* output,
+                  size_t size) {
+  return begin.buffer() ? begin.buffer()->sgetn(output, size) : 0;
+}
+
+#endif /* SOURCES_H */
@@ -0,0 +1,81 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <limits>
+
+/**
+ * A non-owning view over a contiguous sequence of objects.
+ *
+ * @tparam T the type of the objects
+ */
+template <typename T>
+class Span {
+ public:
+  typedef T value_type;
+  typedef T* iterator;
+
+  /**
+   * Construct a Span.
+   *
+   * @param data a pointer to the first object
+   * @param size the number of objects
+   */
+  Span(T* data = nullptr, size_t size = 0) : _data(data), _size(size) {}
+
+  /**
+   * Construct a Span from a Span of convertible objects (e.g. a
+   * <tt>Span<const T></tt> from a <tt>Span<T></tt>).
+   */
+  template <typename U>
+  Span(const Span<U>& other)
+      : _data(other.data()), _size(other.size()) {}
+
+  /**
+   * @return a pointer to the first object
+   */
+  T* data() const { return _data; }
+
+  /**
+   * @return the number of objects
+   */
+  size_t size() const { return _size; }
+
+  /**
+   * @return whether or not the Span is empty
+   */
+  bool empty() const { return _size == 0; }
+
+  /**
+   * @return an iterator referring to the first object
+   */
+  T* begin() const { return _data; }
+
+  /**
+   * @return an iterator referring to past-the-end of the objects
+   */
+  T* end() const { return _data + _size; }
+
+  /**
+   * @param i the index
+   * @return the requested object
+   */
+  T& operator[](size_t i) const { return _data[i]; }
+
+  /**
+   * @param offset the index of the first object of the subspan
+   * @param count  the maximum number of objects of the subspan
+   * @return a Span over a part of this Span
+   */
+  Span subspan(size_t offset,
+               size_t count = std::numeric_limits<size_t>::max()) const {
+    size_t available = offset < _size ? _size - offset : 0;
+    return Span(_data + offset, count < available ? count : available);
+  }
+
+ private:
+  T* _data;
+  size_t _size;
+};
+
+#endif /* SPAN_H */
@@ -1,114 +1,854 @@
 #ifndef SPLITTER_H
 #define SPLITTER_H
 
-#include <thread>
 #include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 #include "utils.h"
-#include "buffers.h"
+#include "checksum.h"
+#include "chunker.h"
+#include "dedup.h"
+#include "executor.h"
+#include "frames.h"
+#include "sinks.h"
+#include "span.h"
 
 /**
- * A functor that processes a sequence by splitting it into chunks and assigning
- * each chunk to a separate thread; each thread runs a pipeline with two Worker
- * instances.
+ * What a chunk processed by Splitter knows about the chunk before it.
+ *
+ * Frames policies that prime chunks from their output get the dictionary of a
+ * chunk from here: either a preset dictionary shared by every chunk, or the
+ * end of the output of the previous chunks, which is extended with the output
+ * of this chunk for the next one. Chained chunks run their second stage one
+ * after the other, so that the dictionary is complete when it is read.
+ *
+ * @tparam T the type of the symbols
+ */
+template <typename T>
+class ChunkLink {
+ public:
+  /**
+   * Construct a ChunkLink.
+   *
+   * @param[out] dictionary     the dictionary of the chunk
+   * @param max_dictionary_size the maximum size of @c dictionary once
+   *                            extended; 0 if chunks are not chained, i.e.
+   *                            @c dictionary is only read
+   */
+  ChunkLink(std::vector<T>* dictionary, size_t max_dictionary_size)
+      : _dictionary(dictionary), _max_dictionary_size(max_dictionary_size) {}
+
+  ChunkLink(const ChunkLink&) = delete;
+
+  /**
+   * @return whether or not the chunk is primed with a dictionary
+   */
+  bool primed() const {
+    return _max_dictionary_size > 0 || !_dictionary->empty();
+  }
+
+  /**
+   * @return the dictionary of the chunk
+   */
+  Span<const T> dictionary() const {
+    return Span<const T>(_dictionary->data(), _dictionary->size());
+  }
+
+  /**
+   * If chunks are chained, append the output of this chunk to the dictionary,
+   * keeping only its last symbols.
+   *
+   * @param output the output of this chunk
+   */
+  void extend(Span<const T> output) {
+    if (!_max_dictionary_size) {
+      return;
+    }
+
+    if (output.size() >= _max_dictionary_size) {
+      _dictionary->assign(output.end() - _max_dictionary_size, output.end());
+      return;
+    }
+
+    _dictionary->insert(_dictionary->end(), output.begin(), output.end());
+
+    if (_dictionary->size() > _max_dictionary_size) {
+      _dictionary->erase(_dictionary->begin(),
+                         _dictionary->end() - _max_dictionary_size);
+    }
+  }
+
+ private:
+  std::vector<T>* _dictionary;
+  size_t _max_dictionary_size;
+};
+
+/**
+ * A functor that processes a sequence by splitting it into chunks and running
+ * each chunk through a pipeline of two Worker instances.
+ *
+ * The two stages of each chunk are separate tasks of a WorkStealingExecutor:
+ * a thread that is done with a cheap chunk (e.g. a repetitive one, on which
+ * LZSS finds long matches at once) takes the pending stages of the others,
+ * instead of a thread per chunk being throttled by the slowest ones. Chunks
+ * are written to the sink in order by whichever task completes the next one;
+ * a positioned sink (see is_positioned_sink) only places them in order, and
+ * each is written at its place while the chunks after it are being placed and
+ * written by other tasks.
+ *
+ * The Workers exchange chunks through their span-based interface, so that each
+ * stage writes directly into a buffer of the chunk and each chunk is handed to
+ * the sink with a single call.
+ *
+ * The frames policy sizes the buffers and decides how the output of the
+ * Workers is framed (see PlainFrames, EncoderFrames and DecoderFrames).
+ *
+ * Chunks may be primed with a preset dictionary and/or with the last symbols
+ * of the previous chunk, so that LZ77 matches can refer to them: policies
+ * that prime from the input find the dictionary at the beginning of the input
+ * buffer, the others through a ChunkLink.
+ *
+ * The threads may be pinned to NUMA nodes (see pin()): each slot of chunks in
+ * flight then has a home thread, that allocates its buffers and runs its
+ * first stage unless another thread of the node steals it.
+ *
+ * Chunks may end at content-defined boundaries (see cut_by_content()) instead
+ * of every chunk_size symbols, so that inserting symbols in a sequence only
+ * changes the chunks around them.
+ *
+ * Chunks that repeat one of the chunks shortly before them may be deduplicated
+ * (see deduplicate()): the encoder writes a reference to the earlier chunk
+ * instead of running the chunk through the pipeline, and the decoder copies
+ * the earlier chunk as the chunks complete in order.
+ *
+ * Chunks may be checksummed (see checksum()): each task computes or checks
+ * the CRC-32C of its chunk as part of its stages, in parallel.
+ *
+ * Buffers, Workers and threads are kept between sequences, so that processing
+ * many short sequences with the same Splitter does not allocate them again: a
+ * Splitter processes a single sequence at a time.
  *
  * @tparam W1 the type of the first Worker in the pipeline
  * @tparam W2 the type of the second Worker in the pipeline
  * @tparam T  the type of the symbols in the sequence
+ * @tparam F  the frames policy
  */
-template <typename W1, typename W2, typename T = char>
+template <typename W1, typename W2, typename T = char, typename F = PlainFrames>
 class Splitter {
  public:
+  /**
+   * Construct a Splitter.
+   *
+   * @param dictionary_size the number of symbols of the previous chunk each
+   *                        chunk is primed with; 0 disables priming
+   * @param preset_dictionary the dictionary of the first chunk, or of every
+   *                          chunk if priming is disabled
+   */
+  explicit Splitter(size_t dictionary_size = 0,
+                    Span<const T> preset_dictionary = Span<const T>())
+      : _dictionary_size(dictionary_size),
+        _preset_dictionary(preset_dictionary) {}
+
+  /**
+   * Change how the chunks of the next sequences are primed.
+   *
+   * @param dictionary_size   see Splitter()
+   * @param preset_dictionary see Splitter()
+   */
+  void prime(size_t dictionary_size,
+             Span<const T> preset_dictionary = Span<const T>()) {
+    _dictionary_size = dictionary_size;
+    _preset_dictionary = preset_dictionary;
+  }
+
+  /**
+   * Pin the threads of the next sequences to the NUMA nodes of the machine,
+   * so that each chunk is processed next to its buffers (see Topology).
+   *
+   * @param threads_per_node the number of threads on each node in turn; 0
+   *                         leaves the threads to the system
+   */
+  void pin(size_t threads_per_node) { _threads_per_node = threads_per_node; }
+
+  /**
+   * Cut the input of the next sequences into chunks at content-defined
+   * boundaries (see GearChunker::for_chunk_size()), rather than every
+   * chunk_size symbols. Only meaningful when the chunks are blocks of the
+   * input, i.e. when encoding.
+   *
+   * @param enabled whether or not chunks are cut by content
+   */
+  void cut_by_content(bool enabled) { _content_defined = enabled; }
+
+  /**
+   * Deduplicate the chunks of the next sequences: with a frames policy that
+   * writes references (see FrameReferences), a chunk that repeats one of the
+   * DEDUP_WINDOW chunks before it is written as a reference to it; with one
+   * that reads them, the references are replaced with the chunks they refer
+   * to, otherwise they are invalid.
+   *
+   * @param enabled whether or not chunks are deduplicated
+   */
+  void deduplicate(bool enabled) { _deduplicate = enabled; }
+
+  /**
+   * Checksum the chunks of the next sequences: with a frames policy that
+   * writes checksums (see FrameChecksums), the CRC-32C of each chunk is
+   * appended to its frame; with one that reads them, a chunk that does not
+   * match its checksum is invalid.
+   *
+   * @param enabled whether or not chunks are checksummed
+   */
+  void checksum(bool enabled) { _checksums = enabled; }
+
+  /**
+   * @return the number of chunks of the last sequence
+   */
+  size_t chunks() const { return _read; }
+
+  /**
+   * @return why the first chunk that could not be processed in the last
+   *         sequence was rejected, DECODE_OK if there is none
+   */
+  DecodeError error() const { return _error; }
+
+  /**
+   * @return the index of the first chunk that could not be processed in the
+   *         last sequence, meaningful only when error() is not DECODE_OK
+   */
+  size_t failed_chunk() const { return _failed_chunk; }
+
   template <typename InputIterator, typename OutputIterator>
-  void operator()(InputIterator begin,
+  bool operator()(InputIterator begin,
                   InputIterator end,
                   OutputIterator output_iterator,
                   size_t max_number_of_threads,
-                  size_t chunk_size);
+                  size_t chunk_size) {
+    IteratorSink<OutputIterator> sink(output_iterator);
+    return split(begin, end, sink, max_number_of_threads, chunk_size);
+  }
+
+  /**
+   * Process a sequence.
+   *
+   * @param begin an input iterator referring to the beginning of the sequence
+   * @param end   an input iterator referring to past-the-end of the sequence
+   * @param[out] sink the sink processed chunks are written to, in order (see
+   *                  StreamSink and is_positioned_sink)
+   * @param max_number_of_threads the number of threads running the pipelines,
+   *                              0 for default_threads(); a sequence of a
+   *                              single chunk, or a single thread, runs on
+   *                              the calling thread
+   * @param chunk_size            the size of each chunk, the maximum one if
+   *                              chunks are cut by content
+   * @return false if a chunk could not be processed; no chunk is read after it
+   */
+  template <typename InputIterator, typename Sink>
+  bool split(InputIterator begin,
+             InputIterator end,
+             Sink& sink,
+             size_t max_number_of_threads,
+             size_t chunk_size);
 
  private:
-  template <typename OutputIterator, typename Counter>
-  static void pipeline(T* input_buffer,
-                       size_t chunk_size,
-                       OutputIterator output_iterator,
-                       std::thread* previous_thread,
-                       Counter* counter,
-                       BufferPool<T>* buffer_pool);
+  // A chunk in flight, with the Workers and buffers of its pipeline
+  struct Chunk {
+    W1 first;
+    W2 second;
+    std::vector<T> input_buffer;
+    std::vector<T> intermediate_buffer;
+    size_t dictionary_size = 0;
+    size_t size = 0;
+    Frame<T> frame;
+    size_t offset = 0;
+    uint32_t checksum = 0;
+    bool first_stage_done = false;
+    bool done = false;
+    bool written = false;
+  };
+
+  size_t _dictionary_size;
+  Span<const T> _preset_dictionary;
+  size_t _threads_per_node = 0;
+  bool _content_defined = false;
+  bool _deduplicate = false;
+  bool _checksums = false;
+
+  // Kept between sequences
+  std::vector<Chunk> _chunks;
+  std::unique_ptr<WorkStealingExecutor> _executor;
+
+  // The state of the sequence being processed, guarded by _mutex
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  size_t _slots = 0;
+  size_t _buffer_size = 0;
+  bool _parallel = false;
+  size_t _read = 0;
+  size_t _placed = 0;
+  size_t _written = 0;
+  size_t _next_second_stage = 0;
+  bool _writing = false;
+  bool _failed = false;
+  DecodeError _error = DECODE_OK;
+  size_t _failed_chunk = 0;
+  std::vector<T> _output_dictionary;
+  ChunkIndex _index;
+  ChunkHistory<T> _history;
+
+  Chunk& chunk(size_t sequence) { return _chunks[sequence % _slots]; }
+
+  // The thread that allocates the buffers of a slot and runs its first stages
+  size_t home(size_t slot) const { return slot % _executor->size(); }
+
+  void start_executor(size_t threads) {
+    if (!_executor || _executor->size() != threads ||
+        _executor->threads_per_node() != _threads_per_node) {
+      _executor.reset(new WorkStealingExecutor(threads, _threads_per_node));
+    }
+  }
+
+  void allocate(size_t slot) {
+    _chunks[slot].input_buffer.resize(_buffer_size);
+    _chunks[slot].intermediate_buffer.resize(_buffer_size);
+  }
+
+  // Whether or not the second stage of each chunk waits for the previous one
+  bool chained() const { return !F::primed_from_input && _dictionary_size; }
+
+  // Write a chunk that repeats a recent one as a reference to it, if the
+  // frames policy writes references
+  bool refer(size_t sequence, Chunk& current, std::true_type);
+  bool refer(size_t, Chunk&, std::false_type) { return false; }
+
+  // Replace a reference with the chunk it refers to, if the frames policy
+  // reads references, and keep the chunk for the references after it: the
+  // chunks must complete in order, each called with _mutex locked
+  void resolve(size_t sequence, Frame<T>& frame);
+  void remember(const Frame<T>& frame);
+
+  // Stop at the first chunk whose frame is invalid, and remember why
+  void fail(size_t sequence, const Frame<T>& frame) {
+    if (!_failed) {
+      _failed = true;
+      _error = frame.error != DECODE_OK ? frame.error : DECODE_INVALID_FRAME;
+      _failed_chunk = sequence;
+    }
+  }
+
+  // Compute the checksum of a chunk before its first stage, and append it to
+  // its frame after the second one, if the frames policy writes checksums
+  void sum(Chunk& current) {
+    if (F::checksums == CHECKSUMS_WRITTEN && _checksums) {
+      current.checksum = crc32c(current.input_buffer.data() +
+                                    current.dictionary_size,
+                                current.size * sizeof(T));
+    }
+  }
+
+  void append_checksum(Chunk& current, std::true_type) {
+    if (_checksums && current.frame.valid) {
+      F::add_checksum(current.frame, current.checksum);
+    }
+  }
+
+  void append_checksum(Chunk&, std::false_type) {}
+
+  // Take the checksum off the frame of a chunk before its first stage, and
+  // check the decoded chunk against it, if the frames policy reads checksums
+  bool remove_checksum(Chunk& current, std::true_type) {
+    if (!_checksums) {
+      return true;
+    }
+
+    current.size = F::remove_checksum(
+        current.input_buffer.data(), current.size, current.checksum);
+    return current.size > 0;
+  }
+
+  bool remove_checksum(Chunk&, std::false_type) { return true; }
+
+  void verify(Chunk& current) {
+    Frame<T>& frame = current.frame;
+
+    if (F::checksums == CHECKSUMS_READ && _checksums && frame.valid &&
+        crc32c(frame.data, frame.size * sizeof(T)) != current.checksum) {
+      frame.reject(DECODE_CHECKSUM_MISMATCH);
+    }
+  }
+
+  template <typename Sink>
+  void submit_first_stage(size_t sequence, Sink* sink);
+
+  template <typename Sink>
+  void submit_second_stage(size_t sequence, Sink* sink);
+
+  template <typename Sink>
+  void first_stage(size_t sequence, Sink* sink);
+
+  template <typename Sink>
+  void second_stage(size_t sequence, Sink* sink);
+
+  template <typename Sink>
+  void write(std::unique_lock<std::mutex>& lock, Sink* sink) {
+    write(lock, sink, is_positioned_sink<Sink>());
+  }
+
+  template <typename Sink>
+  void write(std::unique_lock<std::mutex>& lock, Sink* sink, std::false_type);
+
+  template <typename Sink>
+  void write(std::unique_lock<std::mutex>& lock, Sink* sink, std::true_type);
 };
 
-template <typename W1, typename W2, typename T>
-template <typename InputIterator, typename OutputIterator>
-void Splitter<W1, W2, T>::operator()(InputIterator begin,
-                                     InputIterator end,
-                                     OutputIterator output_iterator,
-                                     size_t max_number_of_threads,
-                                     size_t chunk_size) {
-  typedef std::thread* thread_ptr;
-  typedef ThreadSafeCounter<decltype(max_number_of_threads)> counter_type;
-
-  thread_ptr previous_thread = nullptr;
-  counter_type counter(0);
-  BufferPool<char> buffer_pool(2 * max_number_of_threads + 1, chunk_size * 2);
-
-  while (begin != end) {
-    auto input_buffer = buffer_pool.get();
+template <typename W1, typename W2, typename T, typename F>
+template <typename InputIterator, typename Sink>
+bool Splitter<W1, W2, T, F>::split(InputIterator begin,
+                                   InputIterator end,
+                                   Sink& sink,
+                                   size_t max_number_of_threads,
+                                   size_t chunk_size) {
+  if (!max_number_of_threads) {
+    max_number_of_threads = default_threads();
+  }
+
+  // Enough chunks in flight to keep every thread busy while others are
+  // waiting to be written
+  _slots = max_number_of_threads > 1 ? 2 * max_number_of_threads : 1;
+  _buffer_size = F::template buffer_size<W1, W2>(chunk_size) +
+                 std::max(_dictionary_size, _preset_dictionary.size());
+
+  if (_chunks.size() < _slots) {
+    _chunks.resize(_slots);
+  }
+
+  // Pinned threads touch the buffers of their slots first, so that the
+  // memory is allocated on their node
+  bool pinned = _threads_per_node && max_number_of_threads > 1;
+  size_t allocating = 0;
+
+  if (pinned) {
+    start_executor(max_number_of_threads);
+  }
+
+  for (size_t i = 0; i < _slots; ++i) {
+    if (_chunks[i].input_buffer.size() >= _buffer_size) {
+      continue;
+    }
+
+    if (!pinned) {
+      allocate(i);
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++allocating;
+    }
+
+    _executor->submit(
+        [this, i, &allocating] {
+          allocate(i);
+
+          std::lock_guard<std::mutex> lock(_mutex);
+          --allocating;
+          _condition.notify_all();
+        },
+        home(i));
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [&] { return allocating == 0; });
+  }
+
+  _parallel = false;
+  _read = 0;
+  _placed = 0;
+  _written = 0;
+  _next_second_stage = 0;
+  _writing = false;
+  _failed = false;
+  _error = DECODE_OK;
+  _failed_chunk = 0;
+
+  if (_deduplicate) {
+    _index.clear();
+    _history.reset(_slots);
+  }
+
+  // The dictionary of the next chunk to read, or of the next chunk to write
+  std::vector<T> input_dictionary;
+  _output_dictionary.assign(_preset_dictionary.begin(),
+                            _preset_dictionary.end());
+
+  if (F::primed_from_input) {
+    input_dictionary.swap(_output_dictionary);
+  }
+
+  // The symbols read past the last content-defined boundary, which begin the
+  // next chunk
+  std::vector<T> carried;
+  GearChunker chunker = GearChunker::for_chunk_size(chunk_size);
+
+  while (begin != end || !carried.empty()) {
+    size_t sequence = _read;
+    Chunk& current = chunk(sequence);
+
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock,
+                      [&] { return _written + _slots > sequence || _failed; });
+
+      if (_failed) {
+        break;
+      }
+    }
+
+    T* input_buffer = current.input_buffer.data();
+    size_t dictionary_size = input_dictionary.size();
+    std::copy(input_dictionary.begin(), input_dictionary.end(), input_buffer);
+
+    T* chunk_buffer = input_buffer + dictionary_size;
+    size_t carried_size = carried.size();
+    std::copy(carried.begin(), carried.end(), chunk_buffer);
+
     size_t current_chunk_size =
-        W1::prepare_input_buffer(begin, end, input_buffer, chunk_size);
+        carried_size + F::template prepare_input_buffer<W1>(
+                           begin,
+                           end,
+                           chunk_buffer + carried_size,
+                           chunk_size - carried_size,
+                           _buffer_size - dictionary_size - carried_size);
+
+    carried.clear();
+
+    if (_content_defined) {
+      size_t cut = chunker.cut(chunk_buffer, current_chunk_size);
+      carried.assign(chunk_buffer + cut, chunk_buffer + current_chunk_size);
+      current_chunk_size = cut;
+    }
+
+    if (F::primed_from_input && _dictionary_size) {
+      size_t size = dictionary_size + current_chunk_size;
+      size_t kept = std::min(size, _dictionary_size);
+      input_dictionary.assign(input_buffer + size - kept, input_buffer + size);
+    }
+
+    current.dictionary_size = dictionary_size;
+    current.size = current_chunk_size;
+    current.first_stage_done = false;
+    current.done = false;
+    current.written = false;
+
+    // A sequence of a single chunk is not worth waking the threads up
+    if (sequence == 0 && max_number_of_threads > 1 &&
+        (begin != end || !carried.empty())) {
+      start_executor(max_number_of_threads);
+      _parallel = true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_read;
+    }
+
+    submit_first_stage(sequence, &sink);
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [&] { return _written == _read; });
+
+  return !_failed;
+}
+
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::submit_first_stage(size_t sequence, Sink* sink) {
+  if (!_parallel) {
+    first_stage(sequence, sink);
+    return;
+  }
 
-    counter.wait([&] { return counter.value() < max_number_of_threads; });
+  auto task = [this, sequence, sink] { first_stage(sequence, sink); };
 
-    counter.increase();
+  if (_threads_per_node) {
+    _executor->submit(task, home(sequence % _slots));
+  } else {
+    _executor->submit(task);
+  }
+}
+
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::submit_second_stage(size_t sequence, Sink* sink) {
+  if (!_parallel) {
+    second_stage(sequence, sink);
+    return;
+  }
+
+  _executor->submit([this, sequence, sink] { second_stage(sequence, sink); });
+}
 
-    thread_ptr new_thread =
-        new std::thread(pipeline<OutputIterator, counter_type>,
-                        input_buffer,
-                        current_chunk_size,
-                        output_iterator,
-                        previous_thread,
-                        &counter,
-                        &buffer_pool);
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::first_stage(size_t sequence, Sink* sink) {
+  Chunk& current = chunk(sequence);
+
+  // Every chunk is processed as if by new Workers
+  current.first.reset();
+  current.second.reset();
+
+  sum(current);
+
+  bool referred = refer(
+      sequence,
+      current,
+      std::integral_constant<bool, F::references == REFERENCES_WRITTEN>());
+
+  bool checksummed = remove_checksum(
+      current,
+      std::integral_constant<bool, F::checksums == CHECKSUMS_READ>());
+
+  if (!checksummed) {
+    current.frame = Frame<T>();
+    current.frame.reject(DECODE_INVALID_FRAME);
+  } else if (!referred) {
+    current.frame = F::first_stage(current.first,
+                                   current.input_buffer.data(),
+                                   current.dictionary_size,
+                                   current.size,
+                                   current.intermediate_buffer.data(),
+                                   _buffer_size);
+  }
 
-    previous_thread = new_thread;
+  bool ready;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    current.first_stage_done = true;
+    ready = !chained() || _next_second_stage == sequence;
   }
 
-  if (previous_thread) {
-    previous_thread->join();
-    delete previous_thread;
+  if (ready) {
+    submit_second_stage(sequence, sink);
   }
 }
 
-template <typename W1, typename W2, typename T>
-template <typename OutputIterator, typename Counter>
-void Splitter<W1, W2, T>::pipeline(T* input_buffer,
-                                   size_t chunk_size,
-                                   OutputIterator output_iterator,
-                                   std::thread* previous_thread,
-                                   Counter* counter,
-                                   BufferPool<T>* buffer_pool) {
-  PushBackBuffer<T> buffer(input_buffer, chunk_size);
-  PushBackBuffer<T> intermediate_buffer(buffer_pool->get());
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::second_stage(size_t sequence, Sink* sink) {
+  Chunk& current = chunk(sequence);
+  ChunkLink<T> link(&_output_dictionary, chained() ? _dictionary_size : 0);
 
-  W1 first;
-  first(buffer.begin(), buffer.end(), std::back_inserter(intermediate_buffer));
+  // Chained chunks complete their second stages in order, the others as they
+  // are written
+  if (chained()) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    resolve(sequence, current.frame);
+  }
+
+  F::second_stage(current.second,
+                  current.frame,
+                  current.input_buffer.data(),
+                  current.intermediate_buffer.data(),
+                  _buffer_size,
+                  link);
+
+  append_checksum(
+      current,
+      std::integral_constant<bool, F::checksums == CHECKSUMS_WRITTEN>());
 
-  buffer.clear();
+  // References not resolved yet are checked once they are
+  if (!current.frame.reference) {
+    verify(current);
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
 
-  W2 second;
-  second(intermediate_buffer.begin(),
-         intermediate_buffer.end(),
-         std::back_inserter(buffer));
+  if (chained()) {
+    remember(current.frame);
+    _next_second_stage = sequence + 1;
 
-  if (previous_thread) {
-    previous_thread->join();
-    delete previous_thread;
+    // This chunk is not done yet, so the sequence cannot end meanwhile
+    if (sequence + 1 < _read && chunk(sequence + 1).first_stage_done) {
+      lock.unlock();
+      submit_second_stage(sequence + 1, sink);
+      lock.lock();
+    }
   }
 
-  std::copy(buffer.begin(), buffer.end(), output_iterator);
+  current.done = true;
+
+  // Once the last chunk is written, split() may return: releasing the lock
+  // must be the last use of the Splitter by a task
+  write(lock, sink);
+}
+
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::write(std::unique_lock<std::mutex>& lock,
+                                   Sink* sink,
+                                   std::false_type) {
+  // Another task is already writing, and will write this chunk if it is next
+  if (_writing) {
+    return;
+  }
+
+  _writing = true;
+
+  while (_written < _read && chunk(_written).done) {
+    Chunk& current = chunk(_written);
+    Frame<T>& frame = current.frame;
 
-  buffer_pool->release(buffer.begin());
-  buffer_pool->release(intermediate_buffer.begin());
+    if (!chained() && frame.reference) {
+      resolve(_written, frame);
+      verify(current);
+    }
 
-  counter->decrease();
-  counter->notify();
+    if (!chained()) {
+      remember(frame);
+    }
+
+    if (!frame.valid) {
+      fail(_written, frame);
+    }
+
+    if (!_failed) {
+      lock.unlock();
+      sink->write(frame.header, frame.header_size);
+      sink->write(frame.data, frame.size);
+      sink->write(frame.trailer, frame.trailer_size);
+      lock.lock();
+    }
+
+    ++_written;
+    _condition.notify_all();
+  }
+
+  _writing = false;
+}
+
+template <typename W1, typename W2, typename T, typename F>
+template <typename Sink>
+void Splitter<W1, W2, T, F>::write(std::unique_lock<std::mutex>& lock,
+                                   Sink* sink,
+                                   std::true_type) {
+  // Place the chunks done since the last one placed: this task writes them,
+  // while other tasks write the chunks they place next
+  size_t first = _placed;
+
+  for (; _placed < _read && chunk(_placed).done; ++_placed) {
+    Chunk& current = chunk(_placed);
+
+    if (!chained() && current.frame.reference) {
+      resolve(_placed, current.frame);
+      verify(current);
+    }
+
+    if (!chained()) {
+      remember(current.frame);
+    }
+
+    if (!current.frame.valid) {
+      fail(_placed, current.frame);
+    }
+
+    // The chunks from a failed one on are not placed, and count as written
+    current.written = _failed;
+
+    if (!_failed) {
+      current.offset = sink->place(current.frame.total_size());
+    }
+  }
+
+  if (first == _placed) {
+    return;
+  }
+
+  size_t last = _placed;
+  lock.unlock();
+
+  for (size_t sequence = first; sequence < last; ++sequence) {
+    Chunk& current = chunk(sequence);
+
+    if (!current.written) {
+      const Frame<T>& frame = current.frame;
+      size_t offset = current.offset;
+
+      sink->write_at(offset, frame.header, frame.header_size);
+      offset += frame.header_size;
+      sink->write_at(offset, frame.data, frame.size);
+      offset += frame.size;
+      sink->write_at(offset, frame.trailer, frame.trailer_size);
+    }
+  }
+
+  lock.lock();
+
+  for (size_t sequence = first; sequence < last; ++sequence) {
+    chunk(sequence).written = true;
+  }
+
+  // Slots are reused in order, once every chunk before them is written
+  while (_written < _placed && chunk(_written).written) {
+    ++_written;
+  }
+
+  _condition.notify_all();
+}
+
+template <typename W1, typename W2, typename T, typename F>
+bool Splitter<W1, W2, T, F>::refer(size_t sequence,
+                                   Chunk& current,
+                                   std::true_type) {
+  if (!_deduplicate) {
+    return false;
+  }
+
+  Hash128 hash =
+      murmur3_128(current.input_buffer.data() + current.dictionary_size,
+                  current.size * sizeof(T));
+  size_t distance;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    distance = _index.find(hash, sequence);
+  }
+
+  if (!distance) {
+    return false;
+  }
+
+  current.frame = F::reference(distance, current.intermediate_buffer.data());
+  return true;
+}
+
+template <typename W1, typename W2, typename T, typename F>
+void Splitter<W1, W2, T, F>::resolve(size_t sequence, Frame<T>& frame) {
+  if (F::references != REFERENCES_READ || !frame.reference) {
+    return;
+  }
+
+  const std::vector<T>* repeated =
+      _deduplicate ? _history.find(sequence, frame.reference) : nullptr;
+
+  if (!repeated) {
+    frame.reject(DECODE_INVALID_FRAME);
+    return;
+  }
+
+  frame.data = repeated->data();
+  frame.size = repeated->size();
+  frame.reference = 0;
+}
+
+template <typename W1, typename W2, typename T, typename F>
+void Splitter<W1, W2, T, F>::remember(const Frame<T>& frame) {
+  if (F::references == REFERENCES_READ && _deduplicate && frame.valid) {
+    _history.remember(frame.data, frame.size);
+  }
 }
 
 #endif /* SPLITTER_H */
@@ -0,0 +1,66 @@
+#ifndef STREAMS_H
+#define STREAMS_H
+
+#include <iterator>
+#include <algorithm>
+#include "bit_reader.h"
+#include "bit_writer.h"
+
+/**
+ * Write a sequence of symbols prefixed by its length, so that it can be
+ * concatenated with other sequences and read back with read_stream().
+ *
+ * @param begin a forward iterator referring to the beginning of the sequence
+ * @param end   a forward iterator referring to past-the-end of the sequence
+ * @param output_iterator an output iterator for writing the sequence
+ */
+template <typename ForwardIterator, typename OutputIterator>
+void write_stream(ForwardIterator begin,
+                  ForwardIterator end,
+                  OutputIterator output_iterator) {
+  size_t size = std::distance(begin, end);
+
+  BitWriter<OutputIterator> bit_writer(output_iterator);
+  bit_writer.write(size);
+
+  for (; begin != end; ++begin) {
+    bit_writer.write(*begin);
+  }
+}
+
+/**
+ * Read a sequence of symbols written by write_stream().
+ *
+ * @param begin an input iterator referring to the beginning of the length
+ *              prefix
+ * @param end   an input iterator referring to past-the-end of the input
+ * @param[out] stream a container the sequence is stored into
+ * @param[out] complete set to whether or not the input holds the whole
+ *                      sequence, if not null
+ * @return an input iterator referring to past-the-end of the sequence
+ */
+template <typename InputIterator, typename Container>
+InputIterator read_stream(InputIterator begin,
+                          InputIterator end,
+                          Container& stream,
+                          bool* complete = nullptr) {
+  BitReader<InputIterator> bit_reader(begin, end);
+
+  size_t size;
+  bit_reader.read(size);
+
+  begin = bit_reader.next();
+  stream.clear();
+
+  for (; size && begin != end; --size, ++begin) {
+    stream.push_back(*begin);
+  }
+
+  if (complete) {
+    *complete = !bit_reader.overrun() && size == 0;
+  }
+
+  return begin;
+}
+
+#endif /* STREAMS_H */
@@ -0,0 +1,162 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * The NUMA nodes of the machine and the CPUs of each, as Linux reports them in
+ * /sys/devices/system/node; elsewhere, a single node with every CPU.
+ *
+ * Threads spread over the nodes with a given number of threads per node are
+ * pinned to the CPUs of their node, so that the memory they touch first is
+ * allocated there and they do not migrate away from it.
+ */
+class Topology {
+ public:
+  /**
+   * @return the topology of the machine, read once
+   */
+  static const Topology& get() {
+    static const Topology topology;
+    return topology;
+  }
+
+  /**
+   * @return the number of nodes
+   */
+  size_t nodes() const { return _cpus.size(); }
+
+  /**
+   * @param node a node
+   * @return the CPUs of the node
+   */
+  const std::vector<int>& cpus(size_t node) const { return _cpus[node]; }
+
+  /**
+   * The node of a thread, threads filling each node in turn.
+   *
+   * @param thread           the index of the thread
+   * @param threads_per_node the number of threads per node
+   * @return the node of the thread
+   */
+  size_t node(size_t thread, size_t threads_per_node) const {
+    return thread / threads_per_node % nodes();
+  }
+
+  /**
+   * Pin the calling thread to the CPUs of a node.
+   *
+   * @param node the node
+   * @return false if the thread could not be pinned
+   */
+  bool pin(size_t node) const;
+
+  /**
+   * Parse a list of CPUs as written by Linux, e.g. "0-3,8,10-11".
+   *
+   * @param list the list
+   * @return the CPUs of the list, empty if it is malformed
+   */
+  static std::vector<int> parse_cpu_list(const std::string& list);
+
+ private:
+  std::vector<std::vector<int>> _cpus;
+
+  Topology();
+};
+
+inline Topology::Topology() {
+#ifdef __linux__
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+
+  if (std::getline(online, nodes)) {
+    for (int node : parse_cpu_list(nodes)) {
+      std::ifstream file("/sys/devices/system/node/node" +
+                         std::to_string(node) + "/cpulist");
+      std::string list;
+      std::vector<int> cpus;
+
+      if (std::getline(file, list)) {
+        cpus = parse_cpu_list(list);
+      }
+
+      // Nodes without CPUs only have memory
+      if (!cpus.empty()) {
+        _cpus.push_back(cpus);
+      }
+    }
+  }
+#endif
+
+  if (_cpus.empty()) {
+    std::vector<int> cpus;
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+      cpus.push_back(cpu);
+    }
+
+    _cpus.push_back(cpus);
+  }
+}
+
+inline bool Topology::pin(size_t node) const {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  for (int cpu : _cpus[node]) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+inline std::vector<int> Topology::parse_cpu_list(const std::string& list) {
+  std::vector<int> cpus;
+  const char* position = list.c_str();
+
+  while (*position && *position != '\n') {
+    char* next;
+    long first = std::strtol(position, &next, 10);
+    long last = first;
+
+    if (next == position || first < 0) {
+      return std::vector<int>();
+    }
+
+    if (*next == '-') {
+      position = next + 1;
+      last = std::strtol(position, &next, 10);
+
+      if (next == position || last < first) {
+        return std::vector<int>();
+      }
+    }
+
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+
+    position = *next == ',' ? next + 1 : next;
+  }
+
+  return cpus;
+}
+
+#endif /* TOPOLOGY_H */
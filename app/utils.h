@@ -13,6 +13,73 @@ typedef uint_fast8_t bits_t;
 
 inline constexpr size_t max_size(size_t bits) { return (1 << bits) - 1; }
 
+/**
+ * The bound of a Worker whose output size cannot be computed in advance (e.g.
+ * a decoder fed with untrusted data).
+ */
+static constexpr size_t UNKNOWN_BOUND = std::numeric_limits<size_t>::max();
+
+/**
+ * The size returned by a Worker whose output does not fit in the available
+ * memory.
+ */
+static constexpr size_t OUTPUT_OVERFLOW = std::numeric_limits<size_t>::max();
+
+/**
+ * Why a decoder rejected its input. Decoders check what they read against
+ * limits computed once per sequence, and stop at the first inconsistency
+ * rather than reading or writing out of bounds.
+ */
+enum DecodeError {
+  DECODE_OK = 0,
+  // The input ends before the symbols or tokens it announces
+  DECODE_TRUNCATED,
+  // The input goes on after the symbols or tokens it announces
+  DECODE_TRAILING_DATA,
+  // A Huffman table or code that no encoder writes
+  DECODE_INVALID_CODE,
+  // A match that refers to symbols before the beginning of the dictionary
+  DECODE_INVALID_MATCH,
+  // A frame of an unknown type or size, or referring to no earlier chunk
+  DECODE_INVALID_FRAME,
+  // A decoded chunk that does not match its checksum
+  DECODE_CHECKSUM_MISMATCH,
+  // A decoded sequence that does not fit in the memory given to it
+  DECODE_OUTPUT_OVERFLOW,
+  // A container written by an unsupported version, or with another preset
+  // dictionary
+  DECODE_UNSUPPORTED
+};
+
+/**
+ * @param error why a decoder rejected its input
+ * @return a description of the error, for messages
+ */
+inline const char* describe(DecodeError error) {
+  switch (error) {
+    case DECODE_OK:
+      return "no error";
+    case DECODE_TRUNCATED:
+      return "truncated input";
+    case DECODE_TRAILING_DATA:
+      return "unexpected data after the end of a sequence";
+    case DECODE_INVALID_CODE:
+      return "invalid Huffman table or code";
+    case DECODE_INVALID_MATCH:
+      return "match out of the dictionary";
+    case DECODE_INVALID_FRAME:
+      return "invalid frame";
+    case DECODE_CHECKSUM_MISMATCH:
+      return "checksum mismatch";
+    case DECODE_OUTPUT_OVERFLOW:
+      return "output too large";
+    case DECODE_UNSUPPORTED:
+      return "unsupported version or another preset dictionary";
+  }
+
+  return "unknown error";
+}
+
 template <size_t value, typename IntegerType>
 constexpr bool fits_in() {
   return value <= std::numeric_limits<IntegerType>::max();
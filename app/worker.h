@@ -2,39 +2,141 @@
 #define WORKER_H
 
 #include <cstddef>
+#include <iterator>
+#include "buffers.h"
+#include "sources.h"
+#include "span.h"
+
+/**
+ * A base class that provides the span-based interface of a Worker on top of
+ * its @c operator()(InputIterator, InputIterator, OutputIterator).
+ *
+ * The output is written directly to the memory referred by the output Span.
+ * When the Worker's @c bound() guarantees that the output fits no check is
+ * performed while writing; otherwise every write is bounds-checked.
+ *
+ * @tparam Derived the type of the Worker
+ * @tparam T       the type of the symbols
+ */
+template <typename Derived, typename T = char>
+struct SpanWorker {
+  /**
+   * Process a sequence of symbols.
+   *
+   * @param[in]  input  the sequence to process
+   * @param[out] output the memory where the result is written
+   * @return the number of symbols written to @c output, or OUTPUT_OVERFLOW if
+   *         they did not fit
+   */
+  size_t process(Span<const T> input, Span<T> output) {
+    return run(output, input.size(), input.begin(), input.end());
+  }
+
+  /**
+   * Process a sequence of symbols, starting from a dictionary made of the
+   * (plain) symbols that precede it, through the Worker's
+   * @c operator()(Span<const T>, InputIterator, InputIterator, OutputIterator).
+   *
+   * @param[in]  dictionary the symbols that precede @c input
+   * @param[in]  input      the sequence to process
+   * @param[out] output     the memory where the result is written
+   * @return the number of symbols written to @c output, or OUTPUT_OVERFLOW if
+   *         they did not fit
+   */
+  size_t process(Span<const T> dictionary,
+                 Span<const T> input,
+                 Span<T> output) {
+    return run(output, input.size(), dictionary, input.begin(), input.end());
+  }
+
+  /**
+   * @param input_size the size of an input sequence
+   * @return the maximum size of the output, or UNKNOWN_BOUND
+   */
+  static size_t bound(size_t) { return UNKNOWN_BOUND; }
+
+  /**
+   * Forget the state carried over from the previous sequences (e.g. the
+   * Huffman table they share), keeping the allocated memory, so that the
+   * next sequence is processed as if by a new instance.
+   */
+  void reset() {}
+
+  /**
+   * @return why the last sequence could not be processed, DECODE_OK if it
+   *         was or if the Worker never rejects its input
+   */
+  DecodeError error() const { return DECODE_OK; }
+
+ private:
+  // Call the Worker with the given arguments followed by an output iterator
+  template <typename... Args>
+  size_t run(Span<T> output, size_t input_size, Args... args) {
+    Derived& worker = static_cast<Derived&>(*this);
+
+    if (Derived::bound(input_size) <= output.size()) {
+      PushBackBuffer<T> buffer(output.data());
+      worker(args..., std::back_inserter(buffer));
+      return buffer.size();
+    }
+
+    BoundedPushBackBuffer<T> buffer(output.data(), output.size());
+    worker(args..., std::back_inserter(buffer));
+    return buffer.overflow() ? OUTPUT_OVERFLOW : buffer.size();
+  }
+};
 
 /**
  * A concept for a functor that has a default constructor, an
- * @c operator()(InputIterator, InputIterator, OutputIterator) and a
+ * @c operator()(InputIterator, InputIterator, OutputIterator), a
+ * @c process(Span<const T>, Span<T>), a @c bound(size_t) and a
  * @c prepare_input_buffer(InputIterator&, InputIterator, PtrType, size_t)
  * member functions.
  *
+ * The wrapped encoder/decoder is kept between sequences, so that the memory
+ * it allocates is reused: each call must not depend on the previous ones.
+ *
  * @tpara T the type of the wrapped encoder/decoder
  */
 template <typename T>
-struct Worker {
+struct Worker : SpanWorker<Worker<T>> {
+  static size_t bound(size_t input_size) { return T::bound(input_size); }
+
   template <typename InputIterator, typename OutputIterator>
   void operator()(InputIterator begin,
                   InputIterator end,
                   OutputIterator output_iterator) {
-    T worker;
-    worker(begin, end, output_iterator);
+    _worker(begin, end, output_iterator);
+  }
+
+  template <typename InputIterator, typename OutputIterator>
+  void operator()(Span<const char> dictionary,
+                  InputIterator begin,
+                  InputIterator end,
+                  OutputIterator output_iterator) {
+    _worker(dictionary, begin, end, output_iterator);
   }
 
+  DecodeError error() const { return wrapped_error(_worker, 0); }
+
   template <typename InputIterator, typename PtrType>
   static size_t prepare_input_buffer(InputIterator& begin,
                                      InputIterator end,
                                      PtrType input_buffer,
                                      size_t chunk_size) {
-    size_t current_chunk_size = 0;
+    return read_block(begin, end, input_buffer, chunk_size);
+  }
 
-    for (; current_chunk_size < chunk_size && begin != end;
-         ++current_chunk_size, ++begin) {
-      input_buffer[current_chunk_size] = *begin;
-    }
+ private:
+  T _worker;
 
-    return current_chunk_size;
+  // The error of the wrapped decoder, if it reports one
+  template <typename U>
+  static auto wrapped_error(const U& worker, int) -> decltype(worker.error()) {
+    return worker.error();
   }
+
+  static DecodeError wrapped_error(const T&, long) { return DECODE_OK; }
 };
 
 #endif /* WORKER_H */
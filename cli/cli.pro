@@ -7,5 +7,7 @@ SUBDIRS += \
     huffman-decoder \
     parallel-encoder \
     parallel-decoder \
+    parallel-archiver \
     lzss-encoder \
-    lzss-decoder
+    lzss-decoder \
+    dictionary-trainer
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <ios>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "preset_dictionary.h"
+#include "utils.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0]
+         << " dictionary_file sample_file... [--size bytes]\n";
+    return 1;
+  }
+
+  // The LZSS window of the parallel encoder
+  size_t size = max_size(12);
+  if (argc > 4 && string(argv[argc - 2]) == "--size") {
+    size = atoi(argv[argc - 1]);
+    argc -= 2;
+  }
+
+  vector<PresetDictionary<>::sample_type> samples;
+  for (int i = 2; i < argc; ++i) {
+    ifstream sample_file(argv[i], ios::binary);
+    samples.emplace_back(istreambuf_iterator<char>(sample_file),
+                         istreambuf_iterator<char>());
+  }
+
+  auto dictionary = PresetDictionary<>::train(samples, size);
+
+  if (!dictionary.save(argv[1])) {
+    cerr << "Could not write " << argv[1] << "\n";
+    return 1;
+  }
+
+  cout << dictionary.content().size() << " bytes, id " << dictionary.id()
+       << "\n";
+
+  return 0;
+}
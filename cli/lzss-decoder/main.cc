@@ -1,14 +1,16 @@
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <ios>
 #include "lzss_decoder.h"
+#include "lzss_grouped_decoder.h"
 #include "decoder_wrapper.h"
 
 using namespace std;
 
 int main(int argc, char** argv) {
   if (argc < 3) {
-    cerr << "Usage: " << argv[0] << " input_file output_file\n";
+    cerr << "Usage: " << argv[0] << " input_file output_file [--grouped]\n";
     return 1;
   }
 
@@ -17,8 +19,13 @@ int main(int argc, char** argv) {
 
   input_file >> noskipws;
 
-  DecoderWrapper<LZSSDecoder<12, 4>> decoder;
-  decoder(input_file, output_file);
+  if (argc > 3 && strcmp(argv[3], "--grouped") == 0) {
+    DecoderWrapper<LZSSGroupedDecoder<12, 4>> decoder;
+    decoder(input_file, output_file);
+  } else {
+    DecoderWrapper<LZSSDecoder<12, 4>> decoder;
+    decoder(input_file, output_file);
+  }
 
   return 0;
 }
@@ -1,33 +1,54 @@
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <ios>
 #include <iterator>
 #include "lzss_encoder.h"
+#include "lzss_grouped_encoder.h"
 #include "encoder_wrapper.h"
 
 using namespace std;
 
+template <typename Encoder>
+static void encode(ifstream& input_file, ofstream& output_file) {
+  EncoderWrapper<Encoder> encoder;
+  encoder(std::istreambuf_iterator<char>(input_file.rdbuf()),
+          std::istreambuf_iterator<char>(),
+          std::ostreambuf_iterator<char>(output_file));
+}
+
 int main(int argc, char** argv) {
   if (argc < 3) {
-    cerr << "Usage: " << argv[0] << " input_file output_file [--naive]\n";
+    cerr << "Usage: " << argv[0]
+         << " input_file output_file [--naive] [--grouped]\n";
     return 1;
   }
 
+  bool naive = false;
+  bool grouped = false;
+  for (int i = 3; i < argc; ++i) {
+    if (strcmp(argv[i], "--grouped") == 0) {
+      grouped = true;
+    } else {
+      naive = true;
+    }
+  }
+
   ifstream input_file(argv[1], ios::binary);
   ofstream output_file(argv[2], ios::binary | ios::trunc);
 
   input_file >> noskipws;
 
-  if (argc != 4) {
-    EncoderWrapper<LZSSEncoder<12, 4>> encoder;
-    encoder(std::istreambuf_iterator<char>(input_file.rdbuf()),
-            std::istreambuf_iterator<char>(),
-            std::ostreambuf_iterator<char>(output_file));
+  if (grouped) {
+    if (naive) {
+      encode<NaiveLZSSGroupedEncoder<12, 4>>(input_file, output_file);
+    } else {
+      encode<LZSSGroupedEncoder<12, 4>>(input_file, output_file);
+    }
+  } else if (naive) {
+    encode<NaiveLZSSEncoder<12, 4>>(input_file, output_file);
   } else {
-    EncoderWrapper<NaiveLZSSEncoder<12, 4>> encoder;
-    encoder(std::istreambuf_iterator<char>(input_file.rdbuf()),
-            std::istreambuf_iterator<char>(),
-            std::ostreambuf_iterator<char>(output_file));
+    encode<LZSSEncoder<12, 4>>(input_file, output_file);
   }
 
   return 0;
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "archive.h"
+#include "parallel.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+  if (argc < 3 || strlen(argv[1]) != 1 || !strchr("ctvx", argv[1][0])) {
+    cerr << "Usage: " << argv[0]
+         << " c archive_file input... [--threads n] [--naive] [--streams]"
+            " [--grouped] [--chunk-size n] [--dedup] [--stats]"
+            " [--dictionary dictionary_file]\n"
+         << "       " << argv[0] << " t archive_file\n"
+         << "       " << argv[0]
+         << " v archive_file [--threads n] [--dictionary dictionary_file]\n"
+         << "       " << argv[0]
+         << " x archive_file [destination [member...]] [--threads n]"
+            " [--dictionary dictionary_file]\n";
+    return 1;
+  }
+
+  size_t threads = 0;
+  bool boyer_moore = true;
+  bool token_streams = false;
+  bool grouped_flags = false;
+  size_t chunk_size = 0;
+  bool deduplicate = false;
+  bool print_stats = false;
+  PresetDictionary<> dictionary;
+  vector<string> paths;
+  for (int i = 3; i < argc; ++i) {
+    if (strcmp(argv[i], "--naive") == 0) {
+      boyer_moore = false;
+    } else if (strcmp(argv[i], "--streams") == 0) {
+      token_streams = true;
+    } else if (strcmp(argv[i], "--grouped") == 0) {
+      grouped_flags = true;
+    } else if (strcmp(argv[i], "--dedup") == 0) {
+      deduplicate = true;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      print_stats = true;
+    } else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) {
+      threads = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--chunk-size") == 0) {
+      chunk_size = strtoul(argv[++i], nullptr, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--dictionary") == 0) {
+      dictionary = PresetDictionary<>::load(argv[++i]);
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  if (argv[1][0] == 'c') {
+    if (paths.empty()) {
+      cerr << "Nothing to archive\n";
+      return 1;
+    }
+
+    EncodingStats stats = archive_in_parallel(paths,
+                                              argv[2],
+                                              threads,
+                                              boyer_moore,
+                                              token_streams,
+                                              dictionary,
+                                              chunk_size,
+                                              deduplicate,
+                                              grouped_flags);
+
+    if (print_stats) {
+      cerr << stats.input_size << " -> " << stats.output_size << " bytes in "
+           << stats.chunks << " chunks of " << stats.chunk_size << " bytes\n";
+    }
+
+    if (stats.unreadable) {
+      cerr << stats.unreadable << " files or directories could not be read\n";
+      return 2;
+    }
+
+    return 0;
+  }
+
+  if (argv[1][0] == 't') {
+    ArchiveDirectory directory;
+    if (!list_archive(argv[2], directory)) {
+      cerr << "Not an archive, or a corrupted one\n";
+      return 1;
+    }
+
+    for (const ArchiveMember& member : directory.members) {
+      cout << oct << (member.mode & 07777) << dec << '\t' << member.size
+           << '\t' << member.path << (member.directory() ? "/" : "") << '\n';
+    }
+
+    return 0;
+  }
+
+  if (argv[1][0] == 'v') {
+    ArchiveDirectory directory;
+    if (!list_archive(argv[2], directory) ||
+        !verify_in_parallel(argv[2], threads, dictionary)) {
+      cerr << "Not an archive, a corrupted one, or one written with another "
+              "dictionary\n";
+      return 1;
+    }
+
+    return 0;
+  }
+
+  // The members to extract follow the destination, every member if none
+  string destination = paths.empty() ? "." : paths.front();
+  vector<string> names(paths.begin() + (paths.empty() ? 0 : 1), paths.end());
+
+  ArchiveDirectory directory;
+  vector<string> missing;
+  if (list_archive(argv[2], directory)) {
+    directory.select(names, &missing);
+  }
+
+  for (const string& name : missing) {
+    cerr << name << ": not in the archive\n";
+  }
+
+  if (!extract_archive(
+          argv[2], destination.c_str(), threads, dictionary, names)) {
+    cerr << "Could not extract every member\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -1,15 +1,87 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include "parallel.h"
 
 using namespace std;
 
 int main(int argc, char** argv) {
-  if (argc < 3) {
-    cerr << "Usage: " << argv[0] << " input_file output_file\n";
+  // Files are verified without an output file
+  bool verify = argc > 1 && strcmp(argv[1], "--verify") == 0;
+  int paths = verify ? 1 : 2;
+
+  if (argc < paths + 1 + verify) {
+    cerr << "Usage: " << argv[0]
+         << " input_file output_file [threads] [--pwrite]"
+            " [--threads-per-node n] [--dictionary dictionary_file]\n"
+         << "       " << argv[0]
+         << " input_file output_file --incremental"
+            " [--dictionary dictionary_file]\n"
+         << "       " << argv[0]
+         << " --verify input_file [threads] [--dictionary dictionary_file]\n";
     return 1;
   }
 
-  decode_in_parallel(argv[1], argv[2], 4);
+  if (verify) {
+    ++argv;
+    --argc;
+  }
+
+  bool positioned_writes = false;
+  bool incremental = false;
+  size_t threads_per_node = 0;
+  PresetDictionary<> dictionary;
+  for (; argc > paths + 1; --argc) {
+    if (strcmp(argv[argc - 1], "--pwrite") == 0) {
+      positioned_writes = true;
+    } else if (strcmp(argv[argc - 1], "--incremental") == 0) {
+      incremental = true;
+    } else if (argc > paths + 2 &&
+               strcmp(argv[argc - 2], "--threads-per-node") == 0) {
+      threads_per_node = atoi(argv[argc - 1]);
+      --argc;
+    } else if (argc > paths + 2 &&
+               strcmp(argv[argc - 2], "--dictionary") == 0) {
+      dictionary = PresetDictionary<>::load(argv[argc - 1]);
+      --argc;
+    } else {
+      break;
+    }
+  }
+
+  // One thread per hardware thread by default
+  int threads = argc > paths + 1 ? atoi(argv[paths + 1]) : 0;
+
+  DecodeError error = DECODE_OK;
+
+  if (verify) {
+    if (!verify_in_parallel(argv[1], threads, dictionary, &error)) {
+      cerr << argv[1] << ": " << describe(error) << '\n';
+      return 1;
+    }
+
+    return 0;
+  }
+
+  // In constant memory, on this thread only
+  bool decoded = incremental ? decode_incrementally(
+                                   argv[1], argv[2], dictionary, &error)
+                             : decode_in_parallel(argv[1],
+                                                  argv[2],
+                                                  threads,
+                                                  dictionary,
+                                                  positioned_writes,
+                                                  threads_per_node,
+                                                  &error);
+
+  if (!decoded) {
+    if (error == DECODE_OK) {
+      cerr << argv[2] << ": could not be written\n";
+    } else {
+      cerr << argv[1] << ": " << describe(error) << '\n';
+    }
+    return 1;
+  }
 
   return 0;
 }
@@ -1,23 +1,90 @@
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include "parallel.h"
 
 using namespace std;
 
 int main(int argc, char** argv) {
   if (argc < 3) {
-    cerr << "Usage: " << argv[0] << " input_file output_file\n";
+    cerr << "Usage: " << argv[0]
+         << " input_file output_file [threads [--naive]] [--streams]"
+            " [--grouped] [--prime] [--pwrite] [--threads-per-node n]"
+            " [--chunk-size n] [--cdc] [--dedup] [--checksum] [--stats]"
+            " [--dictionary dictionary_file]\n";
     return 1;
   }
 
+  bool token_streams = false;
+  bool grouped_flags = false;
+  bool primed = false;
+  bool positioned_writes = false;
+  size_t threads_per_node = 0;
+  size_t chunk_size = 0;
+  bool content_defined = false;
+  bool deduplicate = false;
+  bool checksums = false;
+  bool print_stats = false;
+  PresetDictionary<> dictionary;
+  for (; argc > 3; --argc) {
+    if (strcmp(argv[argc - 1], "--streams") == 0) {
+      token_streams = true;
+    } else if (strcmp(argv[argc - 1], "--grouped") == 0) {
+      grouped_flags = true;
+    } else if (strcmp(argv[argc - 1], "--prime") == 0) {
+      primed = true;
+    } else if (strcmp(argv[argc - 1], "--pwrite") == 0) {
+      positioned_writes = true;
+    } else if (strcmp(argv[argc - 1], "--cdc") == 0) {
+      content_defined = true;
+    } else if (strcmp(argv[argc - 1], "--dedup") == 0) {
+      deduplicate = true;
+    } else if (strcmp(argv[argc - 1], "--checksum") == 0) {
+      checksums = true;
+    } else if (strcmp(argv[argc - 1], "--stats") == 0) {
+      print_stats = true;
+    } else if (argc > 4 &&
+               strcmp(argv[argc - 2], "--threads-per-node") == 0) {
+      threads_per_node = atoi(argv[argc - 1]);
+      --argc;
+    } else if (argc > 4 && strcmp(argv[argc - 2], "--chunk-size") == 0) {
+      chunk_size = strtoul(argv[argc - 1], nullptr, 10);
+      --argc;
+    } else if (argc > 4 && strcmp(argv[argc - 2], "--dictionary") == 0) {
+      dictionary = PresetDictionary<>::load(argv[argc - 1]);
+      --argc;
+    } else {
+      break;
+    }
+  }
+
   int threads;
   if (argc >= 4) {
     threads = atoi(argv[3]);
   } else {
-    threads = 8;
+    threads = 0;
   }
 
-  encode_in_parallel(argv[1], argv[2], threads, argc < 5);
+  EncodingStats stats = encode_in_parallel(argv[1],
+                                           argv[2],
+                                           threads,
+                                           argc < 5,
+                                           token_streams,
+                                           primed,
+                                           dictionary,
+                                           positioned_writes,
+                                           threads_per_node,
+                                           chunk_size,
+                                           content_defined,
+                                           deduplicate,
+                                           checksums,
+                                           grouped_flags);
+
+  if (print_stats) {
+    cerr << stats.input_size << " -> " << stats.output_size << " bytes in "
+         << stats.chunks << " chunks of " << (content_defined ? "at most " : "")
+         << stats.chunk_size << " bytes\n";
+  }
 
   return 0;
 }
@@ -0,0 +1,5 @@
+TARGET = canonical_huffman_tree_fuzzer
+
+SOURCES += canonical_huffman_tree_fuzzer.cc
+
+include(../fuzz.pri)
@@ -0,0 +1,24 @@
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include "canonical_huffman_tree.h"
+#include "huffman_decoder.h"
+
+/**
+ * Read a Huffman table from the input, and decode the symbols after it, as
+ * huffman-decoder did before Huffman headers.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data);
+  std::string decoded;
+
+  CanonicalHuffmanTree<char> tree(begin, begin + size);
+  HuffmanDecoder<char> decoder(tree);
+  decoder(begin, begin + size, std::back_inserter(decoded), true);
+
+  // Symbols wider than a byte are read as (symbol, length) pairs
+  CanonicalHuffmanTree<uint16_t> wide_tree(begin, begin + size);
+
+  return 0;
+}
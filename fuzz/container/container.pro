@@ -0,0 +1,6 @@
+TARGET = container_fuzzer
+
+SOURCES += container_fuzzer.cc \
+    ../../app/parallel.cc
+
+include(../fuzz.pri)
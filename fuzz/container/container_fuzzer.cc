@@ -0,0 +1,24 @@
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "archive.h"
+#include "parallel.h"
+
+/**
+ * Decode the input as a container, and read it as an archive directory.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  static DecompressionContext context(1);
+  std::vector<char> output(1 << 20);
+
+  context.decompress(data, size, output.data(), output.size());
+
+  std::istringstream stream(
+      std::string(reinterpret_cast<const char*>(data), size));
+  ArchiveDirectory directory;
+  directory.read(stream);
+
+  return 0;
+}
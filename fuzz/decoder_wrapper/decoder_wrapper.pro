@@ -0,0 +1,5 @@
+TARGET = decoder_wrapper_fuzzer
+
+SOURCES += decoder_wrapper_fuzzer.cc
+
+include(../fuzz.pri)
@@ -0,0 +1,27 @@
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "decoder_wrapper.h"
+#include "lzss_decoder.h"
+
+/**
+ * Decode the input as LZSS tokens followed by their count, as the chunks of
+ * a container without token streams, alone and primed with the input itself.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data);
+  Span<const char> input(begin, size);
+  std::vector<char> output(1 << 16);
+  Span<char> output_span(output.data(), output.size());
+
+  DecoderWrapper<LZSSDecoder<12, 4>> decoder;
+  decoder.process(input, output_span);
+  decoder.process(input, input, output_span);
+
+  std::string decoded;
+  decoder(begin, begin + size, std::back_inserter(decoded));
+
+  return 0;
+}
@@ -0,0 +1,24 @@
+# libFuzzer targets, built with clang and the address and undefined behavior
+# sanitizers, apart from the rest of the project:
+#
+#   qmake -spec linux-clang fuzz.pro && make
+#   lz77_decoder/lz77_decoder_fuzzer -max_len=65536 -timeout=10 \
+#       lz77_decoder/corpus
+#
+# Each target has a corpus of seeds next to it. Inputs that make a target
+# slow (e.g. quadratic in their size) are reported by -timeout, inputs that
+# make it allocate too much by -rss_limit_mb and -malloc_limit_mb.
+include (../common.pri)
+
+CONFIG -= qt
+CONFIG -= app_bundle
+CONFIG += console
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../app
+
+FUZZ_SANITIZERS = -fsanitize=fuzzer,address,undefined \
+                  -fno-sanitize-recover=undefined
+QMAKE_CXXFLAGS += $$FUZZ_SANITIZERS -fno-omit-frame-pointer -O1
+QMAKE_LFLAGS += $$FUZZ_SANITIZERS
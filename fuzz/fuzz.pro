@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    lz77_decoder \
+    lzss_decoder \
+    huffman_decoder_stack \
+    canonical_huffman_tree \
+    decoder_wrapper \
+    container \
+    incremental_decoder \
+    round_trip
@@ -0,0 +1,5 @@
+TARGET = huffman_decoder_stack_fuzzer
+
+SOURCES += huffman_decoder_stack_fuzzer.cc
+
+include(../fuzz.pri)
@@ -0,0 +1,41 @@
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "huffman_decoder_stack.h"
+#include "huffman_streams_decoder_stack.h"
+#include "lzss_stream_encoder.h"
+
+/**
+ * Decode a sequence with a Worker twice, as the chunks of a container, the
+ * second one reusing the Huffman tables of the first.
+ */
+template <typename Worker>
+static void decode(const char* begin, size_t size) {
+  std::vector<char> output(1 << 16);
+  Worker worker;
+
+  for (int i = 0; i < 2; ++i) {
+    worker.process(Span<const char>(begin, size),
+                   Span<char>(output.data(), output.size()));
+  }
+
+  std::string decoded;
+  worker(begin, begin + size, std::back_inserter(decoded));
+}
+
+/**
+ * Decode the input with compact and raw Huffman tables, as a single sequence
+ * and as LZSS token streams.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data);
+
+  decode<HuffmanDecoderStack<char, CompactHuffmanHeader>>(begin, size);
+  decode<HuffmanDecoderStack<char, RawHuffmanHeader>>(begin, size);
+  decode<HuffmanStreamsDecoderStack<LZSS_STREAMS, char, CompactHuffmanHeader>>(
+      begin, size);
+
+  return 0;
+}
@@ -0,0 +1,5 @@
+TARGET = incremental_decoder_fuzzer
+
+SOURCES += incremental_decoder_fuzzer.cc
+
+include(../fuzz.pri)
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+#include "incremental_decoder.h"
+
+/**
+ * Decode the input as a container fed and pulled in pieces whose sizes come
+ * from the input, so that decoding pauses everywhere in the frames.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  IncrementalDecoder<> decoder(PresetDictionary<>(), 0);
+  char output[256];
+  size_t fed = 0;
+
+  for (size_t step = 0; !decoder.done() && decoder.error() == DECODE_OK;
+       ++step) {
+    size_t piece = 1 + (size ? data[step % size] : 0);
+    if (decoder.pull(output, piece)) {
+      continue;
+    }
+
+    if (fed == size) {
+      decoder.finish();
+    }
+    fed += decoder.feed(data + fed, std::min(piece, size - fed));
+  }
+
+  return 0;
+}
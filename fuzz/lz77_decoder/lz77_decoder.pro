@@ -0,0 +1,5 @@
+TARGET = lz77_decoder_fuzzer
+
+SOURCES += lz77_decoder_fuzzer.cc
+
+include(../fuzz.pri)
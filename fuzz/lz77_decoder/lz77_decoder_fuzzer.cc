@@ -0,0 +1,24 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include "lz77_decoder.h"
+
+/**
+ * Decode the input as LZ77 tokens, as lz77-decoder does.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data);
+  std::string decoded;
+
+  LZ77Decoder<12, 4> decoder;
+  decoder(begin, begin + size, std::back_inserter(decoded));
+
+  // A token of 3 bytes writes a match of up to 15 symbols and a symbol
+  if (decoded.size() > (size / 3) * 16) {
+    abort();
+  }
+
+  return 0;
+}
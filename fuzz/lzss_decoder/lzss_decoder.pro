@@ -0,0 +1,5 @@
+TARGET = lzss_decoder_fuzzer
+
+SOURCES += lzss_decoder_fuzzer.cc
+
+include(../fuzz.pri)
@@ -0,0 +1,36 @@
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include "lzss_decoder.h"
+#include "lzss_grouped_decoder.h"
+#include "lzss_stream_decoder.h"
+
+/**
+ * Decode the input as LZSS tokens, packed as lzss-decoder reads them, split
+ * into streams as the containers with token streams hold them and grouped
+ * behind control bytes as lzss-decoder --grouped reads them.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data);
+
+  std::string decoded;
+  LZSSDecoder<12, 4> decoder;
+  decoder(begin, begin + size, std::back_inserter(decoded));
+
+  std::string stream_decoded;
+  LZSSStreamDecoder<12, 4> stream_decoder;
+  stream_decoder(begin, begin + size, std::back_inserter(stream_decoded));
+
+  // Primed with the input itself, as a chunk with the ones before it
+  stream_decoder(Span<const char>(begin, size),
+                 begin,
+                 begin + size,
+                 std::back_inserter(stream_decoded));
+
+  std::string grouped_decoded;
+  LZSSGroupedDecoder<12, 4> grouped_decoder;
+  grouped_decoder(begin, begin + size, std::back_inserter(grouped_decoded));
+
+  return 0;
+}
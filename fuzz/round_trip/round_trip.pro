@@ -0,0 +1,6 @@
+TARGET = round_trip_fuzzer
+
+SOURCES += round_trip_fuzzer.cc \
+    ../../app/parallel.cc
+
+include(../fuzz.pri)
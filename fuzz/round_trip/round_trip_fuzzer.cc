@@ -0,0 +1,71 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "lz77_encoder.h"
+#include "lz77_decoder.h"
+#include "parallel.h"
+
+/**
+ * Encode the input into LZ77 tokens, as lz77-encoder does, and into a
+ * container, with the options given by its first byte, and decode them back;
+ * the decoded sequences must be the input.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  unsigned char options = data[0];
+  ++data;
+  --size;
+
+  const char* begin = reinterpret_cast<const char*>(data);
+  std::vector<char> tokens;
+  LZ77Encoder<12, 4> encoder;
+  encoder(begin, begin + size, std::back_inserter(tokens));
+
+  std::vector<char> lz77_decoded;
+  LZ77Decoder<12, 4> decoder;
+  decoder(tokens.begin(), tokens.end(), std::back_inserter(lz77_decoded));
+
+  if (lz77_decoded != std::vector<char>(begin, begin + size)) {
+    abort();
+  }
+
+  bool boyer_moore = options & 1;
+  bool token_streams = options & 2;
+  bool primed = options & 4;
+  bool checksums = options & 8;
+  size_t threads = options & 16 ? 2 : 1;
+  bool grouped_flags = options & 32;
+
+  std::vector<char> compressed(compress_bound(size));
+  size_t compressed_size = compress(data,
+                                    size,
+                                    compressed.data(),
+                                    compressed.size(),
+                                    threads,
+                                    boyer_moore,
+                                    token_streams,
+                                    primed,
+                                    PresetDictionary<>(),
+                                    MIN_CHUNK_SIZE,
+                                    checksums,
+                                    grouped_flags);
+
+  std::vector<char> decoded(size);
+  if (compressed_size > compressed.size() ||
+      decompress(compressed.data(),
+                 compressed_size,
+                 decoded.data(),
+                 decoded.size(),
+                 threads) != size ||
+      (size && std::memcmp(decoded.data(), data, size) != 0)) {
+    abort();
+  }
+
+  return 0;
+}
@@ -0,0 +1,17 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = archive_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += archive_test.cc \
+    ../../app/parallel.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
@@ -0,0 +1,346 @@
+#include <QtTest>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "archive.h"
+#include "parallel.h"
+
+class ArchiveTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+  void testCase4();
+  void testCase5();
+};
+
+static void write_file(const std::string& path, const std::string& content) {
+  std::ofstream file(path, std::ios::binary);
+  file << content;
+}
+
+static std::string read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+void ArchiveTest::testCase1() {
+  char root_template[] = "/tmp/archive_test.XXXXXX";
+  std::string root = mkdtemp(root_template);
+  std::string tree = root + "/tree";
+
+  mkdir(tree.c_str(), 0755);
+  mkdir((tree + "/empty").c_str(), 0755);
+  mkdir((tree + "/small").c_str(), 0755);
+  mkdir((tree + "/small/nested").c_str(), 0750);
+
+  // Many small files sharing chunks, a large one spanning many, an empty one
+  std::mt19937 generator(7);
+  std::vector<std::pair<std::string, std::string>> files;
+  for (int i = 0; i < 200; ++i) {
+    std::string content;
+    size_t size = generator() % 3000;
+    while (content.size() < size) {
+      content += "line " + std::to_string(generator() % 100) + "\n";
+    }
+
+    files.push_back(std::make_pair(
+        (i % 2 ? "/small/" : "/small/nested/") + std::to_string(i),
+        content));
+  }
+
+  std::string large;
+  while (large.size() < 300000) {
+    large += "record " + std::to_string(generator() % 5000) + ";";
+  }
+  files.push_back(std::make_pair("/large", large));
+  files.push_back(std::make_pair("/zero", ""));
+
+  for (const auto& file : files) {
+    write_file(tree + file.first, file.second);
+  }
+  chmod((tree + "/zero").c_str(), 0600);
+
+  std::string archive = root + "/tree.sdem";
+  EncodingStats stats = archive_in_parallel(std::vector<std::string>{tree},
+                                            archive.c_str(),
+                                            4,
+                                            true,
+                                            true,
+                                            PresetDictionary<>(),
+                                            20000,
+                                            true);
+
+  QCOMPARE(stats.unreadable, size_t(0));
+  QCOMPARE(stats.chunk_size, size_t(20000));
+  QVERIFY(stats.chunks > 15);
+  QVERIFY(stats.output_size < stats.input_size);
+
+  // Other containers are not archives, and archives are not decoded as them
+  ArchiveDirectory directory;
+  std::string plain = root + "/plain.sdem";
+  encode_in_parallel((tree + "/large").c_str(), plain.c_str(), 2);
+  QVERIFY(!list_archive(plain.c_str(), directory));
+  QVERIFY(!decode_in_parallel(archive.c_str(), (root + "/out").c_str(), 2));
+
+  QVERIFY(list_archive(archive.c_str(), directory));
+  QCOMPARE(directory.chunk_size, uint64_t(20000));
+  QCOMPARE(directory.frames.size(), stats.chunks + 1);
+  QCOMPARE(directory.members.size(), files.size() + 4);
+  QCOMPARE(directory.members.front().path, archive_path(tree));
+
+  // Members are sorted, directories before their entries, with no gaps
+  uint64_t offset = 0;
+  for (size_t i = 0; i < directory.members.size(); ++i) {
+    const ArchiveMember& member = directory.members[i];
+    QCOMPARE(member.offset, offset);
+    offset += member.size;
+    if (i) {
+      QVERIFY(directory.members[i - 1].path < member.path);
+    }
+  }
+  QCOMPARE(offset, uint64_t(stats.input_size));
+
+  std::string destination = root + "/extracted";
+  QVERIFY(extract_archive(archive.c_str(), destination.c_str(), 4));
+
+  std::string extracted = destination + tree;
+  for (const auto& file : files) {
+    QCOMPARE(read_file(extracted + file.first), file.second);
+  }
+
+  struct stat status;
+  QCOMPARE(stat((extracted + "/zero").c_str(), &status), 0);
+  QCOMPARE(status.st_mode & 07777, mode_t(0600));
+  QCOMPARE(stat((extracted + "/small/nested").c_str(), &status), 0);
+  QVERIFY(S_ISDIR(status.st_mode));
+  QCOMPARE(status.st_mode & 07777, mode_t(0750));
+  QCOMPARE(stat((extracted + "/empty").c_str(), &status), 0);
+  QVERIFY(S_ISDIR(status.st_mode));
+
+  // A truncated archive is rejected
+  std::string content = read_file(archive);
+  std::string truncated = root + "/truncated.sdem";
+  write_file(truncated, content.substr(0, content.size() - 1));
+  QVERIFY(!list_archive(truncated.c_str(), directory));
+
+  std::string command = "rm -rf '" + root + "'";
+  QCOMPARE(system(command.c_str()), 0);
+}
+
+void ArchiveTest::testCase2() {
+  QCOMPARE(archive_path("a/b/c"), std::string("a/b/c"));
+  QCOMPARE(archive_path("/a//b/./c/"), std::string("a/b/c"));
+  QCOMPARE(archive_path("../../a/../b"), std::string("b"));
+  QCOMPARE(archive_path("."), std::string());
+  QCOMPARE(archive_path("/"), std::string());
+
+  QVERIFY(safe_archive_path("a/b"));
+  QVERIFY(!safe_archive_path(""));
+  QVERIFY(!safe_archive_path("/a"));
+  QVERIFY(!safe_archive_path("../a"));
+  QVERIFY(!safe_archive_path("a/../../b"));
+  QVERIFY(!safe_archive_path("a//b"));
+}
+
+void ArchiveTest::testCase3() {
+  // Frames of 3 bytes, none and 5 bytes
+  std::string frames;
+  for (size_t size : {size_t(3), size_t(0), size_t(5)}) {
+    frames += char(FRAME_COMPLETE);
+    frames.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    for (size_t i = 0; i < size; ++i) {
+      frames += char('a' + i);
+    }
+  }
+
+  uint64_t header = Frame<>::max_header_size;
+  std::vector<uint64_t> expected = {
+      10, 10 + header + 3, 10 + 2 * header + 3, 10 + 3 * header + 8};
+
+  // Whatever the writes the frames are cut into
+  for (size_t step : {size_t(1), size_t(4), frames.size()}) {
+    std::ostringstream output;
+    StreamSink<char> stream_sink(output);
+    FrameIndexSink<StreamSink<char>> sink(stream_sink, 10);
+
+    for (size_t i = 0; i < frames.size(); i += step) {
+      sink.write(frames.data() + i, std::min(step, frames.size() - i));
+    }
+
+    QCOMPARE(output.str(), frames);
+    QCOMPARE(sink.frames(), expected);
+
+    // The last 4 bytes of the frames
+    QCOMPARE(sink.checksums().size(), size_t(3));
+    QCOMPARE(std::memcmp(&sink.checksums().back(), "bcde", 4), 0);
+  }
+}
+
+void ArchiveTest::testCase4() {
+  char root_template[] = "/tmp/archive_test.XXXXXX";
+  std::string root = mkdtemp(root_template);
+  std::string tree = root + "/tree";
+
+  mkdir(tree.c_str(), 0755);
+  mkdir((tree + "/docs").c_str(), 0755);
+  mkdir((tree + "/docs/old").c_str(), 0755);
+
+  // A file repeated, of whole chunks, so that the chunks of the second copy
+  // refer to those of the first
+  std::mt19937 generator(11);
+  std::string block;
+  while (block.size() < 6 * MIN_CHUNK_SIZE) {
+    block += char('a' + generator() % 26);
+  }
+
+  std::vector<std::pair<std::string, std::string>> files = {
+      {"/copy1", block},
+      {"/copy2", block},
+      {"/docs/a", "first document"},
+      {"/docs/old/b", block.substr(0, 30000)},
+      {"/docs/old/c", "third document"},
+      {"/last", block.substr(500, 25000)}};
+
+  for (const auto& file : files) {
+    write_file(tree + file.first, file.second);
+  }
+
+  std::string archive = root + "/tree.sdem";
+  EncodingStats stats = archive_in_parallel(std::vector<std::string>{tree},
+                                            archive.c_str(),
+                                            4,
+                                            true,
+                                            false,
+                                            PresetDictionary<>(),
+                                            MIN_CHUNK_SIZE,
+                                            true);
+  QCOMPARE(stats.unreadable, size_t(0));
+  QVERIFY(stats.output_size + block.size() / 2 < stats.input_size);
+
+  ArchiveDirectory directory;
+  QVERIFY(list_archive(archive.c_str(), directory));
+
+  // A directory selects its entries, an unknown name nothing
+  std::string base = archive_path(tree);
+  std::vector<std::string> missing;
+  std::vector<ArchiveMember> selected =
+      directory.select({base + "/docs/old", "./" + base + "/last", "nothing"},
+                       &missing);
+
+  QCOMPARE(selected.size(), size_t(4));
+  QCOMPARE(selected[0].path, base + "/docs/old");
+  QCOMPARE(selected[1].path, base + "/docs/old/b");
+  QCOMPARE(selected[2].path, base + "/docs/old/c");
+  QCOMPARE(selected[3].path, base + "/last");
+  QCOMPARE(missing, std::vector<std::string>{"nothing"});
+  QCOMPARE(directory.select({"."}).size(), directory.members.size());
+
+  // Members are extracted whether their chunks are references or not
+  for (const std::string& name : {"/copy2", "/docs/old", "/last"}) {
+    std::string destination = root + "/extracted" + std::to_string(name[1]);
+    QVERIFY(extract_archive(archive.c_str(),
+                            destination.c_str(),
+                            2,
+                            PresetDictionary<>(),
+                            {base + name}));
+
+    for (const auto& file : files) {
+      std::string path = destination + tree + file.first;
+      bool extracted = file.first.compare(0, name.size(), name) == 0;
+
+      QCOMPARE(access(path.c_str(), F_OK) == 0, extracted);
+      if (extracted) {
+        QCOMPARE(read_file(path), file.second);
+      }
+    }
+  }
+
+  QVERIFY(!extract_archive(archive.c_str(),
+                           (root + "/missing").c_str(),
+                           2,
+                           PresetDictionary<>(),
+                           {base + "/copy1", "nothing"}));
+  QCOMPARE(read_file(root + "/missing" + tree + "/copy1"), block);
+
+  std::string command = "rm -rf '" + root + "'";
+  QCOMPARE(system(command.c_str()), 0);
+}
+
+void ArchiveTest::testCase5() {
+  char root_template[] = "/tmp/archive_test.XXXXXX";
+  std::string root = mkdtemp(root_template);
+  std::string tree = root + "/tree";
+  mkdir(tree.c_str(), 0755);
+
+  std::mt19937 generator(13);
+  std::string contents;
+  for (int i = 0; i < 20; ++i) {
+    std::string content;
+    size_t size = generator() % 20000;
+    while (content.size() < size) {
+      content += "value " + std::to_string(generator() % 300) + "\n";
+    }
+
+    write_file(tree + "/" + std::to_string(10 + i), content);
+    contents += content;
+  }
+
+  // Twice, for references
+  write_file(tree + "/90", contents);
+  contents += contents;
+
+  std::string archive = root + "/tree.sdem";
+  for (bool deduplicate : {false, true}) {
+    archive_in_parallel(std::vector<std::string>{tree},
+                        archive.c_str(),
+                        3,
+                        true,
+                        deduplicate,
+                        PresetDictionary<>(),
+                        MIN_CHUNK_SIZE,
+                        deduplicate);
+
+    // The checksum of the whole content, combined from those of the chunks
+    ArchiveDirectory directory;
+    QVERIFY(list_archive(archive.c_str(), directory));
+    QCOMPARE(directory.content_size(), uint64_t(contents.size()));
+    QCOMPARE(directory.checksum, crc32c(contents.data(), contents.size()));
+    QVERIFY(verify_in_parallel(archive.c_str(), 3));
+
+    // A changed symbol in a frame is found by verifying or extracting the
+    // archive, one in the checksum of the directory by verifying it
+    std::string content = read_file(archive);
+    std::string corrupted = root + "/corrupted.sdem";
+    uint64_t checksum_offset =
+        directory.frames.back() + sizeof(ARCHIVE_MAGIC) + sizeof(uint64_t);
+
+    for (uint64_t offset : {directory.frames[1] - 1,
+                            directory.frames.back() - 1,
+                            checksum_offset}) {
+      std::string changed = content;
+      changed[offset] ^= 1;
+      write_file(corrupted, changed);
+
+      QVERIFY(!verify_in_parallel(corrupted.c_str(), 3));
+      QCOMPARE(extract_archive(corrupted.c_str(),
+                               (root + "/extracted").c_str(),
+                               3),
+               offset == checksum_offset);
+    }
+  }
+
+  std::string command = "rm -rf '" + root + "'";
+  QCOMPARE(system(command.c_str()), 0);
+}
+
+QTEST_APPLESS_MAIN(ArchiveTest)
+
+#include "archive_test.moc"
@@ -0,0 +1,16 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = async_io_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += async_io_test.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
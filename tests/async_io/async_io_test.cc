@@ -0,0 +1,124 @@
+#include <QtTest>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "async_io.h"
+#include "sources.h"
+
+static const char* PATH = "async_io_test.tmp";
+
+// Blocks small enough for the buffers to wrap around many times
+static constexpr size_t SMALL_BLOCK_SIZE = 4096;
+static constexpr size_t SMALL_BLOCKS = 4;
+
+class AsyncIOTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+  void cleanup();
+};
+
+static std::vector<char> make_input(size_t size) {
+  std::vector<char> input(size);
+  for (size_t i = 0; i < size; ++i) {
+    input[i] = static_cast<char>(i * 7 + i / 251);
+  }
+
+  return input;
+}
+
+static bool write_file(std::unique_ptr<AsyncIO> io,
+                       const std::vector<char>& input) {
+  AsyncWriteBuffer buffer(std::move(io), SMALL_BLOCK_SIZE, SMALL_BLOCKS);
+  if (!buffer.open(PATH)) {
+    return false;
+  }
+
+  // Writes of various sizes, some larger than the blocks
+  std::ostream stream(&buffer);
+  size_t size = 1;
+  for (size_t i = 0; i < input.size(); i += size, size = size * 3 % 10007) {
+    stream.write(input.data() + i, std::min(size, input.size() - i));
+  }
+
+  return stream && buffer.close();
+}
+
+static std::vector<char> read_file(std::unique_ptr<AsyncIO> io) {
+  AsyncReadBuffer buffer(std::move(io), SMALL_BLOCK_SIZE, SMALL_BLOCKS);
+  std::vector<char> output;
+  if (!buffer.open(PATH)) {
+    return output;
+  }
+
+  StreamBufferIterator<char> begin(&buffer);
+  StreamBufferIterator<char> end;
+
+  char block[1000];
+  size_t size;
+  while ((size = read_block(begin, end, block, sizeof(block))) > 0) {
+    output.insert(output.end(), block, block + size);
+  }
+
+  return output;
+}
+
+void AsyncIOTest::testCase1() {
+  // The default backend
+  std::vector<char> input = make_input(100003);
+
+  QVERIFY(write_file(AsyncIO::create(SMALL_BLOCKS), input));
+  QVERIFY(read_file(AsyncIO::create(SMALL_BLOCKS)) == input);
+
+  // Empty files
+  QVERIFY(write_file(AsyncIO::create(SMALL_BLOCKS), std::vector<char>()));
+  QVERIFY(read_file(AsyncIO::create(SMALL_BLOCKS)).empty());
+}
+
+void AsyncIOTest::testCase2() {
+  // The thread-based backend
+  std::vector<char> input = make_input(65536);
+
+  QVERIFY(write_file(std::unique_ptr<AsyncIO>(new ThreadedIO()), input));
+  QVERIFY(read_file(std::unique_ptr<AsyncIO>(new ThreadedIO())) == input);
+}
+
+void AsyncIOTest::testCase3() {
+  std::vector<char> input = make_input(50000);
+  QVERIFY(write_file(AsyncIO::create(SMALL_BLOCKS), input));
+
+  AsyncReadBuffer buffer(
+      AsyncIO::create(SMALL_BLOCKS), SMALL_BLOCK_SIZE, SMALL_BLOCKS);
+  QVERIFY(buffer.open(PATH));
+  std::istream stream(&buffer);
+
+  char block[5000];
+  QVERIFY(stream.read(block, sizeof(block)));
+  QCOMPARE(static_cast<size_t>(stream.tellg()), sizeof(block));
+
+  // Seeking restarts the reads ahead
+  stream.seekg(0);
+  QCOMPARE(static_cast<char>(stream.get()), input[0]);
+
+  stream.seekg(30001);
+  QVERIFY(stream.read(block, 100));
+  QVERIFY(std::equal(block, block + 100, input.begin() + 30001));
+
+  stream.seekg(-10, std::ios_base::end);
+  stream.read(block, sizeof(block));
+  QCOMPARE(stream.gcount(), std::streamsize(10));
+  QVERIFY(std::equal(block, block + 10, input.end() - 10));
+}
+
+void AsyncIOTest::cleanup() {
+  std::remove(PATH);
+}
+
+QTEST_APPLESS_MAIN(AsyncIOTest)
+
+#include "async_io_test.moc"
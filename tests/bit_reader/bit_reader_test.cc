@@ -1,5 +1,7 @@
 #include <QtTest>
+#include <random>
 #include <sstream>
+#include <vector>
 #include "bit_writer.h"
 #include "bit_reader.h"
 
@@ -8,6 +10,7 @@ class BitReaderTest : public QObject {
 
  private Q_SLOTS:
   void testCase1();
+  void testCase2();
 };
 
 void BitReaderTest::testCase1() {
@@ -29,6 +32,40 @@ void BitReaderTest::testCase1() {
   }
 }
 
+void BitReaderTest::testCase2() {
+  std::stringstream stream;
+  BitWriter<> bit_writer(stream);
+  BitReader<> bit_reader(stream);
+
+  // Runs of bits wider than a byte, starting anywhere in one
+  std::mt19937_64 generator(3);
+  std::vector<std::pair<uint64_t, bits_t>> values;
+  for (int i = 0; i < 1000; ++i) {
+    bits_t bits = 1 + generator() % 64;
+    uint64_t value = generator();
+    values.emplace_back(value, bits);
+
+    // Bits beyond the requested ones are not written
+    bit_writer.write(value, bits);
+  }
+
+  bit_writer.write(uint32_t(0xdeadbeef));
+  bit_writer.flush();
+
+  for (auto&& value : values) {
+    uint64_t actual;
+    bit_reader.read(actual, value.second);
+
+    uint64_t mask = ~uint64_t(0) >> (64 - value.second);
+    QCOMPARE(actual, value.first & mask);
+  }
+
+  uint32_t last;
+  bit_reader.read(last);
+  QCOMPARE(last, uint32_t(0xdeadbeef));
+  QVERIFY(!bit_reader.overrun());
+}
+
 QTEST_APPLESS_MAIN(BitReaderTest)
 
 #include "bit_reader_test.moc"
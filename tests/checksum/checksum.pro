@@ -0,0 +1,16 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = checksum_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += checksum_test.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
@@ -0,0 +1,92 @@
+#include <QtTest>
+#include <random>
+#include <string>
+#include "checksum.h"
+#include "sinks.h"
+
+class ChecksumTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void ChecksumTest::testCase1() {
+  // Test vectors of RFC 3720
+  QCOMPARE(crc32c("", 0), uint32_t(0));
+  QCOMPARE(crc32c("123456789", 9), uint32_t(0xe3069283));
+
+  std::string zeros(32, '\0');
+  std::string ones(32, '\xff');
+  std::string ascending;
+  for (int i = 0; i < 32; ++i) {
+    ascending += char(i);
+  }
+
+  QCOMPARE(crc32c(zeros.data(), zeros.size()), uint32_t(0x8a9136aa));
+  QCOMPARE(crc32c(ones.data(), ones.size()), uint32_t(0x62a8ab43));
+  QCOMPARE(crc32c(ascending.data(), ascending.size()), uint32_t(0x46dd794e));
+}
+
+void ChecksumTest::testCase2() {
+  std::mt19937 generator(5);
+  std::string data;
+  for (int i = 0; i < 10000; ++i) {
+    data += char(generator());
+  }
+
+  // Whatever the blocks the data is cut into, extended or combined
+  uint32_t expected = crc32c(data.data(), data.size());
+
+  for (size_t cut : {size_t(0), size_t(1), size_t(7), size_t(4096)}) {
+    uint32_t first = crc32c(data.data(), cut);
+    uint32_t second = crc32c(data.data() + cut, data.size() - cut);
+
+    QCOMPARE(CRC32C::extend(first, data.data() + cut, data.size() - cut),
+             expected);
+    QCOMPARE(CRC32C::combine(first, second, data.size() - cut), expected);
+  }
+
+  ChecksumSink<char> sink;
+  for (size_t i = 0; i < data.size(); i += 333) {
+    sink.write(data.data() + i, std::min<size_t>(333, data.size() - i));
+  }
+
+  QCOMPARE(sink.checksum(), expected);
+  QCOMPARE(sink.size(), data.size());
+}
+
+// A bit at a time
+static uint32_t reference_crc32c(const unsigned char* bytes, size_t size) {
+  uint32_t crc = ~0u;
+  for (size_t i = 0; i < size; ++i) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (crc & 1 ? 0x82f63b78 : 0);
+    }
+  }
+  return ~crc;
+}
+
+void ChecksumTest::testCase3() {
+  // The same checksums with the instruction as with the tables, at every
+  // alignment and for every tail
+  std::string data;
+  for (int i = 0; i < 100; ++i) {
+    data += char(i * 37);
+  }
+
+  for (size_t begin = 0; begin < 8; ++begin) {
+    for (size_t size = 0; begin + size <= data.size(); ++size) {
+      const unsigned char* bytes =
+          reinterpret_cast<const unsigned char*>(data.data() + begin);
+      QCOMPARE(crc32c(bytes, size), reference_crc32c(bytes, size));
+    }
+  }
+}
+
+QTEST_APPLESS_MAIN(ChecksumTest)
+
+#include "checksum_test.moc"
@@ -0,0 +1,16 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = chunker_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += chunker_test.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <random>
+#include <set>
+#include <vector>
+#include "chunker.h"
+
+class ChunkerTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+static std::vector<char> make_input(size_t size, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::vector<char> input(size);
+  for (char& symbol : input) {
+    symbol = static_cast<char>(generator());
+  }
+
+  return input;
+}
+
+// The offsets of the ends of the chunks of a sequence
+static std::vector<size_t> boundaries(const GearChunker& chunker,
+                                      const std::vector<char>& input) {
+  std::vector<size_t> ends;
+  for (size_t offset = 0; offset < input.size();) {
+    offset += chunker.cut(input.data() + offset, input.size() - offset);
+    ends.push_back(offset);
+  }
+
+  return ends;
+}
+
+void ChunkerTest::testCase1() {
+  GearChunker chunker = GearChunker::for_chunk_size(16000);
+  QCOMPARE(chunker.min_size(), size_t(4000));
+  QCOMPARE(chunker.average_size(), size_t(8000));
+  QCOMPARE(chunker.max_size(), size_t(16000));
+
+  std::vector<char> input = make_input(1000000, 1);
+  std::vector<size_t> ends = boundaries(chunker, input);
+
+  // Every chunk but the last is within bounds
+  for (size_t i = 0; i + 1 < ends.size(); ++i) {
+    size_t size = ends[i] - (i ? ends[i - 1] : 0);
+    QVERIFY(size >= chunker.min_size());
+    QVERIFY(size <= chunker.max_size());
+  }
+
+  // And close to the average
+  size_t average = input.size() / ends.size();
+  QVERIFY(average > chunker.average_size() / 2);
+  QVERIFY(average < chunker.average_size() * 3 / 2);
+
+  // Short sequences are a single chunk
+  QCOMPARE(chunker.cut(input.data(), 100), size_t(100));
+  QCOMPARE(chunker.cut(input.data(), 0), size_t(0));
+}
+
+void ChunkerTest::testCase2() {
+  GearChunker chunker(2048, 8192, 32768);
+  std::vector<char> input = make_input(500000, 2);
+
+  std::vector<char> edited = input;
+  edited.insert(edited.begin() + 1000, 'x');
+  edited.erase(edited.begin() + 300000, edited.begin() + 300010);
+
+  std::vector<size_t> ends = boundaries(chunker, input);
+  std::vector<size_t> edited_ends = boundaries(chunker, edited);
+
+  // Past the first edit, the chunks end at the same symbols
+  std::set<size_t> shifted;
+  for (size_t end : edited_ends) {
+    shifted.insert(end < 300000 ? end - 1 : end + 9);
+  }
+
+  size_t kept = 0;
+  for (size_t end : ends) {
+    kept += shifted.count(end);
+  }
+
+  QVERIFY(kept + 4 >= ends.size());
+}
+
+void ChunkerTest::testCase3() {
+  // Without any boundary, chunks are cut at the maximum size
+  GearChunker chunker(1000, 2000, 5000);
+  std::vector<char> zeros(12000, 0);
+
+  std::vector<size_t> ends = boundaries(chunker, zeros);
+  QCOMPARE(ends, std::vector<size_t>({5000, 10000, 12000}));
+}
+
+QTEST_APPLESS_MAIN(ChunkerTest)
+
+#include "chunker_test.moc"
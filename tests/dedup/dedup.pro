@@ -0,0 +1,16 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = dedup_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += dedup_test.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
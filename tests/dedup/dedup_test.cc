@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include "dedup.h"
+
+class DedupTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void DedupTest::testCase1() {
+  // Reference values of MurmurHash3_x64_128
+  Hash128 empty = murmur3_128("", 0);
+  QCOMPARE(empty.low, uint64_t(0));
+  QCOMPARE(empty.high, uint64_t(0));
+
+  Hash128 hello = murmur3_128("hello", 5);
+  QCOMPARE(hello.low, uint64_t(0xcbd8a7b341bd9b02));
+  QCOMPARE(hello.high, uint64_t(0x5b1e906a48ae1d19));
+
+  // Every tail size
+  std::string text = "The quick brown fox jumps over the lazy dog";
+  std::vector<Hash128> hashes;
+  for (size_t size = 0; size <= text.size(); ++size) {
+    Hash128 hash = murmur3_128(text.data(), size);
+    for (const Hash128& other : hashes) {
+      QVERIFY(hash != other);
+    }
+
+    hashes.push_back(hash);
+  }
+
+  QVERIFY(murmur3_128(text.data(), text.size(), 1) != hashes.back());
+}
+
+void DedupTest::testCase2() {
+  ChunkIndex index;
+  Hash128 a = murmur3_128("a", 1);
+  Hash128 b = murmur3_128("b", 1);
+
+  QCOMPARE(index.find(a, 0), size_t(0));
+  QCOMPARE(index.find(b, 1), size_t(0));
+  QCOMPARE(index.find(a, 3), size_t(3));
+  QCOMPARE(index.find(a, 4), size_t(1));
+
+  // Chunks looked up out of order only refer to earlier ones
+  QCOMPARE(index.find(b, 10), size_t(9));
+  QCOMPARE(index.find(b, 7), size_t(0));
+
+  // Nor too far behind
+  QCOMPARE(index.find(a, 5 + DEDUP_WINDOW), size_t(0));
+  QCOMPARE(index.find(a, 6 + DEDUP_WINDOW), size_t(1));
+
+  // Many chunks
+  for (size_t i = 0; i < 100 * DEDUP_WINDOW; ++i) {
+    std::string chunk = std::to_string(i % DEDUP_WINDOW);
+    size_t distance =
+        index.find(murmur3_128(chunk.data(), chunk.size()), 100 + i);
+    QCOMPARE(distance, i >= DEDUP_WINDOW ? DEDUP_WINDOW : size_t(0));
+  }
+
+  index.clear();
+  QCOMPARE(index.find(a, 100), size_t(0));
+}
+
+void DedupTest::testCase3() {
+  ChunkHistory<char> history;
+  history.reset(4);
+
+  for (size_t i = 0; i < 100; ++i) {
+    std::string chunk = "chunk " + std::to_string(i);
+    history.remember(chunk.data(), chunk.size());
+  }
+
+  const std::vector<char>* chunk = history.find(100, DEDUP_WINDOW);
+  QVERIFY(chunk);
+  QCOMPARE(std::string(chunk->begin(), chunk->end()),
+           "chunk " + std::to_string(100 - DEDUP_WINDOW));
+
+  chunk = history.find(99, 1);
+  QVERIFY(chunk);
+  QCOMPARE(std::string(chunk->begin(), chunk->end()), std::string("chunk 98"));
+
+  // References out of the window, or to chunks not remembered yet
+  QVERIFY(!history.find(100, DEDUP_WINDOW + 1));
+  QVERIFY(!history.find(100, 0));
+  QVERIFY(!history.find(5, 6));
+  QVERIFY(!history.find(102, 1));
+
+  history.reset(4);
+  QVERIFY(!history.find(1, 1));
+}
+
+QTEST_APPLESS_MAIN(DedupTest)
+
+#include "dedup_test.moc"
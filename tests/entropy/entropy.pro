@@ -0,0 +1,16 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = entropy_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += entropy_test.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
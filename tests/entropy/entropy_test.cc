@@ -0,0 +1,45 @@
+#include <QtTest>
+#include <random>
+#include <string>
+#include "entropy.h"
+
+class EntropyTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+};
+
+void EntropyTest::testCase1() {
+  std::string same(1000, 'a');
+  QCOMPARE(entropy(same.data(), same.size()), 0.0);
+
+  std::string uniform;
+  for (int i = 0; i < 256 * 4; ++i) {
+    uniform += static_cast<char>(i);
+  }
+  QCOMPARE(entropy(uniform.data(), uniform.size()), 8.0);
+
+  std::string two("abababab");
+  QCOMPARE(entropy(two.data(), two.size()), 1.0);
+}
+
+void EntropyTest::testCase2() {
+  std::mt19937 generator(7);
+  std::string random;
+  for (int i = 0; i < 64000; ++i) {
+    random += static_cast<char>(generator());
+  }
+  QVERIFY(incompressible(random.data(), random.size()));
+
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    text += "entropy " + std::to_string(i) + "\n";
+  }
+  QVERIFY(!incompressible(text.data(), text.size()));
+}
+
+QTEST_APPLESS_MAIN(EntropyTest)
+
+#include "entropy_test.moc"
@@ -0,0 +1,92 @@
+#include <QtTest>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "executor.h"
+
+class ExecutorTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+  void testCase4();
+};
+
+void ExecutorTest::testCase1() {
+  std::atomic<int> count(0);
+
+  {
+    WorkStealingExecutor executor(4);
+    QCOMPARE(executor.size(), static_cast<size_t>(4));
+
+    for (int i = 0; i < 1000; ++i) {
+      executor.submit([&count] { ++count; });
+    }
+  }
+
+  // The remaining tasks run before the threads stop
+  QCOMPARE(count.load(), 1000);
+}
+
+void ExecutorTest::testCase2() {
+  std::atomic<int> count(0);
+
+  {
+    WorkStealingExecutor executor(3);
+
+    // Tasks submitting tasks
+    for (int i = 0; i < 100; ++i) {
+      executor.submit([&executor, &count] {
+        for (int j = 0; j < 10; ++j) {
+          executor.submit([&count] { ++count; });
+        }
+      });
+    }
+  }
+
+  QCOMPARE(count.load(), 1000);
+}
+
+void ExecutorTest::testCase3() {
+  std::atomic<int> slow(0);
+  std::atomic<int> fast(0);
+
+  {
+    WorkStealingExecutor executor(2);
+
+    // A thread stuck on a slow task leaves its queue to the other one
+    executor.submit([&executor, &slow, &fast] {
+      for (int i = 0; i < 100; ++i) {
+        executor.submit([&fast] { ++fast; });
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      slow = fast.load();
+    });
+  }
+
+  QCOMPARE(fast.load(), 100);
+  QCOMPARE(slow.load(), 100);
+}
+
+void ExecutorTest::testCase4() {
+  std::atomic<int> count(0);
+
+  {
+    // Threads pinned to the nodes, one per node in turn
+    WorkStealingExecutor executor(4, 1);
+    QCOMPARE(executor.threads_per_node(), static_cast<size_t>(1));
+
+    for (int i = 0; i < 1000; ++i) {
+      executor.submit([&count] { ++count; }, i);
+    }
+  }
+
+  QCOMPARE(count.load(), 1000);
+}
+
+QTEST_APPLESS_MAIN(ExecutorTest)
+
+#include "executor_test.moc"
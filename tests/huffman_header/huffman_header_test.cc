@@ -0,0 +1,97 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include <iterator>
+#include "huffman_encoder_stack.h"
+#include "huffman_decoder_stack.h"
+
+class HuffmanHeaderTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void HuffmanHeaderTest::testCase1() {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input += "compact header " + std::to_string(i) + "\n";
+  }
+
+  std::vector<char> compact;
+  HuffmanEncoderStack<char> compact_encoder;
+  compact_encoder(input.begin(), input.end(), std::back_inserter(compact));
+
+  std::vector<char> raw;
+  HuffmanEncoderStack<char, RawHuffmanHeader> raw_encoder;
+  raw_encoder(input.begin(), input.end(), std::back_inserter(raw));
+
+  QVERIFY(compact.size() + 200 < raw.size());
+
+  std::string decoded;
+  HuffmanDecoderStack<char> decoder;
+  decoder(compact.begin(), compact.end(), std::back_inserter(decoded));
+  QCOMPARE(decoded, input);
+
+  decoded.clear();
+  HuffmanDecoderStack<char, RawHuffmanHeader> raw_decoder;
+  raw_decoder(raw.begin(), raw.end(), std::back_inserter(decoded));
+  QCOMPARE(decoded, input);
+}
+
+void HuffmanHeaderTest::testCase2() {
+  std::string first("the table of this sequence is reused by the next one");
+  std::string second("the next one reuses the table of the sequence");
+
+  std::vector<char> encoded;
+  HuffmanEncoderStack<char> encoder;
+  encoder(first.begin(), first.end(), std::back_inserter(encoded));
+  size_t first_size = encoded.size();
+  encoder(second.begin(), second.end(), std::back_inserter(encoded));
+
+  // The second header is made of its kind and of the number of bits only
+  QCOMPARE(static_cast<unsigned char>(encoded[first_size]) >> 6,
+           static_cast<int>(HUFFMAN_HEADER_REUSE));
+
+  std::string decoded;
+  HuffmanDecoderStack<char> decoder;
+  auto next =
+      decoder.decode(encoded.begin(), encoded.end(), std::back_inserter(decoded));
+  QCOMPARE(decoded, first);
+  QVERIFY(next == encoded.begin() + first_size);
+
+  decoded.clear();
+  decoder.decode(next, encoded.end(), std::back_inserter(decoded));
+  QCOMPARE(decoded, second);
+}
+
+void HuffmanHeaderTest::testCase3() {
+  std::string input(300, 'a');
+  for (int i = 0; i < 256; ++i) {
+    input += static_cast<char>(i);
+  }
+
+  std::vector<char> encoded;
+  HuffmanEncoderStack<char> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(encoded));
+  encoded.push_back(42);
+
+  std::vector<char> buffer(encoded.size());
+  auto begin = encoded.begin();
+  size_t size = HuffmanDecoderStack<char>::prepare_input_buffer(
+      begin, encoded.end(), buffer.data(), buffer.size());
+
+  QCOMPARE(size, encoded.size() - 1);
+  QVERIFY(begin == encoded.end() - 1);
+
+  std::string decoded;
+  HuffmanDecoderStack<char> decoder;
+  decoder(buffer.data(), buffer.data() + size, std::back_inserter(decoded));
+  QCOMPARE(decoded, input);
+}
+
+QTEST_APPLESS_MAIN(HuffmanHeaderTest)
+
+#include "huffman_header_test.moc"
@@ -0,0 +1,17 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = incremental_decoder_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += incremental_decoder_test.cc \
+    ../../app/parallel.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
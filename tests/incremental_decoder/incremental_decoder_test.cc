@@ -0,0 +1,223 @@
+#include <QtTest>
+#include <random>
+#include <string>
+#include <vector>
+#include "incremental_decoder.h"
+#include "parallel.h"
+#include "container.h"
+
+class IncrementalDecoderTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1_data();
+  void testCase1();
+  void testCase2();
+  void testCase3_data();
+  void testCase3();
+};
+
+// Feed a container and pull its symbols in pieces of random sizes, up to
+// max_piece
+static std::string decode(IncrementalDecoder<>& decoder,
+                          const std::vector<char>& container,
+                          std::mt19937& generator,
+                          size_t max_piece) {
+  std::string output;
+  std::vector<char> piece(max_piece);
+  size_t fed = 0;
+
+  while (!decoder.done() && decoder.error() == DECODE_OK) {
+    size_t size = decoder.pull(piece.data(), 1 + generator() % max_piece);
+    output.append(piece.data(), size);
+
+    if (size) {
+      continue;
+    }
+
+    if (fed == container.size()) {
+      decoder.finish();
+    }
+
+    size = std::min(container.size() - fed, 1 + generator() % max_piece);
+    fed += decoder.feed(container.data() + fed, size);
+  }
+
+  return output;
+}
+
+void IncrementalDecoderTest::testCase1_data() {
+  QTest::addColumn<bool>("primed");
+  QTest::addColumn<bool>("checksums");
+  QTest::addColumn<bool>("with_dictionary");
+  QTest::addColumn<int>("max_piece");
+  QTest::addColumn<bool>("grouped_flags");
+
+  QTest::newRow("plain") << false << false << false << 1000 << false;
+  QTest::newRow("byte by byte") << false << false << false << 1 << false;
+  QTest::newRow("primed") << true << false << false << 300 << false;
+  QTest::newRow("checksums") << false << true << false << 5000 << false;
+  QTest::newRow("dictionary") << false << true << true << 100 << false;
+  QTest::newRow("primed dictionary") << true << false << true << 7 << false;
+  QTest::newRow("grouped flags") << false << true << false << 1000 << true;
+  QTest::newRow("grouped byte by byte") << true << false << true << 1 << true;
+}
+
+void IncrementalDecoderTest::testCase1() {
+  QFETCH(bool, primed);
+  QFETCH(bool, checksums);
+  QFETCH(bool, with_dictionary);
+  QFETCH(int, max_piece);
+  QFETCH(bool, grouped_flags);
+
+  std::mt19937 generator(11);
+  std::string input;
+  while (input.size() < 3 * MIN_CHUNK_SIZE) {
+    input += "line " + std::to_string(generator() % 1000) + "\n";
+  }
+
+  // A stored chunk, and a chunk of long matches
+  input.resize(3 * MIN_CHUNK_SIZE);
+  for (size_t i = 0; i < MIN_CHUNK_SIZE; ++i) {
+    input += char(generator());
+  }
+  input += std::string(MIN_CHUNK_SIZE / 2, 'z');
+
+  std::string content("line 1000\nline 999\n");
+  PresetDictionary<> dictionary =
+      with_dictionary ? PresetDictionary<>(content.begin(), content.end())
+                      : PresetDictionary<>();
+
+  std::vector<char> compressed(compress_bound(input.size()));
+  size_t size = compress(input.data(),
+                         input.size(),
+                         compressed.data(),
+                         compressed.size(),
+                         2,
+                         true,
+                         false,
+                         primed,
+                         dictionary,
+                         MIN_CHUNK_SIZE,
+                         checksums,
+                         grouped_flags);
+  compressed.resize(size);
+
+  IncrementalDecoder<> decoder(dictionary);
+  QCOMPARE(decode(decoder, compressed, generator, max_piece), input);
+  QVERIFY(decoder.done());
+  QCOMPARE(decoder.error(), DECODE_OK);
+
+  // The decoder is reused for the next container
+  decoder.reset();
+  QCOMPARE(decode(decoder, compressed, generator, 4096), input);
+  QVERIFY(decoder.done());
+}
+
+void IncrementalDecoderTest::testCase2() {
+  std::string input(1000, 'x');
+  std::vector<char> compressed(compress_bound(input.size()));
+  std::mt19937 generator(5);
+
+  // Token streams need whole chunks
+  size_t size = compress(input.data(),
+                         input.size(),
+                         compressed.data(),
+                         compressed.size(),
+                         1,
+                         true,
+                         true);
+  compressed.resize(size);
+
+  IncrementalDecoder<> decoder;
+  QCOMPARE(decode(decoder, compressed, generator, 100), std::string());
+  QCOMPARE(decoder.error(), DECODE_UNSUPPORTED);
+
+  // Another preset dictionary
+  compressed.resize(compress_bound(input.size()));
+  size = compress(
+      input.data(), input.size(), compressed.data(), compressed.size(), 1);
+  compressed.resize(size);
+
+  std::string content("xxxx");
+  PresetDictionary<> dictionary(content.begin(), content.end());
+  IncrementalDecoder<> other(dictionary);
+  decode(other, compressed, generator, 100);
+  QCOMPARE(other.error(), DECODE_UNSUPPORTED);
+
+  // An empty sequence is an empty container
+  compressed.resize(compress_bound(0));
+  size = compress(input.data(), 0, compressed.data(), compressed.size(), 1);
+  compressed.resize(size);
+
+  decoder.reset();
+  QCOMPARE(decode(decoder, compressed, generator, 100), std::string());
+  QVERIFY(decoder.done());
+}
+
+void IncrementalDecoderTest::testCase3_data() {
+  QTest::addColumn<bool>("grouped_flags");
+
+  QTest::newRow("bitstream") << false;
+  QTest::newRow("grouped flags") << true;
+}
+
+void IncrementalDecoderTest::testCase3() {
+  QFETCH(bool, grouped_flags);
+
+  std::mt19937 generator(7);
+  std::string input;
+  while (input.size() < 50000) {
+    input += "record " + std::to_string(generator() % 500) + "\n";
+  }
+
+  std::vector<char> compressed(compress_bound(input.size()));
+  size_t size = compress(input.data(),
+                         input.size(),
+                         compressed.data(),
+                         compressed.size(),
+                         2,
+                         true,
+                         false,
+                         true,
+                         PresetDictionary<>(),
+                         MIN_CHUNK_SIZE,
+                         true,
+                         grouped_flags);
+  compressed.resize(size);
+
+  ContainerHeader header;
+  const char* begin = compressed.data();
+  QVERIFY(header.read(begin, begin + size));
+  size_t header_size = begin - compressed.data();
+
+  // Corrupted chunks never pass their checksum
+  IncrementalDecoder<> decoder;
+  for (int i = 0; i < 200; ++i) {
+    std::vector<char> corrupted = compressed;
+    for (int j = 0; j < 1 + i % 4; ++j) {
+      size_t offset = header_size + generator() % (size - header_size);
+      corrupted[offset] ^= char(1 << generator() % 8);
+    }
+
+    decoder.reset();
+    std::string output = decode(decoder, corrupted, generator, 2000);
+    QCOMPARE(decoder.done(), decoder.error() == DECODE_OK);
+    QVERIFY(decoder.error() != DECODE_OK || output == input);
+  }
+
+  // The container cut anywhere
+  for (size_t cut = 1; cut < size - header_size; cut += 97) {
+    std::vector<char> truncated(compressed.begin(), compressed.end() - cut);
+
+    decoder.reset();
+    std::string output = decode(decoder, truncated, generator, 2000);
+    QVERIFY(!decoder.done());
+    QVERIFY(decoder.error() != DECODE_OK);
+    QVERIFY(input.compare(0, output.size(), output) == 0);
+  }
+}
+
+QTEST_APPLESS_MAIN(IncrementalDecoderTest)
+
+#include "incremental_decoder_test.moc"
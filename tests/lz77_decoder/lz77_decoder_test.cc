@@ -19,6 +19,7 @@ class Lz77DecoderTest : public QObject {
  private Q_SLOTS:
   void testCase1();
   void testCase1_data();
+  void testCase2();
 };
 
 void Lz77DecoderTest::testCase1() {
@@ -49,6 +50,38 @@ void Lz77DecoderTest::testCase1_data() {
   t("00a11c34b33a12c", "aacaacabcabaaac");
 }
 
+void Lz77DecoderTest::testCase2() {
+  LZ77Decoder<8, 8> d;
+
+  // A match at position 0, a match before the first symbol, and a token cut
+  // by the end of the input
+  const string inputs[] = {
+      string("\0\3a", 3), string("\0\0a\2\1b", 6), string("\0\0a\1", 4)};
+  const DecodeError errors[] = {
+      DECODE_INVALID_MATCH, DECODE_INVALID_MATCH, DECODE_TRUNCATED};
+
+  for (size_t i = 0; i < 3; ++i) {
+    string decoded_stream;
+    d.clear();
+    d(inputs[i].cbegin(), inputs[i].cend(), back_inserter(decoded_stream));
+
+    QCOMPARE(d.error(), errors[i]);
+  }
+
+  // Fewer tokens than announced
+  string input("\0\0a\1\1b", 6);
+  string decoded_stream;
+  d.clear();
+  d(input.cbegin(), input.cend(), back_inserter(decoded_stream), 3);
+
+  QCOMPARE(d.error(), DECODE_TRUNCATED);
+  QCOMPARE(decoded_stream, string("aab"));
+
+  d.clear();
+  d(input.cbegin(), input.cend(), back_inserter(decoded_stream), 2);
+  QCOMPARE(d.error(), DECODE_OK);
+}
+
 QTEST_APPLESS_MAIN(Lz77DecoderTest)
 
 #include "lz77_decoder_test.moc"
@@ -4,12 +4,15 @@
 #include <iterator>
 #include <cctype>
 #include "lzss_decoder.h"
+#include "encoder_wrapper.h"
+#include "decoder_wrapper.h"
 
 class LZSSDecoderTest : public QObject {
   Q_OBJECT
 
  private Q_SLOTS:
   void testCase1();
+  void testCase2();
 };
 
 void LZSSDecoderTest::testCase1() {
@@ -29,6 +32,41 @@ void LZSSDecoderTest::testCase1() {
   QCOMPARE(decoded, input_vector);
 }
 
+void LZSSDecoderTest::testCase2() {
+  std::string input("aacaacabcabaaac");
+  std::vector<char> encoded;
+
+  EncoderWrapper<NaiveLZSSEncoder<8, 4, 3, 6, 4>> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(encoded));
+
+  DecoderWrapper<LZSSDecoder<8, 4, 3>> decoder;
+  std::string decoded;
+
+  // Too short for the count of tokens
+  for (size_t size = 0; size < sizeof(size_t); ++size) {
+    decoder(encoded.begin(),
+            encoded.begin() + size,
+            std::back_inserter(decoded));
+    QCOMPARE(decoder.error(), DECODE_TRUNCATED);
+  }
+
+  // A symbol between the tokens and their count, and a count too large
+  std::vector<char> longer = encoded;
+  longer.insert(longer.end() - sizeof(size_t), 0);
+  decoder(longer.begin(), longer.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_TRAILING_DATA);
+
+  std::vector<char> more = encoded;
+  ++more[more.size() - sizeof(size_t)];
+  decoder(more.begin(), more.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_TRUNCATED);
+
+  decoded.clear();
+  decoder(encoded.begin(), encoded.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_OK);
+  QCOMPARE(decoded, input);
+}
+
 QTEST_APPLESS_MAIN(LZSSDecoderTest)
 
 #include "lzss_decoder_test.moc"
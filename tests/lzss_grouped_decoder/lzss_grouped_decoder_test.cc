@@ -0,0 +1,115 @@
+#include <QtTest>
+#include <random>
+#include <string>
+#include <vector>
+#include <iterator>
+#include "lzss_grouped_decoder.h"
+#include "lzss_encoder.h"
+#include "encoder_wrapper.h"
+#include "decoder_wrapper.h"
+
+class LZSSGroupedDecoderTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void LZSSGroupedDecoderTest::testCase1() {
+  std::string input("aacaacabcabaaac");
+  std::vector<char> encoded;
+
+  NaiveLZSSGroupedEncoder<8, 4, 3, 6, 4> encoder;
+  size_t steps =
+      encoder(input.begin(), input.end(), std::back_inserter(encoded));
+
+  std::string decoded;
+  LZSSGroupedDecoder<8, 4, 3> decoder;
+  auto next = decoder(
+      encoded.begin(), encoded.end(), std::back_inserter(decoded), steps);
+
+  QCOMPARE(decoder.error(), DECODE_OK);
+  QVERIFY(next == encoded.end());
+  QCOMPARE(decoded, input);
+}
+
+void LZSSGroupedDecoderTest::testCase2() {
+  // Groups of literals only, of matches only, and mixed ones
+  std::mt19937 generator(17);
+  std::string input;
+  for (int i = 0; i < 3000; ++i) {
+    input += char(generator());
+  }
+  for (int i = 0; i < 3000; ++i) {
+    input += "group " + std::to_string(generator() % 50) + "\n";
+  }
+  input += std::string(1000, 'g');
+  input += "xyz";
+
+  std::vector<char> tokens;
+  LZSSEncoder<12, 4> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(tokens));
+
+  std::vector<char> grouped;
+  LZSSGroupedEncoder<12, 4> grouped_encoder;
+  size_t steps =
+      grouped_encoder(input.begin(), input.end(), std::back_inserter(grouped));
+
+  // Matches take two bytes, as long as in the bitstream with their flag
+  QVERIFY(grouped.size() <= tokens.size() + 1);
+
+  // The last group is not full
+  QVERIFY(steps % LZSS_GROUP_SIZE != 0);
+
+  std::string decoded;
+  LZSSGroupedDecoder<12, 4> decoder;
+  decoder(grouped.begin(), grouped.end(), std::back_inserter(decoded), steps);
+
+  QCOMPARE(decoder.error(), DECODE_OK);
+  QCOMPARE(decoded, input);
+}
+
+void LZSSGroupedDecoderTest::testCase3() {
+  std::string input("aacaacabcabaaac");
+  std::vector<char> encoded;
+
+  EncoderWrapper<NaiveLZSSGroupedEncoder<8, 4, 3, 6, 4>> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(encoded));
+
+  DecoderWrapper<LZSSGroupedDecoder<8, 4, 3>> decoder;
+  std::string decoded;
+
+  // Every part of the tokens, followed by their count
+  size_t size = encoded.size() - sizeof(size_t);
+  for (size_t cut = 0; cut < size; ++cut) {
+    std::vector<char> truncated(encoded.begin(), encoded.begin() + cut);
+    truncated.insert(truncated.end(), encoded.end() - sizeof(size_t),
+                     encoded.end());
+
+    decoder(truncated.begin(), truncated.end(), std::back_inserter(decoded));
+    QCOMPARE(decoder.error(), DECODE_TRUNCATED);
+  }
+
+  // A symbol between the tokens and their count
+  std::vector<char> longer = encoded;
+  longer.insert(longer.end() - sizeof(size_t), 0);
+  decoder(longer.begin(), longer.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_TRAILING_DATA);
+
+  // A literal flagged as a match refers to symbols before the first one
+  std::vector<char> flipped = encoded;
+  flipped[0] ^= 0x80;
+  decoder(flipped.begin(), flipped.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_INVALID_MATCH);
+
+  decoded.clear();
+  decoder(encoded.begin(), encoded.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_OK);
+  QCOMPARE(decoded, input);
+}
+
+QTEST_APPLESS_MAIN(LZSSGroupedDecoderTest)
+
+#include "lzss_grouped_decoder_test.moc"
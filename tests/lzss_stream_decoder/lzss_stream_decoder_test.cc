@@ -0,0 +1,106 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include <iterator>
+#include "lzss_stream_decoder.h"
+#include "huffman_streams_encoder_stack.h"
+#include "huffman_streams_decoder_stack.h"
+
+class LZSSStreamDecoderTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void LZSSStreamDecoderTest::testCase1() {
+  std::string input("aacaacabcabaaac");
+  std::vector<char> encoded;
+
+  NaiveLZSSStreamEncoder<8, 4, 3, 6, 4> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(encoded));
+
+  std::string decoded;
+  LZSSStreamDecoder<8, 4, 3> decoder;
+  decoder(encoded.begin(), encoded.end(), std::back_inserter(decoded));
+
+  QCOMPARE(decoded, input);
+}
+
+void LZSSStreamDecoderTest::testCase2() {
+  std::string input;
+  for (int i = 0; i < 5000; ++i) {
+    input += "token " + std::to_string(i % 97) + " streams\n";
+  }
+
+  std::vector<char> tokens;
+  LZSSStreamEncoder<12, 4> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(tokens));
+
+  std::vector<char> encoded;
+  HuffmanStreamsEncoderStack<LZSS_STREAMS> encoder_stack;
+  encoder_stack(tokens.begin(), tokens.end(), std::back_inserter(encoded));
+
+  QVERIFY(encoded.size() < tokens.size());
+
+  std::vector<char> decoded_tokens;
+  HuffmanStreamsDecoderStack<LZSS_STREAMS> decoder_stack;
+  decoder_stack(
+      encoded.begin(), encoded.end(), std::back_inserter(decoded_tokens));
+
+  QCOMPARE(decoded_tokens, tokens);
+
+  std::string decoded;
+  LZSSStreamDecoder<12, 4> decoder;
+  decoder(tokens.begin(), tokens.end(), std::back_inserter(decoded));
+
+  QCOMPARE(decoded, input);
+}
+
+void LZSSStreamDecoderTest::testCase3() {
+  std::string input("aacaacabcabaaac");
+  std::vector<char> encoded;
+
+  NaiveLZSSStreamEncoder<8, 4, 3, 6, 4> encoder;
+  encoder(input.begin(), input.end(), std::back_inserter(encoded));
+
+  LZSSStreamDecoder<8, 4, 3> decoder;
+
+  // Every part of the streams, and the streams followed by another symbol
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    std::string decoded;
+    decoder(encoded.begin(),
+            encoded.begin() + size,
+            std::back_inserter(decoded));
+
+    QCOMPARE(decoder.error(), DECODE_TRUNCATED);
+  }
+
+  std::vector<char> longer = encoded;
+  longer.push_back(0);
+  std::string decoded;
+  decoder(longer.begin(), longer.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_TRAILING_DATA);
+
+  // A literal flagged as a match, and a match before the first symbol
+  std::vector<char> flipped = encoded;
+  flipped[sizeof(size_t)] ^= 0x80;
+  decoder(flipped.begin(), flipped.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_INVALID_MATCH);
+
+  std::vector<char> far = encoded;
+  far[far.size() - sizeof(size_t) - 1] = char(0xff);
+  decoder(far.begin(), far.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_INVALID_MATCH);
+
+  decoded.clear();
+  decoder(encoded.begin(), encoded.end(), std::back_inserter(decoded));
+  QCOMPARE(decoder.error(), DECODE_OK);
+  QCOMPARE(decoded, input);
+}
+
+QTEST_APPLESS_MAIN(LZSSStreamDecoderTest)
+
+#include "lzss_stream_decoder_test.moc"
@@ -0,0 +1,17 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = parallel_test
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += parallel_test.cc \
+    ../../app/parallel.cc
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+
+include(../tests.pri)
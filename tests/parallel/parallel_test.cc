@@ -0,0 +1,418 @@
+#include <QtTest>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "parallel.h"
+#include "container.h"
+
+class ParallelTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1_data();
+  void testCase1();
+  void testCase2();
+  void testCase3();
+  void testCase4();
+  void testCase5();
+  void testCase6();
+  void testCase7();
+};
+
+void ParallelTest::testCase1_data() {
+  QTest::addColumn<int>("threads");
+  QTest::addColumn<bool>("token_streams");
+  QTest::addColumn<bool>("primed");
+  QTest::addColumn<bool>("grouped_flags");
+
+  QTest::newRow("single-threaded") << 1 << false << false << false;
+  QTest::newRow("multi-threaded") << 4 << false << false << false;
+  QTest::newRow("token streams") << 4 << true << false << false;
+  QTest::newRow("primed") << 4 << true << true << false;
+  QTest::newRow("grouped flags") << 4 << false << false << true;
+  QTest::newRow("primed grouped flags") << 4 << false << true << true;
+  QTest::newRow("token streams, not grouped") << 4 << true << false << true;
+}
+
+void ParallelTest::testCase1() {
+  QFETCH(int, threads);
+  QFETCH(bool, token_streams);
+  QFETCH(bool, primed);
+  QFETCH(bool, grouped_flags);
+
+  std::mt19937 generator(3);
+  std::string input;
+  while (input.size() < 3 * DEFAULT_CHUNK_SIZE) {
+    input += "line " + std::to_string(generator() % 1000) + "\n";
+  }
+
+  std::vector<char> compressed(compress_bound(input.size()));
+  size_t compressed_size = compress(input.data(),
+                                    input.size(),
+                                    compressed.data(),
+                                    compressed.size(),
+                                    threads,
+                                    true,
+                                    token_streams,
+                                    primed,
+                                    PresetDictionary<>(),
+                                    0,
+                                    false,
+                                    grouped_flags);
+
+  QVERIFY(compressed_size < input.size());
+
+  ContainerHeader header;
+  const char* begin = compressed.data();
+  QVERIFY(header.read(begin, begin + compressed_size));
+  QVERIFY(header.supported());
+  QCOMPARE(header.has(CONTAINER_GROUPED_FLAGS),
+           grouped_flags && !token_streams);
+
+  std::string output(input.size(), '\0');
+  size_t output_size = decompress(compressed.data(),
+                                  compressed_size,
+                                  &output[0],
+                                  output.size(),
+                                  threads);
+
+  QCOMPARE(output_size, input.size());
+  QCOMPARE(output, input);
+}
+
+void ParallelTest::testCase2() {
+  std::mt19937 generator(5);
+  std::string input;
+  for (size_t i = 0; i < DEFAULT_CHUNK_SIZE + 10; ++i) {
+    input += static_cast<char>(generator());
+  }
+
+  // Incompressible data still fits in compress_bound()
+  std::vector<char> compressed(compress_bound(input.size()));
+  size_t compressed_size = compress(
+      input.data(), input.size(), compressed.data(), compressed.size());
+  QVERIFY(compressed_size <= compressed.size());
+
+  QCOMPARE(compress(input.data(), input.size(), compressed.data(), 100),
+           OUTPUT_OVERFLOW);
+
+  std::string output(input.size() - 1, '\0');
+  QCOMPARE(decompress(compressed.data(),
+                      compressed_size,
+                      &output[0],
+                      output.size()),
+           OUTPUT_OVERFLOW);
+}
+
+void ParallelTest::testCase3() {
+  std::string input(1000, 'x');
+  std::string content("xxxx");
+  PresetDictionary<> dictionary(content.begin(), content.end());
+
+  std::vector<char> compressed(compress_bound(input.size()));
+  size_t compressed_size = compress(input.data(),
+                                    input.size(),
+                                    compressed.data(),
+                                    compressed.size(),
+                                    1,
+                                    true,
+                                    false,
+                                    false,
+                                    dictionary);
+
+  std::string output(input.size(), '\0');
+  QCOMPARE(decompress(
+               compressed.data(), compressed_size, &output[0], output.size()),
+           INVALID_INPUT);
+  QCOMPARE(decompress(compressed.data(),
+                      compressed_size,
+                      &output[0],
+                      output.size(),
+                      1,
+                      dictionary),
+           input.size());
+  QCOMPARE(output, input);
+
+  // A version from the future
+  compressed[4] = CONTAINER_VERSION + 1;
+  QCOMPARE(decompress(compressed.data(),
+                      compressed_size,
+                      &output[0],
+                      output.size(),
+                      1,
+                      dictionary),
+           INVALID_INPUT);
+}
+
+void ParallelTest::testCase4() {
+  CompressionContext plain;
+  CompressionContext primed(4, true, true, true);
+  DecompressionContext decompression(4);
+
+  std::mt19937 generator(7);
+  std::vector<size_t> sizes = {3 * DEFAULT_CHUNK_SIZE, 100, 0,
+                               DEFAULT_CHUNK_SIZE + 1, 100};
+
+  for (size_t size : sizes) {
+    std::string input;
+    while (input.size() < size) {
+      input += "row " + std::to_string(generator() % 100) + ";";
+    }
+    input.resize(size);
+
+    // Contexts reused for sequences of other sizes and kinds give the same
+    // output as fresh ones
+    for (CompressionContext* context : {&plain, &primed}) {
+      std::vector<char> compressed(compress_bound(input.size()));
+      size_t compressed_size = context->compress(
+          input.data(), input.size(), compressed.data(), compressed.size());
+
+      std::vector<char> expected(compress_bound(input.size()));
+      size_t expected_size = context == &plain
+                                 ? compress(input.data(),
+                                            input.size(),
+                                            expected.data(),
+                                            expected.size())
+                                 : compress(input.data(),
+                                            input.size(),
+                                            expected.data(),
+                                            expected.size(),
+                                            4,
+                                            true,
+                                            true,
+                                            true);
+
+      QCOMPARE(compressed_size, expected_size);
+      QVERIFY(std::equal(compressed.begin(),
+                         compressed.begin() + compressed_size,
+                         expected.begin()));
+
+      std::string output(input.size(), '\0');
+      QCOMPARE(decompression.decompress(
+                   compressed.data(), compressed_size, &output[0], size),
+               size);
+      QCOMPARE(output, input);
+    }
+  }
+}
+
+void ParallelTest::testCase5() {
+  // Adaptive chunks are whole windows, a few windows at least and at most
+  // large enough to keep the per-chunk costs low
+  QCOMPARE(adaptive_chunk_size(0, 4), size_t(MIN_CHUNK_SIZE));
+  QCOMPARE(adaptive_chunk_size(size_t(1) << 40, 4),
+           size_t(128 * LZSS_WINDOW_SIZE));
+  QCOMPARE(adaptive_chunk_size(size_t(1) << 40, 4, 1 << 20),
+           size_t(128) << 20);
+  QCOMPARE(adaptive_chunk_size(4 << 20, 8), size_t(128 * 1024));
+  QCOMPARE(adaptive_chunk_size(1000000, 4) % LZSS_WINDOW_SIZE, size_t(0));
+
+  std::string input;
+  for (int i = 0; input.size() < 200000; ++i) {
+    input += "item " + std::to_string(i % 313) + ",";
+  }
+
+  // Chunks of other sizes than the default are recorded in the header
+  for (size_t chunk_size : {size_t(0), size_t(20000), size_t(100)}) {
+    std::vector<char> compressed(compress_bound(input.size()));
+    size_t size = compress(input.data(),
+                           input.size(),
+                           compressed.data(),
+                           compressed.size(),
+                           2,
+                           true,
+                           false,
+                           false,
+                           PresetDictionary<>(),
+                           chunk_size);
+    QVERIFY(size != OUTPUT_OVERFLOW);
+
+    ContainerHeader header;
+    const char* begin = compressed.data();
+    QVERIFY(header.read(begin, begin + size));
+    QVERIFY(header.flags & CONTAINER_CHUNK_SIZE);
+    QCOMPARE(size_t(header.chunk_size),
+             chunk_size ? std::max(chunk_size, size_t(MIN_CHUNK_SIZE))
+                        : adaptive_chunk_size(input.size(), 2));
+
+    std::string output(input.size(), '\0');
+    QCOMPARE(decompress(compressed.data(), size, &output[0], output.size()),
+             input.size());
+    QCOMPARE(output, input);
+  }
+}
+
+void ParallelTest::testCase6() {
+  std::mt19937 generator(3);
+  std::string input;
+  while (input.size() < 100000) {
+    input += "entry " + std::to_string(generator() % 1000) + "\n";
+  }
+
+  // A last chunk of random symbols, stored uncompressed
+  input.resize(input.size() / MIN_CHUNK_SIZE * MIN_CHUNK_SIZE);
+  for (size_t i = 0; i < MIN_CHUNK_SIZE; ++i) {
+    input += char(generator());
+  }
+
+  for (bool token_streams : {false, true}) {
+    std::vector<char> plain(compress_bound(input.size()));
+    size_t plain_size = compress(input.data(),
+                                 input.size(),
+                                 plain.data(),
+                                 plain.size(),
+                                 2,
+                                 true,
+                                 token_streams,
+                                 false,
+                                 PresetDictionary<>(),
+                                 MIN_CHUNK_SIZE);
+
+    std::vector<char> compressed(compress_bound(input.size()));
+    size_t size = compress(input.data(),
+                           input.size(),
+                           compressed.data(),
+                           compressed.size(),
+                           2,
+                           true,
+                           token_streams,
+                           false,
+                           PresetDictionary<>(),
+                           MIN_CHUNK_SIZE,
+                           true);
+
+    // A checksum of 4 bytes per chunk
+    ContainerHeader header;
+    const char* begin = compressed.data();
+    QVERIFY(header.read(begin, begin + size));
+    QVERIFY(header.has(CONTAINER_CHECKSUMS));
+    size_t chunks = (input.size() + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE;
+    QCOMPARE(size, plain_size + chunks * sizeof(uint32_t));
+
+    std::string output(input.size(), '\0');
+    QCOMPARE(decompress(compressed.data(), size, &output[0], output.size(), 2),
+             input.size());
+    QCOMPARE(output, input);
+
+    // A changed checksum, or a changed symbol of the last chunk
+    for (size_t offset : {size - 1, size - sizeof(uint32_t) - 1}) {
+      std::vector<char> corrupted = compressed;
+      corrupted[offset] ^= 0x20;
+      QCOMPARE(decompress(corrupted.data(), size, &output[0], output.size(), 2),
+               INVALID_INPUT);
+    }
+  }
+
+  // Files, deduplicated or not, are verified without being written
+  char root_template[] = "/tmp/parallel_test.XXXXXX";
+  std::string root = mkdtemp(root_template);
+  std::string path = root + "/input.txt";
+  std::string encoded = root + "/input.sdem";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << input << input;
+  }
+
+  for (bool deduplicate : {false, true}) {
+    encode_in_parallel(path.c_str(),
+                       encoded.c_str(),
+                       2,
+                       true,
+                       false,
+                       false,
+                       PresetDictionary<>(),
+                       false,
+                       0,
+                       MIN_CHUNK_SIZE,
+                       false,
+                       deduplicate,
+                       true);
+    QVERIFY(verify_in_parallel(encoded.c_str(), 2));
+
+    std::string content;
+    {
+      std::ifstream file(encoded, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+    }
+
+    content.back() ^= 1;
+    {
+      std::ofstream file(encoded, std::ios::binary);
+      file << content;
+    }
+    QVERIFY(!verify_in_parallel(encoded.c_str(), 2));
+  }
+
+  std::remove(path.c_str());
+  std::remove(encoded.c_str());
+  QCOMPARE(rmdir(root.c_str()), 0);
+}
+
+void ParallelTest::testCase7() {
+  std::mt19937 generator(7);
+  std::string input;
+  while (input.size() < 50000) {
+    input += "record " + std::to_string(generator() % 500) + "\n";
+  }
+
+  for (bool token_streams : {false, true}) {
+    std::vector<char> compressed(compress_bound(input.size()));
+    size_t size = compress(input.data(),
+                           input.size(),
+                           compressed.data(),
+                           compressed.size(),
+                           2,
+                           true,
+                           token_streams,
+                           false,
+                           PresetDictionary<>(),
+                           MIN_CHUNK_SIZE);
+    compressed.resize(size);
+
+    ContainerHeader header;
+    const char* begin = compressed.data();
+    QVERIFY(header.read(begin, begin + size));
+    size_t header_size = begin - compressed.data();
+
+    // Corrupted containers are rejected, or decoded to something else,
+    // without reading or writing out of bounds
+    DecompressionContext context(2);
+    std::string output(input.size(), '\0');
+
+    for (int i = 0; i < 200; ++i) {
+      std::vector<char> corrupted = compressed;
+      for (int j = 0; j < 1 + i % 4; ++j) {
+        size_t offset = header_size + generator() % (size - header_size);
+        corrupted[offset] ^= char(1 << generator() % 8);
+      }
+
+      size_t decoded = context.decompress(
+          corrupted.data(), size, &output[0], output.size());
+      QCOMPARE(decoded <= output.size(), context.error() == DECODE_OK);
+    }
+
+    // The container cut anywhere
+    for (size_t cut = 1; cut < size - header_size; cut += 97) {
+      size_t decoded = context.decompress(
+          compressed.data(), size - cut, &output[0], output.size());
+      QVERIFY(decoded != input.size());
+      QCOMPARE(decoded <= output.size(), context.error() == DECODE_OK);
+    }
+
+    QCOMPARE(context.decompress(
+                 compressed.data(), size, &output[0], output.size()),
+             input.size());
+    QCOMPARE(context.error(), DECODE_OK);
+    QCOMPARE(output, input);
+  }
+}
+
+QTEST_APPLESS_MAIN(ParallelTest)
+
+#include "parallel_test.moc"
@@ -0,0 +1,98 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include <iterator>
+#include "preset_dictionary.h"
+#include "splitter.h"
+#include "worker.h"
+#include "lzss_encoder.h"
+#include "lzss_decoder.h"
+#include "encoder_wrapper.h"
+#include "decoder_wrapper.h"
+#include "huffman_encoder_stack.h"
+#include "huffman_decoder_stack.h"
+
+typedef Worker<EncoderWrapper<LZSSEncoder<12, 4>>> EncoderW1;
+typedef HuffmanEncoderStack<char> EncoderW2;
+typedef Splitter<EncoderW1, EncoderW2, char, EncoderFrames> EncoderSplitter;
+typedef Splitter<HuffmanDecoderStack<char>,
+                 DecoderWrapper<LZSSDecoder<12, 4>>,
+                 char,
+                 DecoderFrames<EncoderW1, EncoderW2>> DecoderSplitter;
+
+static std::string record(int i) {
+  return "{\"event\": \"click\", \"user_id\": " + std::to_string(i * 7919) +
+         ", \"properties\": {\"page\": \"/product/" + std::to_string(i % 97) +
+         "\", \"browser\": \"firefox\"}}\n";
+}
+
+class PresetDictionaryTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void PresetDictionaryTest::testCase1() {
+  std::vector<PresetDictionary<>::sample_type> samples;
+  for (int i = 0; i < 100; ++i) {
+    std::string sample = record(i);
+    samples.emplace_back(sample.begin(), sample.end());
+  }
+
+  auto dictionary = PresetDictionary<>::train(samples, 1000);
+  QVERIFY(!dictionary.empty());
+  QVERIFY(dictionary.content().size() <= 1000);
+
+  std::string content(dictionary.content().begin(),
+                      dictionary.content().end());
+  QVERIFY(content.find("\"browser\": \"firefox\"") != std::string::npos);
+}
+
+void PresetDictionaryTest::testCase2() {
+  std::string content("some dictionary");
+  PresetDictionary<> dictionary(content.begin(), content.end());
+  PresetDictionary<> same(content.begin(), content.end());
+  PresetDictionary<> other(content.begin() + 1, content.end());
+
+  QCOMPARE(PresetDictionary<>().id(), 0u);
+  QVERIFY(dictionary.id() != 0);
+  QCOMPARE(dictionary.id(), same.id());
+  QVERIFY(dictionary.id() != other.id());
+}
+
+void PresetDictionaryTest::testCase3() {
+  std::vector<PresetDictionary<>::sample_type> samples;
+  for (int i = 0; i < 100; ++i) {
+    std::string sample = record(i);
+    samples.emplace_back(sample.begin(), sample.end());
+  }
+
+  auto dictionary = PresetDictionary<>::train(samples, max_size(12));
+  std::string input = record(1000);
+
+  std::vector<char> plain;
+  EncoderSplitter plain_encoder;
+  QVERIFY(plain_encoder(
+      input.begin(), input.end(), std::back_inserter(plain), 1, 1000));
+
+  std::vector<char> encoded;
+  EncoderSplitter encoder(0, dictionary.content());
+  QVERIFY(encoder(
+      input.begin(), input.end(), std::back_inserter(encoded), 1, 1000));
+
+  QVERIFY(encoded.size() < plain.size());
+
+  std::string decoded;
+  DecoderSplitter decoder(0, dictionary.content());
+  QVERIFY(decoder(
+      encoded.begin(), encoded.end(), std::back_inserter(decoded), 1, 1000));
+
+  QCOMPARE(decoded, input);
+}
+
+QTEST_APPLESS_MAIN(PresetDictionaryTest)
+
+#include "preset_dictionary_test.moc"
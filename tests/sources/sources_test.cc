@@ -0,0 +1,57 @@
+#include <QtTest>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sources.h"
+
+class SourcesTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+};
+
+void SourcesTest::testCase1() {
+  std::istringstream stream("abcdef");
+  StreamBufferIterator<char> begin(stream.rdbuf());
+  StreamBufferIterator<char> end;
+
+  QCOMPARE(*begin, 'a');
+  ++begin;
+
+  char block[8];
+  QCOMPARE(read_block(begin, end, block, 3), static_cast<size_t>(3));
+  QCOMPARE(std::string(block, 3), std::string("bcd"));
+
+  // Short at the end of the stream
+  QCOMPARE(read_block(begin, end, block, 8), static_cast<size_t>(2));
+  QCOMPARE(std::string(block, 2), std::string("ef"));
+  QVERIFY(begin == end);
+}
+
+void SourcesTest::testCase2() {
+  std::string input("abcdef");
+  const char* begin = input.data();
+  const char* end = begin + input.size();
+
+  char block[8];
+  QCOMPARE(read_block(begin, end, block, 4), static_cast<size_t>(4));
+  QCOMPARE(std::string(block, 4), std::string("abcd"));
+  QCOMPARE(read_block(begin, end, block, 4), static_cast<size_t>(2));
+  QVERIFY(begin == end);
+}
+
+void SourcesTest::testCase3() {
+  std::vector<char> input = {'x', 'y', 'z'};
+  auto begin = input.begin();
+
+  char block[4];
+  QCOMPARE(read_block(begin, input.end(), block, 4), static_cast<size_t>(3));
+  QCOMPARE(std::string(block, 3), std::string("xyz"));
+}
+
+QTEST_APPLESS_MAIN(SourcesTest)
+
+#include "sources_test.moc"
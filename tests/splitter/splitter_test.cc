@@ -0,0 +1,439 @@
+#include <QtTest>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <iterator>
+#include "splitter.h"
+#include "worker.h"
+#include "lzss_encoder.h"
+#include "lzss_decoder.h"
+#include "encoder_wrapper.h"
+#include "decoder_wrapper.h"
+#include "huffman_encoder_stack.h"
+#include "huffman_decoder_stack.h"
+
+typedef Worker<EncoderWrapper<LZSSEncoder<12, 4>>> EncoderW1;
+typedef HuffmanEncoderStack<char> EncoderW2;
+typedef Splitter<EncoderW1, EncoderW2, char, EncoderFrames> EncoderSplitter;
+typedef Splitter<HuffmanDecoderStack<char>,
+                 DecoderWrapper<LZSSDecoder<12, 4>>,
+                 char,
+                 DecoderFrames<EncoderW1, EncoderW2>> DecoderSplitter;
+typedef Splitter<HuffmanDecoderStack<char>,
+                 DecoderWrapper<LZSSDecoder<12, 4>>,
+                 char,
+                 DecoderFrames<EncoderW1, EncoderW2, false>>
+    UnsizedDecoderSplitter;
+
+static const size_t chunk_size = 16000;
+
+class SplitterTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+  void testCase3();
+  void testCase4();
+  void testCase5();
+  void testCase6();
+  void testCase7();
+  void testCase8();
+  void testCase9();
+};
+
+void SplitterTest::testCase1() {
+  std::string input;
+  for (int i = 0; i < 2000; ++i) {
+    input += "frame " + std::to_string(i % 31) + "\n";
+  }
+
+  std::vector<char> encoded;
+  EncoderSplitter encoder;
+  QVERIFY(encoder(input.begin(),
+                  input.end(),
+                  std::back_inserter(encoded),
+                  4,
+                  chunk_size));
+
+  QVERIFY(encoded.size() < input.size());
+  QCOMPARE(encoded[0], static_cast<char>(FRAME_COMPLETE));
+
+  std::string decoded;
+  DecoderSplitter decoder;
+  QVERIFY(decoder(encoded.begin(),
+                  encoded.end(),
+                  std::back_inserter(decoded),
+                  4,
+                  chunk_size));
+
+  QCOMPARE(decoded, input);
+}
+
+void SplitterTest::testCase2() {
+  std::mt19937 generator(42);
+  std::string input;
+  for (int i = 0; i < 50000; ++i) {
+    input += static_cast<char>(generator());
+  }
+
+  std::vector<char> encoded;
+  EncoderSplitter encoder;
+  QVERIFY(encoder(input.begin(),
+                  input.end(),
+                  std::back_inserter(encoded),
+                  4,
+                  chunk_size));
+
+  size_t chunks = (input.size() + chunk_size - 1) / chunk_size;
+  QCOMPARE(encoded.size(), input.size() + chunks * Frame<>::max_header_size);
+  QCOMPARE(encoded[0], static_cast<char>(FRAME_STORED));
+
+  std::string decoded;
+  DecoderSplitter decoder;
+  QVERIFY(decoder(encoded.begin(),
+                  encoded.end(),
+                  std::back_inserter(decoded),
+                  4,
+                  chunk_size));
+
+  QCOMPARE(decoded, input);
+}
+
+void SplitterTest::testCase3() {
+  std::string input(40000, 'a');
+
+  std::vector<char> encoded;
+  EncoderSplitter encoder;
+  encoder(
+      input.begin(), input.end(), std::back_inserter(encoded), 2, chunk_size);
+
+  encoded[0] = 42;
+
+  std::string decoded;
+  DecoderSplitter decoder;
+  QVERIFY(!decoder(encoded.begin(),
+                   encoded.end(),
+                   std::back_inserter(decoded),
+                   2,
+                   chunk_size));
+  QVERIFY(decoded.empty());
+}
+
+void SplitterTest::testCase4() {
+  std::mt19937 generator(7);
+  std::string block;
+  for (int i = 0; i < 3000; ++i) {
+    block += static_cast<char>(generator());
+  }
+
+  std::string input;
+  while (input.size() < 5 * chunk_size) {
+    input += block;
+  }
+
+  std::vector<char> plain;
+  EncoderSplitter plain_encoder;
+  QVERIFY(plain_encoder(
+      input.begin(), input.end(), std::back_inserter(plain), 4, chunk_size));
+
+  std::vector<char> primed;
+  EncoderSplitter primed_encoder(max_size(12));
+  QVERIFY(primed_encoder(
+      input.begin(), input.end(), std::back_inserter(primed), 4, chunk_size));
+
+  QVERIFY(primed.size() < plain.size());
+
+  std::string decoded;
+  DecoderSplitter decoder(max_size(12));
+  QVERIFY(decoder(primed.begin(),
+                  primed.end(),
+                  std::back_inserter(decoded),
+                  4,
+                  chunk_size));
+
+  QCOMPARE(decoded, input);
+}
+
+void SplitterTest::testCase5() {
+  std::string input;
+  for (int i = 0; i < 4000; ++i) {
+    input += "record " + std::to_string(i % 97) + ";";
+  }
+
+  std::vector<char> encoded;
+  EncoderSplitter encoder;
+  QVERIFY(encoder(
+      input.begin(), input.end(), std::back_inserter(encoded), 4, chunk_size));
+
+  // Drop the size of complete frames, as written by older versions
+  std::vector<char> unsized;
+  for (size_t i = 0; i < encoded.size();) {
+    size_t size;
+    std::memcpy(&size, &encoded[i + 1], sizeof(size));
+    size_t next = i + Frame<>::max_header_size + size;
+
+    if (encoded[i] == FRAME_COMPLETE) {
+      unsized.push_back(FRAME_COMPLETE);
+      unsized.insert(unsized.end(),
+                     encoded.begin() + i + Frame<>::max_header_size,
+                     encoded.begin() + next);
+    } else {
+      unsized.insert(
+          unsized.end(), encoded.begin() + i, encoded.begin() + next);
+    }
+
+    i = next;
+  }
+
+  QVERIFY(unsized.size() < encoded.size());
+
+  std::string decoded;
+  UnsizedDecoderSplitter decoder;
+  QVERIFY(decoder(unsized.begin(),
+                  unsized.end(),
+                  std::back_inserter(decoded),
+                  4,
+                  chunk_size));
+
+  QCOMPARE(decoded, input);
+}
+
+void SplitterTest::testCase6() {
+  std::mt19937 generator(5);
+  std::string input;
+  while (input.size() < 20 * chunk_size) {
+    input += "entry " + std::to_string(generator() % 500) + ",";
+  }
+
+  std::vector<char> expected;
+  EncoderSplitter encoder;
+  QVERIFY(encoder(
+      input.begin(), input.end(), std::back_inserter(expected), 4, chunk_size));
+
+  // Positioned sinks get the chunks at the same offsets
+  QVERIFY(is_positioned_sink<MemorySink<char>>::value);
+  QVERIFY(!is_positioned_sink<StreamSink<char>>::value);
+
+  std::vector<char> encoded(expected.size());
+  MemorySink<char> sink(encoded.data(), encoded.size());
+  QVERIFY(encoder.split(input.begin(), input.end(), sink, 4, chunk_size));
+  QVERIFY(!sink.overflow());
+  QCOMPARE(sink.size(), expected.size());
+  QVERIFY(encoded == expected);
+
+  MemorySink<char> short_sink(encoded.data(), encoded.size() - 1);
+  QVERIFY(encoder.split(input.begin(), input.end(), short_sink, 4, chunk_size));
+  QVERIFY(short_sink.overflow());
+
+  const char* path = "splitter_test.tmp";
+  {
+    FileSink<char> file_sink(path);
+    file_sink.reserve(2 * expected.size());
+    QVERIFY(encoder.split(
+        input.begin(), input.end(), file_sink, 4, chunk_size));
+    QVERIFY(file_sink.close());
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> written((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  file.close();
+  std::remove(path);
+  QVERIFY(written == expected);
+
+  std::string decoded(input.size(), '\0');
+  MemorySink<char> decoded_sink(&decoded[0], decoded.size());
+  DecoderSplitter decoder;
+  QVERIFY(decoder.split(
+      expected.begin(), expected.end(), decoded_sink, 4, chunk_size));
+  QCOMPARE(decoded, input);
+}
+
+void SplitterTest::testCase7() {
+  std::string input;
+  for (int i = 0; i < 6000; ++i) {
+    input += "value " + std::to_string(i % 211) + "\n";
+  }
+
+  std::vector<char> expected;
+  EncoderSplitter encoder;
+  QVERIFY(encoder(
+      input.begin(), input.end(), std::back_inserter(expected), 4, chunk_size));
+
+  // Pinned threads allocate the buffers and give the same output
+  std::vector<char> encoded;
+  EncoderSplitter pinned;
+  pinned.pin(2);
+  QVERIFY(pinned(
+      input.begin(), input.end(), std::back_inserter(encoded), 4, chunk_size));
+  QVERIFY(encoded == expected);
+
+  std::string decoded;
+  DecoderSplitter decoder;
+  decoder.pin(1);
+  QVERIFY(decoder(encoded.begin(),
+                  encoded.end(),
+                  std::back_inserter(decoded),
+                  3,
+                  chunk_size));
+  QCOMPARE(decoded, input);
+}
+
+// The frames of an encoded sequence
+static std::set<std::vector<char>> frames(const std::vector<char>& encoded) {
+  std::set<std::vector<char>> result;
+  for (size_t i = 0; i < encoded.size();) {
+    size_t size;
+    std::memcpy(&size, &encoded[i + 1], sizeof(size));
+    size_t next = i + Frame<>::max_header_size + size;
+
+    result.insert(std::vector<char>(encoded.begin() + i,
+                                    encoded.begin() + next));
+    i = next;
+  }
+
+  return result;
+}
+
+void SplitterTest::testCase8() {
+  std::mt19937 generator(11);
+  std::string input;
+  while (input.size() < 40 * chunk_size) {
+    input += "key " + std::to_string(generator() % 100000) + " ";
+  }
+
+  std::string edited = input;
+  edited.insert(100, "inserted");
+
+  std::vector<char> encoded;
+  std::vector<char> edited_encoded;
+  EncoderSplitter encoder;
+  encoder.cut_by_content(true);
+  QVERIFY(encoder(
+      input.begin(), input.end(), std::back_inserter(encoded), 4, chunk_size));
+  size_t chunks = encoder.chunks();
+  QVERIFY(encoder(edited.begin(),
+                  edited.end(),
+                  std::back_inserter(edited_encoded),
+                  4,
+                  chunk_size));
+
+  // Chunks are cut around half the chunk size
+  QVERIFY(chunks > input.size() / chunk_size);
+
+  // Only the chunks around the insertion change
+  std::set<std::vector<char>> before = frames(encoded);
+  size_t kept = 0;
+  for (const std::vector<char>& frame : frames(edited_encoded)) {
+    kept += before.count(frame);
+  }
+
+  QVERIFY(kept + 2 >= chunks);
+
+  std::string decoded;
+  DecoderSplitter decoder;
+  QVERIFY(decoder(edited_encoded.begin(),
+                  edited_encoded.end(),
+                  std::back_inserter(decoded),
+                  4,
+                  chunk_size));
+  QCOMPARE(decoded, edited);
+
+  // Fixed-size chunks all change
+  std::vector<char> fixed;
+  std::vector<char> edited_fixed;
+  EncoderSplitter fixed_encoder;
+  QVERIFY(fixed_encoder(
+      input.begin(), input.end(), std::back_inserter(fixed), 4, chunk_size));
+  QVERIFY(fixed_encoder(edited.begin(),
+                        edited.end(),
+                        std::back_inserter(edited_fixed),
+                        4,
+                        chunk_size));
+
+  before = frames(fixed);
+  kept = 0;
+  for (const std::vector<char>& frame : frames(edited_fixed)) {
+    kept += before.count(frame);
+  }
+
+  QCOMPARE(kept, size_t(0));
+}
+
+void SplitterTest::testCase9() {
+  std::mt19937 generator(13);
+  std::vector<std::string> blocks(3);
+  for (std::string& block : blocks) {
+    while (block.size() < chunk_size) {
+      block += "word" + std::to_string(generator() % 5000) + " ";
+    }
+    block.resize(chunk_size);
+  }
+
+  std::string input;
+  for (int i = 0; i < 30; ++i) {
+    input += blocks[generator() % blocks.size()];
+  }
+  input += "tail";
+
+  for (size_t dictionary_size : {size_t(0), max_size(12)}) {
+    std::vector<char> plain;
+    EncoderSplitter plain_encoder(dictionary_size);
+    QVERIFY(plain_encoder(
+        input.begin(), input.end(), std::back_inserter(plain), 4, chunk_size));
+
+    // Repeated chunks are written as references
+    std::vector<char> encoded;
+    EncoderSplitter encoder(dictionary_size);
+    encoder.deduplicate(true);
+    QVERIFY(encoder(input.begin(),
+                    input.end(),
+                    std::back_inserter(encoded),
+                    4,
+                    chunk_size));
+    QVERIFY(encoded.size() * 2 < plain.size());
+
+    size_t references = 0;
+    for (size_t i = 0; i < encoded.size();) {
+      size_t size;
+      std::memcpy(&size, &encoded[i + 1], sizeof(size));
+      references += encoded[i] == FRAME_REFERENCE;
+      i += Frame<>::max_header_size + size;
+    }
+    QVERIFY(references >= 10);
+
+    std::string decoded;
+    DecoderSplitter decoder(dictionary_size);
+    decoder.deduplicate(true);
+    QVERIFY(decoder(encoded.begin(),
+                    encoded.end(),
+                    std::back_inserter(decoded),
+                    4,
+                    chunk_size));
+    QCOMPARE(decoded, input);
+
+    std::string positioned(input.size(), '\0');
+    MemorySink<char> sink(&positioned[0], positioned.size());
+    QVERIFY(
+        decoder.split(encoded.begin(), encoded.end(), sink, 3, chunk_size));
+    QCOMPARE(positioned, input);
+
+    // References are invalid unless the decoder resolves them
+    std::string undecoded;
+    DecoderSplitter plain_decoder(dictionary_size);
+    QVERIFY(!plain_decoder(encoded.begin(),
+                           encoded.end(),
+                           std::back_inserter(undecoded),
+                           4,
+                           chunk_size));
+  }
+}
+
+QTEST_APPLESS_MAIN(SplitterTest)
+
+#include "splitter_test.moc"
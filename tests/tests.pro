@@ -10,4 +10,20 @@ SUBDIRS += \
     bit_reader \
     lz77_decoder \
     lzss_encoder \
-    lzss_decoder
+    lzss_decoder \
+    lzss_stream_decoder \
+    lzss_grouped_decoder \
+    splitter \
+    entropy \
+    huffman_header \
+    preset_dictionary \
+    parallel \
+    executor \
+    sources \
+    async_io \
+    topology \
+    chunker \
+    dedup \
+    archive \
+    checksum \
+    incremental_decoder
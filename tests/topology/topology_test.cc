@@ -0,0 +1,42 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include "topology.h"
+
+class TopologyTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testCase1();
+  void testCase2();
+};
+
+void TopologyTest::testCase1() {
+  QCOMPARE(Topology::parse_cpu_list("0-3,8,10-11"),
+           std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  QCOMPARE(Topology::parse_cpu_list("5\n"), std::vector<int>({5}));
+  QVERIFY(Topology::parse_cpu_list("").empty());
+
+  // Malformed lists
+  QVERIFY(Topology::parse_cpu_list("3-1").empty());
+  QVERIFY(Topology::parse_cpu_list("0-").empty());
+  QVERIFY(Topology::parse_cpu_list("a").empty());
+}
+
+void TopologyTest::testCase2() {
+  const Topology& topology = Topology::get();
+  QVERIFY(topology.nodes() > 0);
+
+  for (size_t node = 0; node < topology.nodes(); ++node) {
+    QVERIFY(!topology.cpus(node).empty());
+  }
+
+  // Threads fill each node in turn, then start over
+  for (size_t thread = 0; thread < 8; ++thread) {
+    QCOMPARE(topology.node(thread, 2), thread / 2 % topology.nodes());
+  }
+}
+
+QTEST_APPLESS_MAIN(TopologyTest)
+
+#include "topology_test.moc"